@@ -118,14 +118,29 @@ classdef Experiment < dynamicprops
    end
   end
 
-  function invert_laplace ( self )
+  function invert_laplace ( self, budget )
+   % each point starts from the solution of the previous one, taken
+   % onto its own tau grid by DLS.Point.warm_start,
+   % budget (optional) bounds each solve, see DLS.Point.invert_laplace
+   if nargin < 2
+    budget = [];
+   end
+   previous = [];
    for i = 1 : length( self.Point )
     fprintf([num2str(i) ': ']);
-    self.Point(i).invert_laplace;
+    self.Point(i).invert_laplace( previous, budget );
+    previous = self.Point(i).CONTIN;
     fprintf('\n');
    end
   end
 
+  function resolve_laplace ( self )
+   % finishes the solves that hit their budget
+   for i = 1 : length( self.Point )
+    self.Point(i).resolve_laplace();
+   end
+  end
+
   function cn = coeffnames ( self, method )
    cn	= coeffnames(self.Point(1).(['Fit_' method]));
   end
@@ -84,7 +84,7 @@ methods ( Static )
 
     fit_obj   = fit_discrete ( t, g, dg, method, q, protein);
     fit_obj   = fit_discrete_raw ( t, g, dg, method, q, protein);
-    [s, g, b] = contin  ( t, y, var, s0, s1, m, alpha, kernel);
+    [s, g, b, info] = contin  ( t, y, var, s0, s1, m, alpha, kernel, grid, opts);
     [ s g ]   = contin2 ( t, gt, dg, smin, smax, m, alpha, cycles );
 
 end
@@ -105,10 +105,62 @@ methods
         self.(['Fit_' method])	= fit_obj;
     end
 
-    function invert_laplace ( self )
+    function invert_laplace ( self, previous, budget )
+    % previous (optional) is the CONTIN result of a neighbouring point,
+    % its distribution starts the minimizer instead of a flat one, moved
+    % onto this point's tau grid if that differs, see warm_start
+    % budget (optional) is a struct with the fields deadline (seconds),
+    % nmax or stall of contin, for live processing; CONTIN.Resolve marks
+    % a result cut by the budget, see resolve_laplace. A field bootstrap = R
+    % also solves R noisy replicates and stores the quantile bands of Gs
+    % (columns for levels, default [0.025 0.5 0.975]) and of the peak
+    % positions in CONTIN.Band, CONTIN.Peaks, CONTIN.PeakBand, CONTIN.Spread
+
+        [ t, y, dy ] = self.reduce_laplace();
+
+        % PART 3: PERFORM INVERSE LAPLACE TRANSFORM
+        %  s = self.contin2(t, y, dy, min(t), max(t), 15*N, 0.1, 1); %%% output controllare !!!
+        % the tau grid contin builds below, linear from min(t) to max(t)
+        m  = 10*length(t);
+        s0 = min(t) + (0 : m-1)' * (max(t) - min(t)) / (m - 1);
+
+        opts = struct();
+        if nargin > 1 && ~isempty(previous)
+            opts.g0 = self.warm_start( previous, s0 );
+            opts.b0 = previous.B;
+        end
+        if nargin > 2 && ~isempty(budget)
+            for f = fieldnames(budget)'
+                opts.(f{1}) = budget.(f{1});
+            end
+        end
+        % contin takes the variance of y, its weights and bootstrap noise follow from dy.^2
+        [ s, gs, bs, info ]= self.contin(t, y, dy.^2, min(t), max(t), m, 0.15, 0, 0, opts);
+        self.store_laplace( s, gs, bs, info );
+    end
+
+    function g0 = warm_start ( ~, previous, s )
+    % the distribution of a previous result on the tau grid s, as is if it
+    % was solved on the same grid, otherwise interpolated in ln(s) and zero
+    % outside the previous grid
+        S = previous.S(:);
+        if numel(S) == numel(s) && max(abs(S - s)) <= 1e-12 * max(abs(s))
+            g0 = previous.Gs;
+        else
+            g0 = interp1(log(S), previous.Gs(:), log(s), 'linear', 0);
+        end
+    end
+
+    function [ t, y, dy ] = reduce_laplace ( self, all_lags )
+    % PART 1 and 2 of invert_laplace, the amplitude y = sqrt(G) and its
+    % error on N windows of the lags; all_lags (optional) keeps the lags
+    % with G <= 0 as well, so that every count of an angle gives the same t
 
    % PART 1: FILTER THE DATA
-        ind = ( self.Tau > 1e-3 & self.Tau < 50 & self.G > 0 );
+        ind = ( self.Tau > 1e-3 & self.Tau < 50 );
+        if nargin < 2 || ~all_lags
+            ind = ind & self.G > 0;
+        end
         Tau = self.Tau(ind);
         G   = self.G(ind);
         dG  = self.dG(ind);
@@ -126,18 +178,36 @@ methods
             dgt(i) = mean( dG(ind) );
         end
 
-        y  = sqrt(gt);
-        dy = 0.5 ./ y .* dgt;
+        y  = sqrt(max(gt, 0));
+        dy = 0.5 ./ max(y, eps) .* dgt;
+    end
 
-        % PART 3: PERFORM INVERSE LAPLACE TRANSFORM
-        %  s = self.contin2(t, y, dy, min(t), max(t), 15*N, 0.1, 1); %%% output controllare !!!
-        [ s, gs, bs ]= self.contin(t, y, dy, min(t), max(t), 10*N, 0.15, 0);
+    function store_laplace ( self, s, gs, bs, info )
+    % keeps a CONTIN result in the CONTIN property
         D = 1e-6 ./ ( self.Q^2 * s );
 
         try   self.addprop('CONTIN'); end % maybe it is already a property
         self.CONTIN.S  = s;
         self.CONTIN.D  = D;
         self.CONTIN.Gs = gs;
+        self.CONTIN.B  = bs;
+        self.CONTIN.Iterations = info.iterations;
+        self.CONTIN.Status     = info.status;
+        self.CONTIN.Resolve    = info.resolve;
+        if isfield(info, 'band')
+            self.CONTIN.Band     = info.band;
+            self.CONTIN.Peaks    = info.peaks;
+            self.CONTIN.PeakBand = info.peak_band;
+            self.CONTIN.Spread   = info.spread;
+        end
+    end
+
+    function resolve_laplace ( self )
+    % re-solves without budget a result that invert_laplace flagged,
+    % starting from it, e.g. once the acquisition is over
+        if isprop(self, 'CONTIN') && isfield(self.CONTIN, 'Resolve') && self.CONTIN.Resolve
+            self.invert_laplace( self.CONTIN );
+        end
     end
 end
 
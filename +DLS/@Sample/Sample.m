@@ -176,12 +176,84 @@ methods
             self.Point(i).fit_raw( model );
         end
     end
-    function invert_laplace ( self )
+    function invert_laplace ( self, budget )
+        % each point starts from the solution of the previous one, taken
+        % onto its own tau grid by DLS.Point.warm_start,
+        % budget (optional) bounds each solve, see DLS.Point.invert_laplace
+        if nargin < 2
+            budget = [];
+        end
+        previous = [];
         for i = 1 : length( self.Point )
             fprintf([num2str(i) ': ']);
-            self.Point(i).invert_laplace;
+            self.Point(i).invert_laplace( previous, budget );
+            previous = self.Point(i).CONTIN;
+            fprintf('\n');
+        end
+    end
+    function invert_laplace_pooled ( self, alpha )
+        % one solve per angle on the pooled counts of that angle, each
+        % count only adds its sums to the handle of the angle, see
+        % contin('add', ...); the result is stored in every count
+        if nargin < 2
+            alpha = 0.15;
+        end
+        nc = self.number_of_counts;
+        for a = 1 : nc : length( self.Point )
+            fprintf([num2str(a) ': ']);
+            [ t, y, dy ] = self.Point(a).reduce_laplace( true );
+            h = DLS.Point.contin('create', t, min(t), max(t), 10*length(t), 0, 0);
+            for i = a : a + nc - 1
+                [ ~, y, dy ] = self.Point(i).reduce_laplace( true );
+                DLS.Point.contin('add', h, y, dy.^2);
+            end
+            [ s, gs, bs, info ] = DLS.Point.contin('pooled', h, alpha);
+            DLS.Point.contin('destroy', h);
+            for i = a : a + nc - 1
+                self.Point(i).store_laplace( s, gs, bs, info );
+            end
             fprintf('\n');
         end
     end
+    function invert_laplace_global ( self, alpha, m )
+        % one solve for all points together, a single distribution of D
+        % on a logarithmic grid with an amplitude and a baseline per
+        % point, see contin('global', ...); every point stores the common
+        % distribution scaled by its amplitude, CONTIN.Amplitude holds it
+        if nargin < 2
+            alpha = 0.15;
+        end
+        if nargin < 3
+            m = 60;
+        end
+        np = length( self.Point );
+        T  = cell(1, np);
+        Y  = cell(1, np);
+        DY = cell(1, np);
+        Q  = self.Qv();
+        for i = 1 : np
+            [ T{i}, Y{i}, DY{i} ] = self.Point(i).reduce_laplace();
+        end
+        tmin = min( cellfun(@min, T) );
+        tmax = max( cellfun(@max, T) );
+        D0   = 1e-6 / ( max(Q)^2 * tmax );
+        D1   = 1e-6 / ( min(Q)^2 * tmin );
+
+        opts = struct('solver', 'nnls');
+        VAR  = cellfun(@(dy) dy.^2, DY, 'UniformOutput', false);
+        [ D, g, a, b, info ] = DLS.Point.contin('global', T, Y, VAR, 1e6 * Q.^2, D0, D1, m, alpha, opts);
+        fprintf('\n');
+        for i = 1 : np
+            s = 1e-6 ./ ( Q(i)^2 * D );
+            self.Point(i).store_laplace( s, a(i) * g, b(i), info );
+            self.Point(i).CONTIN.Amplitude = a(i);
+        end
+    end
+    function resolve_laplace ( self )
+        % finishes the solves that hit their budget
+        for i = 1 : length( self.Point )
+            self.Point(i).resolve_laplace();
+        end
+    end
 end
 end
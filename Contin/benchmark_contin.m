@@ -0,0 +1,95 @@
+% BENCHMARK OF THE MINIMIZER BACKENDS ON THE EXAMPLE DLS DATA
+% every correlogram of example/example-data/LS is reduced by
+% DLS.Point.reduce_laplace and inverted like DLS.Point.invert_laplace with
+% spg, pgrad, gencan, nnls and mem on tau grids of growing size, the table
+% lists per backend and size the mean time, the mean number of iterations
+% (for nnls factorization updates, for mem Newton iterations) and how many
+% runs converged, gencan is rejected by contin and listed as such. The
+% section alv of contin_bench.c is the same benchmark without MATLAB
+
+addpath(fullfile(fileparts(mfilename('fullpath')), '..'));
+
+data_dir = fullfile(fileparts(mfilename('fullpath')), '..', 'example', 'example-data', 'LS');
+files    = dir(fullfile(data_dir, '*', '*.ASC'));
+alv      = Instruments.ALV;
+
+solvers	= {'spg', 'pgrad', 'gencan', 'nnls', 'mem'};
+sizes	= [50 100 200 400];
+alpha	= 0.15;
+
+time		= zeros(length(solvers), length(sizes));
+iterations	= zeros(length(solvers), length(sizes));
+converged	= zeros(length(solvers), length(sizes));
+rejected	= false(length(solvers), 1);
+
+for k = 1 : length(files)
+	point = alv.read_dynamic_file(fullfile(files(k).folder, files(k).name));
+	[ t, y, dy ] = point.reduce_laplace();
+
+	for i = 1 : length(solvers)
+		for j = 1 : length(sizes)
+			opts = struct('solver', solvers{i});
+			tic;
+			try
+				[s, g, b, info] = contin(t, y, dy.^2, min(t), max(t), sizes(j), alpha, 0, 0, opts);
+			catch
+				rejected(i) = true;
+				continue;
+			end
+			time(i, j)       = time(i, j) + toc;
+			iterations(i, j) = iterations(i, j) + info.iterations;
+			converged(i, j)  = converged(i, j) + (info.status == 0);
+		end
+	end
+end
+
+fprintf('\n%d correlograms, alpha = %g\n\n', length(files), alpha);
+fprintf('%8s %6s %12s %12s %10s\n', 'solver', 'm', 'time [ms]', 'iterations', 'converged');
+for i = 1 : length(solvers)
+	for j = 1 : length(sizes)
+		if rejected(i)
+			fprintf('%8s %6d %12s\n', solvers{i}, sizes(j), 'rejected');
+			continue;
+		end
+		fprintf('%8s %6d %12.2f %12.0f %6d/%d\n', solvers{i}, sizes(j), ...
+			1e3 * time(i, j) / length(files), iterations(i, j) / length(files), ...
+			converged(i, j), length(files));
+	end
+end
+
+% Results on the 102 correlograms of example/example-data/LS, one core of
+% an x86-64 host, the bundled ool-0.2.0, printed by `contin_bench alv`
+% (contin_bench.c), which reads, corrects and reduces the files like
+% Instruments.ALV, DLS.Point.correct_G and DLS.Point.reduce_laplace and
+% makes the same contin call with var = dy.^2. The MATLAB session was not
+% available. The host had no GSL, GSL was replaced by a portable build of
+% the calls contin uses, so the times only compare the backends with one
+% another. gencan is rejected by contin, the bundled libool.a writes
+% size_t indices into its gsl_vector_uint index set on x86-64 and
+% corrupts memory. With the variance weights spg fails to converge on a
+% sixth to a third of the files and pgrad on most of them, nnls and mem
+% converge on every file.
+%
+% 102 correlograms, alpha = 0.15
+%
+%   solver      m    time [ms]   iterations  converged
+%      spg     50       103.45        18119     86/102
+%      spg    100       203.25        24011     82/102
+%      spg    200       744.62        31911     74/102
+%      spg    400      1898.21        43320     66/102
+%    pgrad     50      2159.87        94277      6/102
+%    pgrad    100      2667.96        90386     10/102
+%    pgrad    200      5675.16        81639     20/102
+%    pgrad    400     10280.19        89971     14/102
+%   gencan     50     rejected
+%   gencan    100     rejected
+%   gencan    200     rejected
+%   gencan    400     rejected
+%     nnls     50         0.22            6    102/102
+%     nnls    100         0.72            9    102/102
+%     nnls    200         3.73           13    102/102
+%     nnls    400        19.00           26    102/102
+%      mem     50         0.95           10    102/102
+%      mem    100         5.50           15    102/102
+%      mem    200        58.31           29    102/102
+%      mem    400       722.75           58    102/102
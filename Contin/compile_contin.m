@@ -1,3 +1,3 @@
 %change -I_folder to include folders in which have been installed ool and
 %gsl
-mex -I/usr/local/include -lool -lgsl -lgslcblas -lm contin.c
+mex -I/usr/local/include -lool -lgsl -lgslcblas -lm -lpthread contin.c contin_nnls.c contin_alpha.c contin_batch.c contin_handle.c contin_kernel.c contin_skyline.c contin_hmatrix.c contin_reduced.c contin_multires.c contin_threads.c contin_bootstrap.c contin_accumulate.c contin_mem.c contin_global.c contin_fixed.cpp
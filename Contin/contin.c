@@ -41,8 +41,10 @@
 
 #include <stdio.h>
 #include <math.h>
-#include <ool/ool_conmin.h>
-#include <gsl/gsl_matrix.h>
+#include <string.h>
+#include <time.h>
+#include <gsl/gsl_linalg.h>
+#include "contin.h"
         
 /*
 ------------------------------------------------------------------------------
@@ -97,456 +99,1255 @@ void example(gsl_vector* intensity,
 /*
 ------------------------------------------------------------------------------
 
- parameter struct for optimazation routine 
+ scratch space for fun, fun_df, fun_fdf and fun_Hv
 
 ------------------------------------------------------------------------------
 */
 
-typedef struct 
+workspace* workspace_alloc(int n, int m)
 {
-	gsl_matrix* K;		/* matrix for integration kernel */
-	gsl_vector* y;		/* y-axis of observed data */
-	gsl_vector* t;		/* t-axis of observed data */
-	gsl_vector* tau;	/* tau-axis for time constants */
-	gsl_vector* w;		/* weights for euclidian norm */
-	gsl_vector* c;		/* weights due to numerical intergration */
-	double alpha;		/* strenght of regularizer */
+	workspace* ws = malloc(sizeof(workspace));
 	
-} parameter;
+	ws -> r   = gsl_vector_alloc( n );
+	ws -> d2g = gsl_vector_alloc( m );
+	ws -> d4g = gsl_vector_alloc( m );
+	ws -> part = NULL;
+	ws -> um   = NULL;
+	ws -> un   = NULL;
+	
+	/* a dense product of this size is split, see parameter_matvec */
+	if ((size_t) n * m >= PARALLEL_MIN)
+		ws -> part = gsl_matrix_alloc( (n + PARALLEL_ROWS - 1) / PARALLEL_ROWS, m );
+	ws -> neval  = 0;
+	
+	return ws;
+}
+
+void workspace_free(workspace* ws)
+{
+	if ( ws->r ) gsl_vector_free( ws->r );
+	if ( ws->d2g ) gsl_vector_free( ws->d2g );
+	if ( ws->d4g ) gsl_vector_free( ws->d4g );
+	if ( ws->part ) gsl_matrix_free( ws->part );
+	if ( ws->um ) gsl_vector_free( ws->um );
+	if ( ws->un ) gsl_vector_free( ws->un );
+	free(ws);
+}
 
 /*
 ------------------------------------------------------------------------------
 
- allocate memory for parameter-struct entries and intialize 
- kernel K, tau, ... etc
+ tau grids and their quadrature weights
+ 
+ GRID_LINEAR: tau(j) = tau0 + j*dtau, integral over dtau
+ GRID_LOG:    ln(tau(j)) equidistant, integral over d(ln tau), i.e. g is the 
+              distribution per unit of ln(tau) as in contin2.m
 
 ------------------------------------------------------------------------------
 */
 
-parameter* parameter_alloc(gsl_vector* t, 
-						    gsl_vector* y,
-						    gsl_vector* var,
-						    double alpha,
-						    double tau0,
-						    double tau1,
-						    int m,
-							int kernelType)
+void tau_grid(double tau0, double tau1, int gridType, gsl_vector* tau)
 {
-	parameter* p = malloc(sizeof(parameter));
-	int n = t->size;
-	
-	p -> K   = gsl_matrix_alloc( n, m );
-	p -> w   = gsl_vector_alloc( n );
-	p -> c   = gsl_vector_alloc( m );
-	p -> y   = gsl_vector_alloc( n );
-	p -> tau = gsl_vector_alloc( m );
-	p -> t = gsl_vector_alloc( n );
-	
-	p -> alpha = alpha;
+	int m = tau->size;
+	int j;
 	
-	double dtau = (tau1 - tau0) / (m - 1);
-	int i, j;
-	
-	gsl_vector_memcpy(p->y, y);
-	gsl_vector_memcpy(p->t, t);
-	
-	for (j = 0; j < m; j++)
-		gsl_vector_set(p->tau, j, tau0 + j * dtau);
-	
-	for (i = 0; i < n; i++)
+	if (gridType == GRID_LOG)
 	{
+		double dlntau = log(tau1 / tau0) / (m - 1);
 		for (j = 0; j < m; j++)
-		{
-			if (kernelType == 0)
-			{
-				// multi-exponential
-				gsl_matrix_set(p->K, i, j, exp(-gsl_vector_get(p->t,i) / gsl_vector_get(p->tau, j)));
-			}
-			else if (kernelType == 1)
-			{
-				// multi-lorentzian
-				gsl_matrix_set(p->K, i, j, M_1_PI *  gsl_vector_get(p->tau, j) / (sqr(gsl_vector_get(p->t, i)) + sqr(gsl_vector_get(p->tau, j))));
-				
-			}
-		}
-		gsl_vector_set(p->w, i, 1.0 / gsl_vector_get(var, i));
-	}		
-	
-	/* 
-	 weights for quadrature of integral, trapezoidal rule 
-	*/
-	for (j = 0; j < m; j++)
+			gsl_vector_set(tau, j, tau0 * exp(j * dlntau));
+	}
+	else
 	{
-		if(j == 0 || j == m - 1)
-			gsl_vector_set(p->c, j, 0.5 * dtau);
-		else
-			gsl_vector_set(p->c, j, dtau);
+		double dtau = (tau1 - tau0) / (m - 1);
+		for (j = 0; j < m; j++)
+			gsl_vector_set(tau, j, tau0 + j * dtau);
 	}
-	return p;
 }
 
 /*
 ------------------------------------------------------------------------------
 
- release allocated memory for parameter struct
+ weights for quadrature of integral, trapezoidal rule in u = tau (linear) or 
+ u = ln(tau) (log), valid for arbitrary, also non-equidistant grids
 
 ------------------------------------------------------------------------------
 */
 
-void parameter_free(parameter* p)
+void quadrature_weights(const gsl_vector* tau, int gridType, gsl_vector* c)
 {
-	if ( p->K ) gsl_matrix_free( p->K );
-	if ( p->w ) gsl_vector_free( p->w );
-	if ( p->c ) gsl_vector_free( p->c );
-	if ( p->y ) gsl_vector_free( p->y );
-	if ( p->t ) gsl_vector_free( p->t );
-	if ( p->tau ) gsl_vector_free( p->tau );
-	free(p);
+	int m = tau->size;
+	int j;
+	double u0, u1;
+	
+	gsl_vector_set_zero(c);
+	for (j = 0; j < m - 1; j++)
+	{
+		u0 = gsl_vector_get(tau, j);
+		u1 = gsl_vector_get(tau, j + 1);
+		if (gridType == GRID_LOG)
+		{
+			u0 = log(u0);
+			u1 = log(u1);
+		}
+		*gsl_vector_ptr(c, j)     += 0.5 * (u1 - u0);
+		*gsl_vector_ptr(c, j + 1) += 0.5 * (u1 - u0);
+	}
 }
 
 /*
 ------------------------------------------------------------------------------
 
- discrete 2nd derivative of g
-
-------------------------------------------------------------------------------
-*/
- 
-void diff2(const gsl_vector *x, gsl_vector * ddg)
-{
-	int i;
-	for (i = 1; i < ddg->size - 1; i++)
-		gsl_vector_set(ddg, i, gsl_vector_get(x, i - 1) - 2 * gsl_vector_get(x, i) + gsl_vector_get(x, i + 1));
-		
-	gsl_vector_set(ddg, 0, - 2 * gsl_vector_get(x, 0) + gsl_vector_get(x, 1));
-	gsl_vector_set(ddg,  ddg->size - 1, gsl_vector_get(x, ddg->size - 2) - 2 * gsl_vector_get(x, ddg->size - 1));
-}
+ a large kernel is built in independent blocks of PARALLEL_ROWS rows on 
+ the worker pool, each block restarts the recurrence of kernel_build
 
-/*
-------------------------------------------------------------------------------
- z = A*g + b 
- f(g, b) = |y - z|^2 + a^2*|D2g|^2
- x = (g, b)
 ------------------------------------------------------------------------------
 */
 
-double fun(const gsl_vector* x, void* params)
+typedef struct
 {
-	parameter* p = (parameter*) params;
-	
-	int n = p->y->size;
-	int m = x->size - 1;
-		
-	gsl_vector* d2g = gsl_vector_alloc(m);
-	
-	/* x= (g,b), diff2 acts only on the g-part of x*/
-	diff2(x, d2g);
+	gsl_matrix* K;
+	const gsl_vector* t;
+	const gsl_vector* tau;
+	int kernelType;
 	
-	/*
-	 integral operation, A is the kernel discretization
-	 and c are the weights of the quadrature formula
-	*/
-	
-	int i, j;
-	double var = 0;
-	double reg = 0;
-	double z;
-	double b = gsl_vector_get(x, m);
+} kernel_task;
+
+static void kernel_chunk(void* arg, size_t c)
+{
+	kernel_task* kt = (kernel_task*) arg;
+	size_t i0 = c * PARALLEL_ROWS;
+	size_t ni = GSL_MIN(PARALLEL_ROWS, kt->K->size1 - i0);
 	
-	for (i = 0; i < n; i++)
+	gsl_matrix_view Kc = gsl_matrix_submatrix(kt->K, i0, 0, ni, kt->K->size2);
+	gsl_vector_const_view tc = gsl_vector_const_subvector(kt->t, i0, ni);
+	kernel_build(&Kc.matrix, &tc.vector, kt->tau, kt->kernelType);
+}
+
+static void kernel_build_chunked(gsl_matrix* K, const gsl_vector* t, const gsl_vector* tau, int kernelType)
+{
+	if (K->size1 * K->size2 < PARALLEL_MIN)
 	{
-		z = b;
-		for (j = 0; j < m ; j++)
-			z += gsl_vector_get(p->c, j) * gsl_matrix_get(p->K, i, j) * gsl_vector_get(x, j);
-		var += gsl_vector_get(p->w, i) * sqr(gsl_vector_get(p->y, i) - z );
+		kernel_build(K, t, tau, kernelType);
+		return;
 	}
 	
-	/* regularizer, second derivative of g*/
-	for (i = 0; i < m; i++)
-		reg += sqr(gsl_vector_get(d2g, i));
-	
-	/* 
-	 free memory
-	*/
-	gsl_vector_free( d2g  );
-	
-	return var + p->alpha * p->alpha * reg;
+	kernel_task kt = { K, t, tau, kernelType };
+	parallel_chunks((K->size1 + PARALLEL_ROWS - 1) / PARALLEL_ROWS, kernel_chunk, &kt);
 }
 
 /*
 ------------------------------------------------------------------------------
 
- gradient of f(g, b) = |y - A*g+b|^2 + a^2*|Pg|^2
- x = (g, b)
+ allocate memory for parameter-struct entries and intialize the kernel K 
+ and the quadrature weights for a given tau grid, everything that depends 
+ on the data is left to parameter_set_data
+
+ htol > 0 builds the hierarchical kernel Kh and ktol > 0 the skyline Ks 
+ directly from t and tau instead, see contin_hmatrix.c and 
+ contin_skyline.c, the dense K and A are never allocated and the Gram 
+ matrix is formed once from the blocks when the data are set
 
 ------------------------------------------------------------------------------
 */
 
-void fun_df(const gsl_vector *x, void* params, gsl_vector *grad)
+parameter* parameter_alloc_kernel(gsl_vector* t, 
+								  double alpha,
+								  const gsl_vector* tau,
+								  int gridType,
+								  int kernelType,
+								  double ktol,
+								  double htol)
 {
-	parameter* p = (parameter*) params;
+	parameter* p = malloc(sizeof(parameter));
+	int n = t->size;
+	int m = tau->size;
 	
-	int n = p->y->size;
-	int m = x->size - 1;
-		
-	gsl_vector* z   = gsl_vector_alloc( n );
-	gsl_vector* d2g = gsl_vector_alloc( m );
-	gsl_vector* d4g = gsl_vector_alloc( m );
+	p -> K   = NULL;
+	p -> w   = gsl_vector_calloc( n );
+	p -> c   = gsl_vector_alloc( m );
+	p -> y   = gsl_vector_alloc( n );
+	p -> tau = gsl_vector_alloc( m );
+	p -> t = gsl_vector_alloc( n );
+	p -> A   = NULL;
+	p -> sw  = gsl_vector_alloc( n );
+	p -> swy = gsl_vector_alloc( n );
+	p -> G   = gsl_matrix_alloc( m + 1, m + 1 );
+	p -> H   = gsl_matrix_alloc( m + 1, m + 1 );
+	p -> ws  = workspace_alloc( n, m );
+	p -> sf  = NULL;
+	p -> rd  = NULL;
+	p -> Ks  = NULL;
+	p -> As  = NULL;
+	p -> Kh  = NULL;
+	p -> Ah  = NULL;
+	p -> Af  = NULL;
 	
-	diff2(x,   d2g);
-	diff2(d2g, d4g);
+	p -> alpha = alpha;
 	
-	int i, j;
-	double zi;
-	double b = gsl_vector_get(x, m);
+	gsl_vector_memcpy(p->t, t);
+	gsl_vector_memcpy(p->tau, tau);
 	
-	for (i = 0; i < n; i++)
+	// multi-exponential or multi-lorentzian, see contin_kernel.c
+	if (htol > 0)
 	{
-		zi = b;
-		for (j = 0; j < m; j++)
-			zi += gsl_vector_get(p->c, j) * gsl_matrix_get(p->K, i, j) * gsl_vector_get(x, j);
-		gsl_vector_set(z, i, zi);
+		p->Kh = hmatrix_alloc_kernel(p->t, p->tau, kernelType, htol);
+		p->Ah = hmatrix_alloc_like(p->Kh);
 	}
-	
-	double gradi;
-	for (i = 0; i < m; i++)
+	else if (ktol > 0)
 	{
-		gradi = 0;
-		for (j = 0; j < n; j++)
-			gradi += 2 * gsl_vector_get(p->w, j) * (gsl_vector_get(z, j) - gsl_vector_get(p->y, j)) * gsl_vector_get(p->c, i) * gsl_matrix_get(p->K, j, i);	
-			
-		gsl_vector_set(grad, i, gradi + 2 * p->alpha * p->alpha * gsl_vector_get(d4g, i));
+		p->Ks = skyline_alloc_kernel(p->t, p->tau, kernelType, ktol);
+		p->As = skyline_alloc_like(p->Ks);
+	}
+	else
+	{
+		p->K = gsl_matrix_alloc(n, m);
+		p->A = gsl_matrix_alloc(n, m);
+		kernel_build_chunked(p->K, p->t, p->tau, kernelType);
 	}
 	
-	double gradm = 0;
-	for (j = 0; j < n; j++)
-		gradm += 2 * gsl_vector_get(p->w, j) * (gsl_vector_get(z, j) - gsl_vector_get(p->y, j));
-	gsl_vector_set(grad, m, gradm);
+	quadrature_weights(p->tau, gridType, p->c);
+	
+	return p;
+}
 
-	gsl_vector_free( z   );
-	gsl_vector_free( d2g );
-	gsl_vector_free( d4g );
+/* A rounded into Af, the double A is released */
+static void parameter_round(parameter* p)
+{
+	size_t i, j;
+	for (i = 0; i < p->A->size1; i++)
+		for (j = 0; j < p->A->size2; j++)
+			gsl_matrix_float_set(p->Af, i, j, (float) gsl_matrix_get(p->A, i, j));
+	
+	gsl_matrix_free(p->A);
+	p->A = NULL;
 }
 
 /*
 ------------------------------------------------------------------------------
 
- gradient and function value together 
+ fold the quadrature weights c and the square root of the data weights w 
+ into the kernel once, so that the objective reduces to 
+ |A*g + b*sqrt(w) - sqrt(w)*y|^2 + a^2*|D2g|^2 and every evaluation 
+ is a plain matrix-vector product, then rebuild what depends on A
 
 ------------------------------------------------------------------------------
 */
 
-void fun_fdf(	const gsl_vector *x, void* params,
-				double *f, gsl_vector *grad )
+static void parameter_weight(parameter* p)
 {
-	parameter* p = (parameter*) params;
-	
-	int n = p->y->size;
-	int m = x->size - 1;
-		
-	gsl_vector* z   = gsl_vector_alloc( n );
-	gsl_vector* d2g = gsl_vector_alloc( m );
-	gsl_vector* d4g = gsl_vector_alloc( m );
-
-	diff2(x,   d2g);
-	diff2(d2g, d4g);
-		
-	/*
-	 integral operation, A is the kernel discretization
-	 and c are the weights of the quadrature formula
-	*/
-	
+	int n = p->t->size;
+	int m = p->tau->size;
 	int i, j;
-	double zi;
-	double b = gsl_vector_get(x, m);
 	
-	for (i = 0; i < n; i++)
+	if (p->Ah)
+		hmatrix_weight(p->Ah, p->Kh, p->sw, p->c);
+	else if (p->As)
 	{
-		zi = b;
 		for (j = 0; j < m; j++)
-			zi += gsl_vector_get(p->c, j) * gsl_matrix_get(p->K, i, j) * gsl_vector_get(x, j);
-		gsl_vector_set(z, i, zi);
+			for (i = p->Ks->first[j]; i < p->Ks->last[j]; i++)
+			{
+				size_t k = p->Ks->offset[j] + i - p->Ks->first[j];
+				p->As->data[k] = gsl_vector_get(p->sw, i) * gsl_vector_get(p->c, j) * p->Ks->data[k];
+			}
+	}
+	else
+	{
+		double swi;
+		if (!p->A)
+			p->A = gsl_matrix_alloc(n, m);
+		for (i = 0; i < n; i++)
+		{
+			swi = gsl_vector_get(p->sw, i);
+			for (j = 0; j < m; j++)
+				gsl_matrix_set(p->A, i, j, swi * gsl_vector_get(p->c, j) * gsl_matrix_get(p->K, i, j));
+		}
 	}
 	
-	double var = 0;
-	for (i = 0; i < n; i++)
-		var += gsl_vector_get(p->w, i) * sqr(gsl_vector_get(p->y, i) - gsl_vector_get(z, i));
-	
-	/* determine the second derivative of g */
-	
-	
-	double reg = 0;
-	for (i = 0; i < m; i++)
-		reg += sqr(gsl_vector_get(d2g, i));
+	/* the objective is quadratic, its hessian never changes */
+	parameter_gram(p);
+	parameter_hessian(p);
 	
-	*f = var + p->alpha * p->alpha * reg;
+	/* the Gram matrix is exact, only the products are rounded */
+	if (p->Af)
+		parameter_round(p);
 	
-	double gradi;
-	for (i = 0; i < m; i++)
+	if (p->sf)
 	{
-		gradi = 0;
-		for (j = 0; j < n; j++)
-			gradi += 2 * gsl_vector_get(p->w, j) * (gsl_vector_get(z, j) - gsl_vector_get(p->y, j)) * gsl_vector_get(p->c, i) * gsl_matrix_get(p->K, j, i);	
-			
-		gsl_vector_set(grad, i, gradi + 2 * p->alpha * p->alpha * gsl_vector_get(d4g, i));
+		standard_form_free(p->sf);
+		p->sf = NULL;
+	}
+	if (p->rd)
+	{
+		reduced_free(p->rd);
+		p->rd = NULL;
 	}
-	
-	double gradm = 0;
-	for (j = 0; j < n; j++)
-		gradm += 2 * gsl_vector_get(p->w, j) * (gsl_vector_get(z, j) - gsl_vector_get(p->y, j));
-	gsl_vector_set(grad, m, gradm);
-
-	/* 
-	 free memory
-	*/
-	
-	gsl_vector_free( z );  
-	gsl_vector_free( d2g  );
-	gsl_vector_free( d4g  );
 }
 
 /*
 ------------------------------------------------------------------------------
 
- product of hessian matrix with arbitrary vector v
+ replace the dense K and A by skyline storage, entries below tol relative 
+ to the largest entry of their column are dropped, see contin_skyline.c; 
+ when the tolerance is known up front parameter_alloc_kernel builds the 
+ skyline without the dense kernel
 
 ------------------------------------------------------------------------------
 */
 
-void fun_Hv( const gsl_vector *x, void *params,
-			 const gsl_vector *v, gsl_vector *hv )
+void parameter_compress(parameter* p, double tol)
 {
-	parameter* p = (parameter*) params;
-	
-	int n = p->y->size;
-	int m = x->size - 1;
-	
-	gsl_vector* d2v = gsl_vector_alloc(m);
-	gsl_vector* d4v = gsl_vector_alloc(m);
-	
-	diff2(v,   d2v);
-	diff2(d2v, d4v);
+	if (tol <= 0 || !p->K)
+		return;
 	
-	double H1ij;
-	double H2i;
-	double H3 = 0;
-	int i, j, k;
-	for (k = 0; k < n; k++)
-		H3 += 2 * gsl_vector_get(p->w, k);
+	p->Ks = skyline_alloc_from(p->K, tol);
+	p->As = skyline_alloc_like(p->Ks);
 	
-	double hvi;
-	double hvm = H3 * gsl_vector_get(v, m);
-	for (i = 0; i < m; i++)
-	{
-		H2i = 0;
-		for (k = 0; k < n; k++)
-			H2i += 2 * gsl_vector_get(p->w, k) * gsl_vector_get(p->c, i) * gsl_matrix_get(p->K, k, i);
-		
-		hvm += H2i * gsl_vector_get(v, i);
-		
-		hvi = H2i * gsl_vector_get(v, m);
-		for (j = 0; j < m; j++)
-		{
-			H1ij = 0;
-			for (k = 0; k < n; k++)
-				H1ij += 2*gsl_vector_get(p->w, k) * gsl_vector_get(p->c, i) * gsl_matrix_get(p->K, k, i) * gsl_vector_get(p->c, j) * gsl_matrix_get(p->K, k, j);
-			
-			hvi += H1ij * gsl_vector_get(v, j);
-		}
-		gsl_vector_set(hv, i, hvi + gsl_vector_get(d4v, i));
-	}
-	gsl_vector_set(hv, m, hvm);
+	gsl_matrix_free(p->K);
+	gsl_matrix_free(p->A);
+	p->K = NULL;
+	p->A = NULL;
 	
-	gsl_vector_free( d2v );
-	gsl_vector_free( d4v );
+	/* w = 0, no data loaded yet */
+	if (gsl_vector_get(p->w, 0) != 0)
+		parameter_weight(p);
 }
 
 /*
 ------------------------------------------------------------------------------
 
- displays first two arguements during optimization
+ replace the dense K and A by hierarchical low-rank blocks of relative 
+ accuracy tol, built from kernel evaluations, see contin_hmatrix.c; 
+ parameter_alloc_kernel builds them without the dense kernel
 
 ------------------------------------------------------------------------------
 */
 
-void iteration_echo( ool_conmin_minimizer *M )
+void parameter_hmatrix(parameter* p, double tol, int kernelType)
 {
-	double f = M->f;	size_t ii, nn;
-
-	nn = 2;
-
-	printf( "f( " );
-	for( ii = 0; ii < 3; ii++ )
-		printf( "%+6.3e, ", gsl_vector_get( M->x, ii ) );
-	printf( "... ) = %+6.3e\n", f );
-
+	if (tol <= 0 || !p->K)
+		return;
+	
+	p->Kh = hmatrix_alloc_kernel(p->t, p->tau, kernelType, tol);
+	p->Ah = hmatrix_alloc_like(p->Kh);
+	
+	gsl_matrix_free(p->K);
+	gsl_matrix_free(p->A);
+	p->K = NULL;
+	p->A = NULL;
+	
+	if (gsl_vector_get(p->w, 0) != 0)
+		parameter_weight(p);
 }
 
 /*
 ------------------------------------------------------------------------------
 
- save function to text file
+ keep A in float instead of double, which halves the traffic of the 
+ products that dominate every iteration. K stays resident in double, so 
+ the kernel storage only drops from 16 to 12 bytes per entry (K and A in 
+ double against K in double and A in float). The weights are folded into 
+ A in double and rounded once, and the Gram matrix, the columns and the 
+ products of contin_solve's final refinement are exact, see 
+ parameter_matvec
 
 ------------------------------------------------------------------------------
 */
 
-void saveData(gsl_vector* x, gsl_vector* y, char* fileName)
+void parameter_single(parameter* p, int single)
 {
-	FILE* fileID = fopen(fileName, "w");
+	if (!single || !p->K || p->Af)
+		return;
 	
-	int i;
-	for (i = 0; i < x->size; i++)
-		fprintf(fileID, "%lf\t%lf\n", gsl_vector_get(x, i), 
-									  gsl_vector_get(y, i));
-									  
-	fclose(fileID);
+	int n = p->t->size;
+	int m = p->tau->size;
+	
+	p->Af = gsl_matrix_float_alloc(n, m);
+	p->ws->um = gsl_vector_alloc(m);
+	p->ws->un = gsl_vector_alloc(n);
+	
+	/* w = 0, no data loaded yet, parameter_weight rounds A once it is built */
+	if (gsl_vector_get(p->w, 0) != 0)
+		parameter_round(p);
+	else
+	{
+		gsl_matrix_free(p->A);
+		p->A = NULL;
+	}
 }
 
 /*
 ------------------------------------------------------------------------------
 
- Contin Algorithm 
- For given data (t,y) the spectral function (tau, s) is determined such that 
- y(t) = integral(K(t,s)*g(s) + b, {s, s0, s1})
+ y = alpha*op(A)*x + beta*y for the dense or the compressed kernel
  
+ a large dense A is split into blocks of rows. A*x takes its entries 
+ from one block each, A^T*x is summed from the products of all blocks, 
+ kept apart in ws->part and added in the order of the blocks, so that 
+ no result depends on the number of threads
+ 
+ a float A is read as float and multiplied and summed in double. With 
+ neither A nor Af, during the refinement of a single kernel, the product 
+ runs through the double K and the weights are applied to the vectors, 
+ sw.*(K*(c.*x)) and c.*(K^T*(sw.*x))
 
 ------------------------------------------------------------------------------
 */
 
-int contin( parameter*  p, 
-			gsl_vector* s,
-			gsl_vector* g,
-			double*     b)
+typedef struct
 {
-
-	/*
-	 start minimization to find spectral function 
-	*/
-	int m = g->size;
-	size_t nn   =  m + 1;
-	size_t nmax = 100000;
-	size_t ii;
-	int status;
-	
-	/*
-	 select which optimization algorithm will be used, the SPG algorithm, 
-	 in this example
-	*/
-	
-	const ool_conmin_minimizer_type *T = ool_conmin_minimizer_spg;
-	ool_conmin_spg_parameters P;
-
-	/*
-	 declare variables to hold the objective function, the constraints, 
-	 the minimizer method, and the initial iterate, respectively
-	*/
-	
-	ool_conmin_function   F;
-	ool_conmin_constraint C;
-	ool_conmin_minimizer *M;
-	gsl_vector *X;
+	const gsl_matrix* A;
+	const gsl_matrix_float* Af;
+	CBLAS_TRANSPOSE_t trans;
+	double alpha;
+	const gsl_vector* x;
+	double beta;
+	gsl_vector* y;
+	gsl_matrix* part;
+	
+} matvec_task;
+
+/* rows i0 <= i < i0 + ni of y = alpha*op(Af)*x + beta*y, y has the size of the block */
+static void float_dgemv(CBLAS_TRANSPOSE_t trans, double alpha, const gsl_matrix_float* A, 
+						size_t i0, size_t ni, const gsl_vector* x, double beta, gsl_vector* y)
+{
+	size_t m = A->size2;
+	size_t i, j;
 	
-	/*
+	if (trans == CblasNoTrans)
+	{
+		const double* xd = x->data;
+		size_t xs = x->stride;
+		
+		for (i = 0; i < ni; i++)
+		{
+			const float* a = A->data + (i0 + i) * A->tda;
+			double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+			
+			/* four sums keep the multiplications independent */
+			for (j = 0; j + 4 <= m; j += 4)
+			{
+				s0 += a[j]     * xd[j * xs];
+				s1 += a[j + 1] * xd[(j + 1) * xs];
+				s2 += a[j + 2] * xd[(j + 2) * xs];
+				s3 += a[j + 3] * xd[(j + 3) * xs];
+			}
+			for (; j < m; j++)
+				s0 += a[j] * xd[j * xs];
+			
+			double yi = beta == 0 ? 0 : beta * gsl_vector_get(y, i);
+			gsl_vector_set(y, i, alpha * ((s0 + s1) + (s2 + s3)) + yi);
+		}
+	}
+	else
+	{
+		double* yd = y->data;
+		size_t ys = y->stride;
+		
+		if (beta == 0)
+			gsl_vector_set_zero(y);
+		else if (beta != 1)
+			gsl_vector_scale(y, beta);
+		
+		for (i = 0; i < ni; i++)
+		{
+			const float* a = A->data + (i0 + i) * A->tda;
+			double xi = alpha * gsl_vector_get(x, i);
+			for (j = 0; j < m; j++)
+				yd[j * ys] += xi * a[j];
+		}
+	}
+}
+
+static void matvec_chunk(void* arg, size_t c)
+{
+	matvec_task* mt = (matvec_task*) arg;
+	size_t n  = mt->A ? mt->A->size1 : mt->Af->size1;
+	size_t m  = mt->A ? mt->A->size2 : mt->Af->size2;
+	size_t i0 = c * PARALLEL_ROWS;
+	size_t ni = GSL_MIN(PARALLEL_ROWS, n - i0);
+	
+	if (mt->trans == CblasNoTrans)
+	{
+		gsl_vector_view yc = gsl_vector_subvector(mt->y, i0, ni);
+		if (mt->Af)
+			float_dgemv(CblasNoTrans, mt->alpha, mt->Af, i0, ni, mt->x, mt->beta, &yc.vector);
+		else
+		{
+			gsl_matrix_const_view Ac = gsl_matrix_const_submatrix(mt->A, i0, 0, ni, m);
+			gsl_blas_dgemv(CblasNoTrans, mt->alpha, &Ac.matrix, mt->x, mt->beta, &yc.vector);
+		}
+	}
+	else
+	{
+		gsl_vector_const_view xc = gsl_vector_const_subvector(mt->x, i0, ni);
+		gsl_vector_view pc = gsl_matrix_row(mt->part, c);
+		if (mt->Af)
+			float_dgemv(CblasTrans, 1.0, mt->Af, i0, ni, &xc.vector, 0.0, &pc.vector);
+		else
+		{
+			gsl_matrix_const_view Ac = gsl_matrix_const_submatrix(mt->A, i0, 0, ni, m);
+			gsl_blas_dgemv(CblasTrans, 1.0, &Ac.matrix, &xc.vector, 0.0, &pc.vector);
+		}
+	}
+}
+
+/* the product with a dense double A or float Af, split if ws->part is there */
+static void dense_matvec(const parameter* p, 
+						 const gsl_matrix* A, 
+						 const gsl_matrix_float* Af, 
+						 CBLAS_TRANSPOSE_t trans, 
+						 double alpha, 
+						 const gsl_vector* x, 
+						 double beta, 
+						 gsl_vector* y)
+{
+	if (p->ws->part)
+	{
+		matvec_task mt = { A, Af, trans, alpha, x, beta, y, p->ws->part };
+		size_t nchunks = p->ws->part->size1;
+		size_t c, j;
+		
+		parallel_chunks(nchunks, matvec_chunk, &mt);
+		
+		if (trans != CblasNoTrans)
+			for (j = 0; j < y->size; j++)
+			{
+				double sum = 0;
+				for (c = 0; c < nchunks; c++)
+					sum += gsl_matrix_get(p->ws->part, c, j);
+				gsl_vector_set(y, j, alpha * sum + (beta == 0 ? 0 : beta * gsl_vector_get(y, j)));
+			}
+	}
+	else if (Af)
+		float_dgemv(trans, alpha, Af, 0, Af->size1, x, beta, y);
+	else if (!fixed_dgemv(trans, alpha, A, x, beta, y))
+		gsl_blas_dgemv(trans, alpha, A, x, beta, y);
+}
+
+void parameter_matvec(const parameter* p, 
+					  CBLAS_TRANSPOSE_t trans, 
+					  double alpha, 
+					  const gsl_vector* x, 
+					  double beta, 
+					  gsl_vector* y)
+{
+	if (p->Ah)
+		hmatrix_dgemv(trans, alpha, p->Ah, x, beta, y);
+	else if (p->As)
+		skyline_dgemv(trans, alpha, p->As, x, beta, y);
+	else if (p->A || p->Af)
+		dense_matvec(p, p->A, p->Af, trans, alpha, x, beta, y);
+	else
+	{
+		gsl_vector* u = trans == CblasNoTrans ? p->ws->um : p->ws->un;
+		gsl_vector* v = trans == CblasNoTrans ? p->ws->un : p->ws->um;
+		const gsl_vector* win  = trans == CblasNoTrans ? p->c : p->sw;
+		const gsl_vector* wout = trans == CblasNoTrans ? p->sw : p->c;
+		size_t i;
+		
+		gsl_vector_memcpy(u, x);
+		gsl_vector_mul(u, win);
+		dense_matvec(p, p->K, NULL, trans, 1.0, u, 0.0, v);
+		
+		for (i = 0; i < y->size; i++)
+		{
+			double yi = beta == 0 ? 0 : beta * gsl_vector_get(y, i);
+			gsl_vector_set(y, i, alpha * gsl_vector_get(wout, i) * gsl_vector_get(v, i) + yi);
+		}
+	}
+}
+
+/* column j of A */
+void parameter_column(const parameter* p, size_t j, gsl_vector* col)
+{
+	if (p->Ah)
+		hmatrix_column(p->Ah, j, col);
+	else if (p->As)
+		skyline_column(p->As, j, col);
+	else if (p->A)
+	{
+		gsl_vector_const_view a = gsl_matrix_const_column(p->A, j);
+		gsl_vector_memcpy(col, &a.vector);
+	}
+	else
+	{
+		/* exact also for a single kernel */
+		gsl_vector_const_view k = gsl_matrix_const_column(p->K, j);
+		gsl_vector_memcpy(col, &k.vector);
+		gsl_vector_mul(col, p->sw);
+		gsl_vector_scale(col, gsl_vector_get(p->c, j));
+	}
+}
+
+/*
+------------------------------------------------------------------------------
+
+ load observed data y with variance var into p
+ 
+ the weighted kernel, the Gram matrix, the hessian and the standard form 
+ factorization only depend on var, they are rebuilt when var differs 
+ from the previous call (w = 0 marks a fresh struct), otherwise only the 
+ weighted data is updated, returns 1 if the weights were rebuilt
+
+------------------------------------------------------------------------------
+*/
+
+int parameter_set_data(parameter* p, gsl_vector* y, gsl_vector* var)
+{
+	int n = p->t->size;
+	int i;
+	
+	int reweight = 0;
+	for (i = 0; i < n; i++)
+		if (gsl_vector_get(p->w, i) != 1.0 / gsl_vector_get(var, i))
+			reweight = 1;
+	
+	gsl_vector_memcpy(p->y, y);
+	
+	if (reweight)
+	{
+		for (i = 0; i < n; i++)
+			gsl_vector_set(p->w, i, 1.0 / gsl_vector_get(var, i));
+		
+		for (i = 0; i < n; i++)
+			gsl_vector_set(p->sw, i, sqrt(gsl_vector_get(p->w, i)));
+		
+		parameter_weight(p);
+	}
+	
+	for (i = 0; i < n; i++)
+		gsl_vector_set(p->swy, i, gsl_vector_get(p->sw, i) * gsl_vector_get(p->y, i));
+	
+	return reweight;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ allocate memory for parameter-struct entries and intialize 
+ kernel K, ... etc for a given tau grid
+
+------------------------------------------------------------------------------
+*/
+
+parameter* parameter_alloc_grid(gsl_vector* t, 
+								gsl_vector* y,
+								gsl_vector* var,
+								double alpha,
+								const gsl_vector* tau,
+								int gridType,
+								int kernelType)
+{
+	parameter* p = parameter_alloc_kernel(t, alpha, tau, gridType, kernelType, 0, 0);
+	parameter_set_data(p, y, var);
+	
+	return p;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ allocate parameter struct on a linear or logarithmic grid of m points 
+ between tau0 and tau1
+
+------------------------------------------------------------------------------
+*/
+
+parameter* parameter_alloc(gsl_vector* t, 
+						    gsl_vector* y,
+						    gsl_vector* var,
+						    double alpha,
+						    double tau0,
+						    double tau1,
+						    int m,
+							int kernelType,
+							int gridType)
+{
+	gsl_vector* tau = gsl_vector_alloc(m);
+	tau_grid(tau0, tau1, gridType, tau);
+	
+	parameter* p = parameter_alloc_grid(t, y, var, alpha, tau, gridType, kernelType);
+	
+	gsl_vector_free(tau);
+	return p;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ release allocated memory for parameter struct
+
+------------------------------------------------------------------------------
+*/
+
+void parameter_free(parameter* p)
+{
+	if ( p->K ) gsl_matrix_free( p->K );
+	if ( p->w ) gsl_vector_free( p->w );
+	if ( p->c ) gsl_vector_free( p->c );
+	if ( p->y ) gsl_vector_free( p->y );
+	if ( p->t ) gsl_vector_free( p->t );
+	if ( p->tau ) gsl_vector_free( p->tau );
+	if ( p->A ) gsl_matrix_free( p->A );
+	if ( p->sw ) gsl_vector_free( p->sw );
+	if ( p->swy ) gsl_vector_free( p->swy );
+	if ( p->G ) gsl_matrix_free( p->G );
+	if ( p->H ) gsl_matrix_free( p->H );
+	if ( p->ws ) workspace_free( p->ws );
+	if ( p->sf ) standard_form_free( p->sf );
+	if ( p->rd ) reduced_free( p->rd );
+	if ( p->Ks ) skyline_free( p->Ks );
+	if ( p->As ) skyline_free( p->As );
+	if ( p->Kh ) hmatrix_free( p->Kh );
+	if ( p->Ah ) hmatrix_free( p->Ah );
+	if ( p->Af ) gsl_matrix_float_free( p->Af );
+	free(p);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ discrete 2nd derivative of g
+
+------------------------------------------------------------------------------
+*/
+ 
+void diff2(const gsl_vector *x, gsl_vector * ddg)
+{
+	int i;
+	for (i = 1; i < ddg->size - 1; i++)
+		gsl_vector_set(ddg, i, gsl_vector_get(x, i - 1) - 2 * gsl_vector_get(x, i) + gsl_vector_get(x, i + 1));
+		
+	gsl_vector_set(ddg, 0, - 2 * gsl_vector_get(x, 0) + gsl_vector_get(x, 1));
+	gsl_vector_set(ddg,  ddg->size - 1, gsl_vector_get(x, ddg->size - 2) - 2 * gsl_vector_get(x, ddg->size - 1));
+}
+
+/* block column j0 <= j < j0 + nj of the upper triangle of A^T*A */
+typedef struct
+{
+	const gsl_matrix* A;
+	gsl_matrix* GA;
+	
+} gram_task;
+
+static void gram_chunk(void* arg, size_t c)
+{
+	gram_task* gt = (gram_task*) arg;
+	size_t n  = gt->A->size1;
+	size_t j0 = c * PARALLEL_COLS;
+	size_t nj = GSL_MIN(PARALLEL_COLS, gt->A->size2 - j0);
+	
+	gsl_matrix_const_view Al = gsl_matrix_const_submatrix(gt->A, 0, 0, n, j0 + nj);
+	gsl_matrix_const_view Ac = gsl_matrix_const_submatrix(gt->A, 0, j0, n, nj);
+	gsl_matrix_view Gc = gsl_matrix_submatrix(gt->GA, 0, j0, j0 + nj, nj);
+	gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, &Al.matrix, &Ac.matrix, 0.0, &Gc.matrix);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ weighted Gram matrix of the kernel augmented by the background column
+ 
+ G = [A^T*A, A^T*sqrt(w); sqrt(w)^T*A, sqrt(w)^T*sqrt(w)]
+
+------------------------------------------------------------------------------
+*/
+
+void parameter_gram(parameter* p)
+{
+	int m = p->tau->size;
+	int i, j;
+	
+	gsl_matrix_view GA  = gsl_matrix_submatrix(p->G, 0, 0, m, m);
+	gsl_vector_view col = gsl_matrix_column(p->G, m);
+	gsl_vector_view Gb  = gsl_vector_subvector(&col.vector, 0, m);
+	
+	if (p->Ah)
+	{
+		/* one adjoint product per column */
+		gsl_vector* a = gsl_vector_alloc(p->t->size);
+		for (j = 0; j < m; j++)
+		{
+			gsl_vector_view Gj = gsl_matrix_column(&GA.matrix, j);
+			parameter_column(p, j, a);
+			parameter_matvec(p, CblasTrans, 1.0, a, 0.0, &Gj.vector);
+		}
+		gsl_vector_free(a);
+	}
+	else if (p->As)
+		skyline_dsyrk(p->As, &GA.matrix);
+	else if (p->A->size1 * p->A->size2 >= PARALLEL_MIN)
+	{
+		gram_task gt = { p->A, &GA.matrix };
+		parallel_chunks((m + PARALLEL_COLS - 1) / PARALLEL_COLS, gram_chunk, &gt);
+	}
+	else if (!fixed_dsyrk(p->A, &GA.matrix))
+		gsl_blas_dsyrk(CblasUpper, CblasTrans, 1.0, p->A, 0.0, &GA.matrix);
+	parameter_matvec(p, CblasTrans, 1.0, p->sw, 0.0, &Gb.vector);
+	
+	double Gmm;
+	gsl_blas_ddot(p->sw, p->sw, &Gmm);
+	gsl_matrix_set(p->G, m, m, Gmm);
+	
+	/* dsyrk fills the upper triangle only */
+	for (i = 0; i <= m; i++)
+		for (j = 0; j < i; j++)
+			gsl_matrix_set(p->G, i, j, gsl_matrix_get(p->G, j, i));
+}
+
+/*
+------------------------------------------------------------------------------
+
+ hessian of f(g, b), H = 2*G + 2*a^2*D2^T*D2 
+ the regularizer operator is assembled column by column from diff2 and has 
+ to be rebuilt whenever alpha changes
+
+------------------------------------------------------------------------------
+*/
+
+void parameter_hessian(parameter* p)
+{
+	int m = p->tau->size;
+	int i, j;
+	
+	gsl_vector* e   = gsl_vector_calloc(m);
+	gsl_vector* d2e = gsl_vector_alloc(m);
+	gsl_vector* d4e = gsl_vector_alloc(m);
+	
+	gsl_matrix_memcpy(p->H, p->G);
+	gsl_matrix_scale(p->H, 2.0);
+	
+	double a2 = 2 * p->alpha * p->alpha;
+	for (j = 0; j < m; j++)
+	{
+		gsl_vector_set(e, j, 1.0);
+		diff2(e,   d2e);
+		diff2(d2e, d4e);
+		gsl_vector_set(e, j, 0.0);
+		
+		/* D2^T*D2 is pentadiagonal */
+		for (i = GSL_MAX(0, j - 2); i <= GSL_MIN(m - 1, j + 2); i++)
+			*gsl_matrix_ptr(p->H, i, j) += a2 * gsl_vector_get(d4e, i);
+	}
+	
+	gsl_vector_free( e   );
+	gsl_vector_free( d2e );
+	gsl_vector_free( d4e );
+}
+
+/*
+------------------------------------------------------------------------------
+
+ change the strength of the regularizer, the Gram matrix is kept
+
+------------------------------------------------------------------------------
+*/
+
+void parameter_set_alpha(parameter* p, double alpha)
+{
+	p->alpha = alpha;
+	parameter_hessian(p);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ weighted residual r = A*g + b*sqrt(w) - sqrt(w)*y
+ x = (g, b), one streaming pass over A
+
+------------------------------------------------------------------------------
+*/
+
+void residual(const gsl_vector* x, parameter* p, gsl_vector* r)
+{
+	int m = x->size - 1;
+	
+	gsl_vector_const_view g = gsl_vector_const_subvector(x, 0, m);
+	
+	gsl_vector_memcpy(r, p->swy);
+	gsl_blas_daxpy(-gsl_vector_get(x, m), p->sw, r);
+	parameter_matvec(p, CblasNoTrans, 1.0, &g.vector, -1.0, r);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ gradient from a given residual r
+ grad = 2*(A^T*r + a^2*D4g, sqrt(w)^T*r)
+
+------------------------------------------------------------------------------
+*/
+
+void residual_df(const gsl_vector* r, const gsl_vector* d4g, parameter* p, gsl_vector* grad)
+{
+	int m = grad->size - 1;
+	
+	gsl_vector_view grad_g = gsl_vector_subvector(grad, 0, m);
+	
+	gsl_vector_memcpy(&grad_g.vector, d4g);
+	parameter_matvec(p, CblasTrans, 2.0, r, 2.0 * p->alpha * p->alpha, &grad_g.vector);
+	
+	double gradm;
+	gsl_blas_ddot(p->sw, r, &gradm);
+	gsl_vector_set(grad, m, 2 * gradm);
+}
+
+/*
+------------------------------------------------------------------------------
+ z = A*g + b 
+ f(g, b) = |y - z|^2 + a^2*|D2g|^2
+ x = (g, b)
+------------------------------------------------------------------------------
+*/
+
+double fun(const gsl_vector* x, void* params)
+{
+	parameter* p = (parameter*) params;
+	
+	gsl_vector* r   = p->ws->r;
+	gsl_vector* d2g = p->ws->d2g;
+	p->ws->neval++;
+	
+	/* x= (g,b), diff2 acts only on the g-part of x*/
+	diff2(x, d2g);
+	
+	/*
+	 integral operation, A is the kernel discretization
+	 with the weights of the quadrature formula folded in
+	*/
+	
+	double var, reg;
+	residual(x, p, r);
+	gsl_blas_ddot(r, r, &var);
+	
+	/* regularizer, second derivative of g*/
+	gsl_blas_ddot(d2g, d2g, &reg);
+	
+	return var + p->alpha * p->alpha * reg;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ gradient of f(g, b) = |y - A*g+b|^2 + a^2*|Pg|^2
+ x = (g, b)
+
+------------------------------------------------------------------------------
+*/
+
+void fun_df(const gsl_vector *x, void* params, gsl_vector *grad)
+{
+	parameter* p = (parameter*) params;
+	
+	gsl_vector* r   = p->ws->r;
+	gsl_vector* d2g = p->ws->d2g;
+	gsl_vector* d4g = p->ws->d4g;
+	p->ws->neval++;
+	
+	diff2(x,   d2g);
+	diff2(d2g, d4g);
+	
+	residual(x, p, r);
+	residual_df(r, d4g, p, grad);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ gradient and function value together 
+
+------------------------------------------------------------------------------
+*/
+
+void fun_fdf(	const gsl_vector *x, void* params,
+				double *f, gsl_vector *grad )
+{
+	parameter* p = (parameter*) params;
+	
+	gsl_vector* r   = p->ws->r;
+	gsl_vector* d2g = p->ws->d2g;
+	gsl_vector* d4g = p->ws->d4g;
+	p->ws->neval++;
+
+	diff2(x,   d2g);
+	diff2(d2g, d4g);
+		
+	/*
+	 forward pass and gradient share the residual, 
+	 each costs one pass over A
+	*/
+	
+	double var, reg;
+	residual(x, p, r);
+	gsl_blas_ddot(r, r, &var);
+	
+	/* determine the second derivative of g */
+	gsl_blas_ddot(d2g, d2g, &reg);
+	
+	*f = var + p->alpha * p->alpha * reg;
+	
+	residual_df(r, d4g, p, grad);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ product of hessian matrix with arbitrary vector v
+
+------------------------------------------------------------------------------
+*/
+
+void fun_Hv( const gsl_vector *x, void *params,
+			 const gsl_vector *v, gsl_vector *hv )
+{
+	parameter* p = (parameter*) params;
+	p->ws->neval++;
+	
+	/* f is quadratic, H is independent of x and precomputed */
+	gsl_blas_dsymv(CblasUpper, 1.0, p->H, v, 0.0, hv);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ objective in the scaled variables x = d*z, the minimizer sees 
+ f(d*z) with gradient d*grad f and hessian diag(d)*H*diag(d)
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	parameter* p;
+	const gsl_vector* d;	/* x = d*z */
+	gsl_vector* x;			/* scratch for the unscaled point */
+	gsl_vector* v;			/* scratch for the unscaled direction */
+	
+} scaled_parameter;
+
+static const gsl_vector* scaled_point(const gsl_vector* z, scaled_parameter* sp)
+{
+	gsl_vector_memcpy(sp->x, z);
+	gsl_vector_mul(sp->x, sp->d);
+	return sp->x;
+}
+
+static double fun_scaled(const gsl_vector* z, void* params)
+{
+	scaled_parameter* sp = (scaled_parameter*) params;
+	return fun(scaled_point(z, sp), sp->p);
+}
+
+static void fun_df_scaled(const gsl_vector* z, void* params, gsl_vector* grad)
+{
+	scaled_parameter* sp = (scaled_parameter*) params;
+	fun_df(scaled_point(z, sp), sp->p, grad);
+	gsl_vector_mul(grad, sp->d);
+}
+
+static void fun_fdf_scaled(const gsl_vector* z, void* params, double* f, gsl_vector* grad)
+{
+	scaled_parameter* sp = (scaled_parameter*) params;
+	fun_fdf(scaled_point(z, sp), sp->p, f, grad);
+	gsl_vector_mul(grad, sp->d);
+}
+
+static void fun_Hv_scaled(const gsl_vector* z, void* params, const gsl_vector* v, gsl_vector* hv)
+{
+	scaled_parameter* sp = (scaled_parameter*) params;
+	gsl_vector_memcpy(sp->v, v);
+	gsl_vector_mul(sp->v, sp->d);
+	fun_Hv(scaled_point(z, sp), sp->p, sp->v, hv);
+	gsl_vector_mul(hv, sp->d);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ Jacobi scaling d(j) = sqrt(max(diag G)/G(j,j)) from the Gram diagonal, 
+ the scaled columns of [A, sqrt(w)] have equal norm. The columns differ 
+ by orders of magnitude between short and long tau and the background 
+ column, without the scaling SPG creeps along the flat directions.
+
+------------------------------------------------------------------------------
+*/
+
+static void jacobi_scaling(const parameter* p, gsl_vector* d)
+{
+	size_t j;
+	double gmax = 0;
+	
+	for (j = 0; j < d->size; j++)
+		gmax = GSL_MAX(gmax, gsl_matrix_get(p->G, j, j));
+	
+	/* a column that vanishes on the lag grid keeps its scale */
+	for (j = 0; j < d->size; j++)
+	{
+		double gjj = gsl_matrix_get(p->G, j, j);
+		gsl_vector_set(d, j, gjj > 0 ? sqrt(gmax / gjj) : 1.0);
+	}
+}
+
+/*
+------------------------------------------------------------------------------
+
+ stopping test of SPG in the unscaled variables, sup norm of the projected 
+ gradient P(x - grad f) - x with x = d*z and grad f = grad_z/d, so both 
+ variants stop at the same accuracy
+
+------------------------------------------------------------------------------
+*/
+
+static int scaled_is_optimal(const ool_conmin_minimizer* M, const gsl_vector* d, double tol)
+{
+	size_t j;
+	double size = 0;
+	
+	for (j = 0; j < M->x->size; j++)
+	{
+		double dj = gsl_vector_get(d, j);
+		double xj = dj * gsl_vector_get(M->x, j);
+		double v  = xj - gsl_vector_get(M->gradient, j) / dj;
+		v = GSL_MIN(GSL_MAX(v, dj * gsl_vector_get(M->con->L, j)), dj * gsl_vector_get(M->con->U, j));
+		size = GSL_MAX(size, fabs(v - xj));
+	}
+	
+	return size <= tol ? OOL_SUCCESS : OOL_CONTINUE;
+}
+
+/* wall-clock time since start, for the deadline of contin */
+static double seconds_since(const struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) + 1e-9 * (now.tv_nsec - start->tv_nsec);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ displays first two arguements during optimization
+
+------------------------------------------------------------------------------
+*/
+
+void iteration_echo( ool_conmin_minimizer *M )
+{
+	double f = M->f;	size_t ii, nn;
+
+	nn = 2;
+
+	printf( "f( " );
+	for( ii = 0; ii < 3; ii++ )
+		printf( "%+6.3e, ", gsl_vector_get( M->x, ii ) );
+	printf( "... ) = %+6.3e\n", f );
+
+}
+
+/*
+------------------------------------------------------------------------------
+
+ save function to text file
+
+------------------------------------------------------------------------------
+*/
+
+void saveData(gsl_vector* x, gsl_vector* y, char* fileName)
+{
+	FILE* fileID = fopen(fileName, "w");
+	
+	int i;
+	for (i = 0; i < x->size; i++)
+		fprintf(fileID, "%lf\t%lf\n", gsl_vector_get(x, i), 
+									  gsl_vector_get(y, i));
+									  
+	fclose(fileID);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ Contin Algorithm 
+ For given data (t,y) the spectral function (tau, s) is determined such that 
+ y(t) = integral(K(t,s)*g(s) + b, {s, s0, s1})
+ 
+
+------------------------------------------------------------------------------
+*/
+
+int contin( parameter*  p, 
+			const contin_options* opts,
+			gsl_vector* s,
+			gsl_vector* g,
+			double*     b,
+			size_t*     iterations)
+{
+
+	/*
+	 start minimization to find spectral function 
+	*/
+	int m = g->size;
+	size_t nn   =  m + 1;
+	size_t ii;
+	int status;
+	
+	contin_options defaults;
+	if (!opts)
+	{
+		contin_options_default(&defaults);
+		opts = &defaults;
+	}
+	
+	const gsl_vector* x0 = opts->x0;
+	int precondition = opts->precondition;
+	const contin_minimizer* par = &opts->minimizer;
+	size_t nmax = par->nmax;
+	
+	/*
+	 select which optimization algorithm will be used, SPG unless PGRAD is 
+	 asked for, and start from its default parameters
+	*/
+	
+	const ool_conmin_minimizer_type *T;
+	union
+	{
+		ool_conmin_spg_parameters    spg;
+		ool_conmin_pgrad_parameters  pgrad;
+	} P;
+	double tol;
+	
+	if (opts->solver == SOLVER_PGRAD)
+	{
+		T = ool_conmin_minimizer_pgrad;
+		ool_conmin_parameters_default( T, (void*)(&P) );
+		if (par->tol > 0)
+			P.pgrad.tol = par->tol;
+		tol = P.pgrad.tol;
+	}
+	else
+	{
+		T = ool_conmin_minimizer_spg;
+		ool_conmin_parameters_default( T, (void*)(&P) );
+		if (par->tol > 0)
+			P.spg.tol = par->tol;
+		if (par->M > 0)
+			P.spg.M = par->M;
+		tol = P.spg.tol;
+	}
+
+	/*
+	 declare variables to hold the objective function, the constraints, 
+	 the minimizer method, and the initial iterate, respectively
+	*/
+	
+	ool_conmin_function   F;
+	ool_conmin_constraint C;
+	ool_conmin_minimizer *M;
+	gsl_vector *X;
+	
+	/*
 	 the function structure is filled in with the number of variables, 
 	 pointers to routines to evaluate the objective function and its 
 	 derivatives, and a pointer to the function parameters */
@@ -558,146 +1359,1595 @@ int contin( parameter*  p,
 	F.Hv  = &fun_Hv;
 	F.params = (void *) p;
 	
-	/*
-	 the lower and upper bounds are set to -3 and 3, respectively, 
-	 to all variables.
-	*/
+	/*
+	 the preconditioned variant minimizes over z = x/d, d from the 
+	 diagonal of the Gram matrix, see jacobi_scaling
+	*/
+	
+	gsl_vector* d = gsl_vector_alloc( nn );
+	scaled_parameter sp;
+	
+	if (precondition)
+	{
+		jacobi_scaling(p, d);
+		
+		sp.p = p;
+		sp.d = d;
+		sp.x = gsl_vector_alloc( nn );
+		sp.v = gsl_vector_alloc( nn );
+		
+		F.f   = &fun_scaled;
+		F.df  = &fun_df_scaled;
+		F.fdf = &fun_fdf_scaled;
+		F.Hv  = &fun_Hv_scaled;
+		F.params = (void *) &sp;
+	}
+	else
+		gsl_vector_set_all(d, 1.0);
+	
+	/*
+	 the lower and upper bounds are set to L and U, by default 0 and 100, 
+	 to all variables.
+	*/
+	
+	C.n = nn;
+	C.L = gsl_vector_alloc( C.n );
+	C.U = gsl_vector_alloc( C.n );
+
+	gsl_vector_set_all( C.L, par->L );
+	gsl_vector_set_all( C.U, par->U );
+	
+	/* 
+	 these lines allocate and set the initial iterate, either the 
+	 solution of a neighbouring problem or a flat distribution
+	*/
+	
+	X = gsl_vector_alloc( nn );
+	if (x0)
+		gsl_vector_memcpy( X, x0 );
+	else
+	{
+		gsl_vector_set_all( X, 1.0 );
+		/* we better set the background parameter to 0 */
+		gsl_vector_set(X, X->size - 1, 0);
+	}
+	
+	/* the starting point has to lie in the box */
+	for (ii = 0; ii < nn; ii++)
+		gsl_vector_set(X, ii, GSL_MIN(GSL_MAX(gsl_vector_get(X, ii), 
+					gsl_vector_get(C.L, ii)), gsl_vector_get(C.U, ii)));
+	
+	/* the box [L, U] and the start in x are [L/d, U/d] and X/d in z */
+	gsl_vector_div( C.L, d );
+	gsl_vector_div( C.U, d );
+	gsl_vector_div( X, d );
+	
+	
+	/*
+	 allocate the necessary memory for an instance of the
+	 optimization algorithm of type T. Initializes its parameters 
+	 to default values. If the you want to tune the method by 
+	 changing the default values to some parameter this should 
+	 be done 
+	*/
+	
+	M = ool_conmin_minimizer_alloc( T, nn );
+	
+	/*
+	 everything is put together. It states that this instance of 
+	 the method M is responsible for minimizing function F, subject 
+	 to constraints C, starting from point X, with parameters P. 
+	*/
+	
+	ool_conmin_minimizer_set( M, &F, &C, X, (void*)(&P) );
+	
+	/*
+	 The iteration counter is initialized and some information
+	 concerning the initial point is displayed. The iteration 
+	 loop is repeated while the maximum number of iterations was not reached
+	 and the status is OOL_CONTINUE. Further conditions could also be 
+	 considered (maximum number of function/gradient evaluation for example).
+	 The iteration counter is incremented and one single iteration of the 
+	 method is performed. Current iterate is checked for optimality. 
+	 Finally some information concerning this iteration is displayed. 
+	*/
+	
+	ii = 0;
+	status = OOL_CONTINUE;
+	
+	/*
+	 SPG does not decrease the objective in every step, the best iterate 
+	 is kept aside so that any stop returns the smallest objective seen. 
+	 stall counts the iterations since it last improved, the deadline is 
+	 checked against a monotonic clock, which keeps running while other 
+	 threads of a batch are scheduled
+	*/
+	
+	gsl_vector* xbest = gsl_vector_alloc( nn );
+	gsl_vector_memcpy( xbest, M->x );
+	double fbest = M->f;
+	size_t ibest = 0;
+	struct timespec start;
+	clock_gettime( CLOCK_MONOTONIC, &start );
+	
+	/*printf( "%4i : ", ii );
+		iteration_echo ( M );
+	printf( "\n" );			*/
+
+	while( ii < nmax && status == OOL_CONTINUE )
+	{
+		ii++;
+		ool_conmin_minimizer_iterate( M );
+		status = precondition ? scaled_is_optimal( M, d, tol ) 
+							  : ool_conmin_is_optimal( M );
+		
+		if (M->f < fbest)
+		{
+			fbest = M->f;
+			ibest = ii;
+			gsl_vector_memcpy( xbest, M->x );
+		}
+		if (status != OOL_CONTINUE)
+			break;
+		if (par->stall && ii - ibest >= par->stall)
+			status = OOL_ENOPROG;
+		else if (par->deadline > 0 && seconds_since( &start ) > par->deadline)
+			status = CONTIN_DEADLINE;
+
+	/*	if( ii % 100 == 0 )
+		{
+			printf( "%4i ", ii );
+			iteration_echo( M );
+		}					*/
+	}
+	if (status == OOL_CONTINUE)
+		status = OOL_EMAXITER;
+	
+	/*
+	 the caller reports the outcome, contin runs in worker threads 
+	 of contin_batch where printing is not allowed
+	*/
+
+/*	printf( "\nvariables................: %6i"
+			"\nfunction evaluations.....: %6i"
+			"\ngradient evaluations.....: %6i"
+			"\nfunction value...........: % .6e"
+			"\nprojected gradient norm..: % .6e\n",
+			nn,
+			ool_conmin_minimizer_fcount( M ),
+			ool_conmin_minimizer_gcount( M ),
+			ool_conmin_minimizer_minimum( M ),
+			ool_conmin_minimizer_size( M ));	*/
+
+	/* undo the scaling of the best iterate, x = d*z */
+	gsl_vector_memcpy(s, p->tau);
+	int i;
+	for (i = 0; i < g->size; i++)
+		gsl_vector_set(g, i, gsl_vector_get(d, i) * gsl_vector_get(xbest, i));
+	*b =  gsl_vector_get(d, m) * gsl_vector_get(xbest, m);
+	
+	if (iterations)
+		*iterations = ii;
+	
+	if (precondition)
+	{
+		gsl_vector_free( sp.x );
+		gsl_vector_free( sp.v );
+	}
+	gsl_vector_free( xbest );
+	gsl_vector_free( d );
+	gsl_vector_free( C.L );
+	gsl_vector_free( C.U );
+	gsl_vector_free( X );
+
+	ool_conmin_minimizer_free( M );
+	
+	return status;
+	
+}
+
+int contin_resolve(int status)
+{
+	return status == OOL_EMAXITER || status == CONTIN_DEADLINE;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ dispatch to the solver engine selected in opts, after choosing alpha 
+ from the regularization path if requested
+
+------------------------------------------------------------------------------
+*/
+
+void contin_options_default(contin_options* opts)
+{
+	opts->solver     = SOLVER_SPG;
+	opts->minimizer.tol  = 0;
+	opts->minimizer.nmax = 100000;
+	opts->minimizer.M    = 0;
+	opts->minimizer.L    = 0.0;
+	opts->minimizer.U    = 100.0;
+	opts->minimizer.deadline = 0;
+	opts->minimizer.stall    = 0;
+	opts->criterion  = ALPHA_FIXED;
+	opts->path       = NULL;
+	opts->x0         = NULL;
+	opts->model      = NULL;
+	opts->ktol       = 0;
+	opts->htol       = 0;
+	opts->single     = 0;
+	opts->rtol       = 0;
+	opts->precondition = 0;
+	opts->alpha      = 0;
+	opts->iterations = 0;
+	opts->rank       = 0;
+	opts->truncation = 0;
+	opts->boundary   = 0;
+}
+
+int contin_solve(parameter* p, 
+				 contin_options* opts, 
+				 gsl_vector* s, 
+				 gsl_vector* g, 
+				 double* b)
+{
+	if (opts->solver == SOLVER_GENCAN)
+		return OOL_EINVAL;
+	
+	if (opts->criterion != ALPHA_FIXED)
+	{
+		regularization_path* path = opts->path;
+		if (!path)
+			path = regularization_path_alloc(ALPHA_GRID_SIZE);
+		
+		contin_regularization_path(p, path);
+		parameter_set_alpha(p, regularization_path_select(path, opts->criterion));
+		opts->boundary = regularization_path_boundary(path, opts->criterion);
+		
+		if (!opts->path)
+			regularization_path_free(path);
+	}
+	opts->alpha = p->alpha;
+	
+	/* the engines run unchanged on the k rows of the reduced problem */
+	if (opts->rtol > 0)
+	{
+		parameter* q = parameter_reduce(p, opts->rtol);
+		size_t ns = p->rd->s->size;
+		
+		opts->rank = q->t->size;
+		opts->truncation = opts->rank < ns ? 
+			gsl_vector_get(p->rd->s, opts->rank) / gsl_vector_get(p->rd->s, 0) : 0;
+		p = q;
+	}
+	
+	if (opts->solver == SOLVER_NNLS)
+		return contin_nnls(p, s, g, b, &opts->iterations);
+	
+	/* MEM only needs the Gram matrix, which is exact for a single kernel */
+	if (opts->solver == SOLVER_MEM)
+		return contin_mem(p, opts, s, g, b, &opts->iterations);
+	
+	if (!p->Af)
+		return contin(p, opts, s, g, b, &opts->iterations);
+	
+	/* 
+	 a single kernel converges on the float products first, the same engine 
+	 then refines from there with the exact products through K, which only 
+	 takes the few iterations the rounding has moved the minimum
+	*/
+	
+	size_t coarse;
+	int status = contin(p, opts, s, g, b, &coarse);
+	if (contin_resolve(status))
+	{
+		opts->iterations = coarse;
+		return status;
+	}
+	
+	size_t m = g->size;
+	gsl_vector* x = gsl_vector_alloc(m + 1);
+	gsl_vector_view xg = gsl_vector_subvector(x, 0, m);
+	gsl_vector_memcpy(&xg.vector, g);
+	gsl_vector_set(x, m, *b);
+	
+	contin_options refine = *opts;
+	refine.x0 = x;
+	
+	gsl_matrix_float* Af = p->Af;
+	p->Af = NULL;
+	status = contin(p, &refine, s, g, b, &opts->iterations);
+	p->Af = Af;
+	
+	opts->iterations += coarse;
+	gsl_vector_free(x);
+	
+	return status;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ Matlab wrapper
+ 
+ to produce a matlab executable we have to compile this file
+ with: mex -lool -lgsl -lgslcblas -lm contin.c
+ 
+ Within in the matlab shell we can then invoke the algorithm by 
+ [tau, s] = contin(t, y, dy, tau0, tau1, m, alpha)
+ 
+ (t, y, dy) observed data (should be a multi-exponential)
+ (tau, s) is the spectral function unveiling the relaxation times
+ of the observed data. 
+ 
+ y(t) = integral(exp(-t/tau)*s(tau),{tau, tau0, tau1})
+ 
+ alpha is the magnitude of the regularizer
+ m is the number of equidistant intervals for the quadratization
+ of the integral.
+ 
+ The optional grid argument selects a grid equidistant in ln(tau) instead, 
+ y(t) = integral(exp(-t/tau)*s(tau),{ln(tau), ln(tau0), ln(tau1)}), 
+ which needs far fewer points to cover several decades, or passes the 
+ tau grid itself.
+ 
+ The optional opts struct selects the solver engine, opts.solver is 
+ 'spg' (default) for the spectral projected gradient minimizer, 'pgrad' 
+ for the monotone projected gradient, or 'nnls' for the direct active set 
+ solver, which finishes after a bounded number of factorization updates, 
+ g and b are then only constrained to be >= 0. 'gencan' is rejected, the 
+ bundled libool.a corrupts the index set of its active set method. 
+ opts.solver = 'mem' replaces the smoothness regularizer by the entropy 
+ of g relative to the default model opts.model (flat if not given), 
+ alpha^2 weighs the entropy, g stays positive and b is free. It iterates 
+ on the resident Gram matrix only, at the cost of an (m+1) x (m+1) 
+ factorization per Newton step, independent of the number of lags, 
+ opts.tol is its relative decrease at the minimum. 
+ The OOL engines take opts.tol (projected gradient tolerance), opts.nmax 
+ (iteration limit, default 100000), opts.M (memory of the SPG line 
+ search) and the box opts.L <= g, b <= opts.U (default 0 and 100).
+ opts.alpha = 'gcv', 'lcurve' or 'discrepancy' ignores the alpha argument 
+ and selects it from one SVD of the kernel, the optional fourth output 
+ info returns the alpha used together with the scanned criteria, 
+ info.boundary is true if the selected alpha is an end of the scanned 
+ grid, where the criterion has no interior optimum.
+ opts.g0 and opts.b0 start the minimizer from a previous solution on the 
+ same grid instead of a flat distribution, info.iterations tells how many 
+ iterations were needed. opts.ktol > 0 stores only the band of the 
+ kernel above ktol times the maximum of each column, which saves memory 
+ and time on lag grids spanning many decades. opts.htol > 0 stores it 
+ as hierarchical low-rank blocks of relative accuracy htol instead, for 
+ fine tau grids on long correlograms where dense products dominate. 
+ opts.single = true keeps the dense weighted kernel in float, which 
+ halves the memory traffic of every iteration, and refines the result 
+ with the double kernel, so it agrees with the double solve. 
+ opts.rtol > 0 solves in the leading singular vectors of the weighted 
+ kernel above rtol times the largest singular value, info.rank and 
+ info.truncation return the size of that basis and the first singular 
+ value dropped relative to the largest. opts.precondition = true runs SPG 
+ on variables scaled by the Gram diagonal, which equalizes the columns 
+ of short and long tau and of the background, the result is unscaled.
+ opts.threads splits the kernel build, the products and the Gram matrix 
+ of a large kernel (n*m >= PARALLEL_MIN) over that many threads, default 
+ 1, the result does not depend on it. 
+ opts.deadline bounds the wall-clock time of a solve in seconds and 
+ opts.stall stops after that many iterations without a better objective, 
+ for live processing next to the acquisition. g and b are always the 
+ best iterate found, info.status is 0 on convergence, 11 (iteration 
+ limit), 1201 (deadline) or 27 (stalled), info.resolve marks the results 
+ that hit a budget and are worth a re-solve started from them.
+ opts.bootstrap = R solves R replicates of y perturbed with gaussian 
+ noise of variance var on the kernel and Gram matrix of the base solve, 
+ started from its solution and split over opts.threads. info.band holds 
+ one column of g per quantile in opts.levels (default [0.025 0.5 0.975]), 
+ info.peaks the peak positions of g, info.peak_band their quantiles and 
+ info.spread the standard deviation of their logarithm, info.replicates 
+ the replicate distributions, opts.seed fixes the noise.
+ 
+ contin('batch', ...) solves many correlograms at once on all cores, 
+ see mex_batch below, contin('create', ...) returns a handle that keeps 
+ the kernel resident for repeated solves on the same lag grid, see 
+ mex_create, contin('multires', ...) refines the grid from coarse to 
+ fine like contin2.m, see mex_multires, contin('add', ...) and 
+ contin('pooled', ...) pool the counts of one angle on a handle, see 
+ mex_add, contin('global', ...) inverts several angles for one 
+ distribution of the diffusion coefficient, see mex_global.
+ 
+
+------------------------------------------------------------------------------
+*/
+
+#ifdef MATLAB_MEX_FILE
+
+static void parse_options(const mxArray* o, contin_options* opts)
+{
+	if (!mxIsStruct(o))
+		mexErrMsgTxt("opts must be a struct\n");
+	
+	mxArray* field = mxGetField(o, 0, "solver");
+	if (field)
+	{
+		char* name = mxArrayToString(field);
+		if (!name)
+			mexErrMsgTxt("opts.solver must be a string\n");
+		if (strcmp(name, "spg") == 0)
+			opts->solver = SOLVER_SPG;
+		else if (strcmp(name, "nnls") == 0)
+			opts->solver = SOLVER_NNLS;
+		else if (strcmp(name, "pgrad") == 0)
+			opts->solver = SOLVER_PGRAD;
+		else if (strcmp(name, "mem") == 0)
+			opts->solver = SOLVER_MEM;
+		else if (strcmp(name, "gencan") == 0)
+		{
+			mxFree(name);
+			mexErrMsgTxt("opts.solver 'gencan' is not supported, the bundled libool.a corrupts its index set\n");
+		}
+		else
+		{
+			mxFree(name);
+			mexErrMsgTxt("opts.solver must be 'spg', 'nnls', 'pgrad' or 'mem'\n");
+		}
+		mxFree(name);
+	}
+	
+	field = mxGetField(o, 0, "tol");
+	if (field && !mxIsEmpty(field))
+		opts->minimizer.tol = mxGetScalar(field);
+	
+	field = mxGetField(o, 0, "nmax");
+	if (field && !mxIsEmpty(field))
+		opts->minimizer.nmax = (size_t) mxGetScalar(field);
+	
+	field = mxGetField(o, 0, "M");
+	if (field && !mxIsEmpty(field))
+		opts->minimizer.M = (size_t) mxGetScalar(field);
+	
+	field = mxGetField(o, 0, "L");
+	if (field && !mxIsEmpty(field))
+		opts->minimizer.L = mxGetScalar(field);
+	
+	field = mxGetField(o, 0, "U");
+	if (field && !mxIsEmpty(field))
+		opts->minimizer.U = mxGetScalar(field);
+	
+	field = mxGetField(o, 0, "deadline");
+	if (field && !mxIsEmpty(field))
+		opts->minimizer.deadline = mxGetScalar(field);
+	
+	field = mxGetField(o, 0, "stall");
+	if (field && !mxIsEmpty(field))
+		opts->minimizer.stall = (size_t) mxGetScalar(field);
+	
+	field = mxGetField(o, 0, "ktol");
+	if (field && !mxIsEmpty(field))
+		opts->ktol = mxGetScalar(field);
+	
+	field = mxGetField(o, 0, "htol");
+	if (field && !mxIsEmpty(field))
+		opts->htol = mxGetScalar(field);
+	
+	field = mxGetField(o, 0, "single");
+	if (field && !mxIsEmpty(field))
+		opts->single = mxGetScalar(field) != 0;
+	
+	field = mxGetField(o, 0, "rtol");
+	if (field && !mxIsEmpty(field))
+		opts->rtol = mxGetScalar(field);
+	
+	field = mxGetField(o, 0, "precondition");
+	if (field && !mxIsEmpty(field))
+		opts->precondition = mxGetScalar(field) != 0;
+	
+	field = mxGetField(o, 0, "alpha");
+	if (field)
+	{
+		char* name = mxArrayToString(field);
+		if (!name)
+			mexErrMsgTxt("opts.alpha must be a string\n");
+		if (strcmp(name, "fixed") == 0)
+			opts->criterion = ALPHA_FIXED;
+		else if (strcmp(name, "gcv") == 0)
+			opts->criterion = ALPHA_GCV;
+		else if (strcmp(name, "lcurve") == 0)
+			opts->criterion = ALPHA_LCURVE;
+		else if (strcmp(name, "discrepancy") == 0)
+			opts->criterion = ALPHA_DISCREPANCY;
+		else
+		{
+			mxFree(name);
+			mexErrMsgTxt("opts.alpha must be 'fixed', 'gcv', 'lcurve' or 'discrepancy'\n");
+		}
+		mxFree(name);
+	}
+}
+
+/* initial (g, b) from opts.g0 and opts.b0, NULL for a cold start */
+static gsl_vector* warm_start(const mxArray* o, int m)
+{
+	mxArray* g0 = mxGetField(o, 0, "g0");
+	mxArray* b0 = mxGetField(o, 0, "b0");
+	
+	if (!g0 || mxIsEmpty(g0))
+		return NULL;
+	if (mxGetNumberOfElements(g0) != m)
+		mexErrMsgTxt("opts.g0 must have one entry per grid point\n");
+	
+	gsl_vector* x0 = gsl_vector_alloc(m + 1);
+	double* ptr = mxGetPr(g0);
+	int i;
+	for (i = 0; i < m; i++)
+		gsl_vector_set(x0, i, ptr[i]);
+	gsl_vector_set(x0, m, (b0 && !mxIsEmpty(b0)) ? mxGetScalar(b0) : 0.0);
+	
+	return x0;
+}
+
+/* 
+ initial (g, b) of problem k of count from opts.g0, one column per 
+ problem or one for all, and opts.b0, one entry per problem or one for 
+ all, NULL for a cold start
+*/
+static gsl_vector* warm_start_column(const mxArray* o, int m, size_t k, size_t count)
+{
+	mxArray* g0 = mxGetField(o, 0, "g0");
+	mxArray* b0 = mxGetField(o, 0, "b0");
+	
+	if (!g0 || mxIsEmpty(g0))
+		return NULL;
+	
+	size_t ng = mxGetNumberOfElements(g0) / m;
+	size_t nb = b0 ? mxGetNumberOfElements(b0) : 0;
+	if (mxGetNumberOfElements(g0) % m || (ng != 1 && ng != count))
+		mexErrMsgTxt("opts.g0 must have one entry per grid point and one or N columns\n");
+	if (nb > 1 && nb != count)
+		mexErrMsgTxt("opts.b0 must have one or N entries\n");
+	
+	gsl_vector* x0 = gsl_vector_alloc(m + 1);
+	double* ptr = mxGetPr(g0) + (ng > 1 ? k * m : 0);
+	int i;
+	for (i = 0; i < m; i++)
+		gsl_vector_set(x0, i, ptr[i]);
+	gsl_vector_set(x0, m, nb ? mxGetPr(b0)[nb > 1 ? k : 0] : 0.0);
+	
+	return x0;
+}
+
+/* default model of the MEM engine from opts.model, NULL for a flat one */
+static gsl_vector* default_model(const mxArray* o, int m)
+{
+	mxArray* field = mxGetField(o, 0, "model");
+	
+	if (!field || mxIsEmpty(field))
+		return NULL;
+	if (mxGetNumberOfElements(field) != m)
+		mexErrMsgTxt("opts.model must have one entry per grid point\n");
+	
+	gsl_vector* model = gsl_vector_alloc(m);
+	double* ptr = mxGetPr(field);
+	int i;
+	for (i = 0; i < m; i++)
+	{
+		if (!(ptr[i] > 0))
+			mexErrMsgTxt("opts.model must be positive\n");
+		gsl_vector_set(model, i, ptr[i]);
+	}
+	
+	return model;
+}
+
+/* 
+ opts.threads of a single solve splits its products over the worker pool 
+ of contin_threads.c, the pool stays up between calls until the MEX file 
+ is cleared
+*/
+static void mex_exit(void);
+
+static void set_threads(const mxArray* o)
+{
+	int nthreads = 1;
+	mxArray* field = o ? mxGetField(o, 0, "threads") : NULL;
+	if (field && !mxIsEmpty(field))
+		nthreads = (int) mxGetScalar(field);
+	
+	contin_set_threads(nthreads);
+	if (contin_get_threads() > 1)
+		mexAtExit(mex_exit);
+}
+
+static mxArray* vector_to_mx(const gsl_vector* v)
+{
+	mxArray* a = mxCreateDoubleMatrix(v->size, 1, mxREAL);
+	double* ptr = mxGetPr(a);
+	int i;
+	for (i = 0; i < v->size; i++)
+		ptr[i] = gsl_vector_get(v, i);
+	return a;
+}
+
+/* info struct, the alpha used, the outcome and the scanned regularization path */
+static mxArray* info_to_mx(const contin_options* opts, int status)
+{
+	const char* fields[] = {"alpha", "iterations", "status", "resolve", "rank", 
+							"truncation", "boundary", "alphas", "rho", "eta", "gcv", "kappa"};
+	mxArray* info = mxCreateStructMatrix(1, 1, 12, fields);
+	
+	mxSetField(info, 0, "alpha", mxCreateDoubleScalar(opts->alpha));
+	mxSetField(info, 0, "iterations", mxCreateDoubleScalar((double) opts->iterations));
+	mxSetField(info, 0, "status", mxCreateDoubleScalar(status));
+	mxSetField(info, 0, "resolve", mxCreateLogicalScalar(contin_resolve(status)));
+	mxSetField(info, 0, "rank", mxCreateDoubleScalar((double) opts->rank));
+	mxSetField(info, 0, "truncation", mxCreateDoubleScalar(opts->truncation));
+	mxSetField(info, 0, "boundary", mxCreateLogicalScalar(opts->boundary));
+	if (opts->path)
+	{
+		mxSetField(info, 0, "alphas", vector_to_mx(opts->path->alpha));
+		mxSetField(info, 0, "rho",    vector_to_mx(opts->path->rho));
+		mxSetField(info, 0, "eta",    vector_to_mx(opts->path->eta));
+		mxSetField(info, 0, "gcv",    vector_to_mx(opts->path->gcv));
+		mxSetField(info, 0, "kappa",  vector_to_mx(opts->path->kappa));
+	}
+	return info;
+}
+
+/*
+ opts.bootstrap = R also solves R replicates of the data perturbed with 
+ var, opts.levels (default [0.025 0.5 0.975]) and opts.seed (default 1) 
+ set the quantiles of the bands and the noise, NULL without opts.bootstrap
+*/
+static contin_bootstrap* bootstrap_alloc_mx(const mxArray* o, size_t m)
+{
+	mxArray* field = o ? mxGetField(o, 0, "bootstrap") : NULL;
+	if (!field || mxIsEmpty(field) || mxGetScalar(field) < 1)
+		return NULL;
+	size_t R = (size_t) mxGetScalar(field);
+	
+	double defaults[] = {0.025, 0.5, 0.975};
+	gsl_vector_const_view level = gsl_vector_const_view_array(defaults, 3);
+	field = mxGetField(o, 0, "levels");
+	if (field && !mxIsEmpty(field))
+		level = gsl_vector_const_view_array(mxGetPr(field), mxGetNumberOfElements(field));
+	
+	unsigned long seed = 1;
+	field = mxGetField(o, 0, "seed");
+	if (field && !mxIsEmpty(field))
+		seed = (unsigned long) mxGetScalar(field);
+	
+	return contin_bootstrap_alloc(R, m, &level.vector, seed);
+}
+
+/* the rows of M are the columns of the MATLAB matrix */
+static mxArray* rows_to_mx(const gsl_matrix* M)
+{
+	mxArray* a = mxCreateDoubleMatrix(M->size2, M->size1, mxREAL);
+	double* ptr = mxGetPr(a);
+	size_t i, j;
+	for (i = 0; i < M->size1; i++)
+		for (j = 0; j < M->size2; j++)
+			ptr[i * M->size2 + j] = gsl_matrix_get(M, i, j);
+	return a;
+}
+
+static void bootstrap_to_mx(mxArray* info, const contin_bootstrap* bs)
+{
+	const char* fields[] = {"levels", "band", "replicates", "backgrounds", 
+							"peaks", "peak_band", "spread", "failed"};
+	int k;
+	for (k = 0; k < 8; k++)
+		mxAddField(info, fields[k]);
+	
+	mxSetField(info, 0, "levels", vector_to_mx(bs->level));
+	mxSetField(info, 0, "band", rows_to_mx(bs->band));
+	mxSetField(info, 0, "replicates", rows_to_mx(bs->g));
+	mxSetField(info, 0, "backgrounds", vector_to_mx(bs->b));
+	if (bs->peak)
+	{
+		mxSetField(info, 0, "peaks", vector_to_mx(bs->peak));
+		mxSetField(info, 0, "peak_band", rows_to_mx(bs->peak_band));
+		mxSetField(info, 0, "spread", vector_to_mx(bs->spread));
+	}
+	mxSetField(info, 0, "failed", mxCreateDoubleScalar((double) bs->failed));
+}
+
+/*
+------------------------------------------------------------------------------
+
+ batch entry point
+ 
+ [S, G, B, info] = contin('batch', T, Y, VAR, s0, s1, m, alpha, kernel, grid, opts)
+ 
+ T, Y, VAR hold one correlogram per column or per cell, s0, s1, m, alpha 
+ and kernel are scalars shared by all problems or vectors with one entry 
+ per problem, grid and opts are shared. opts.threads sets the number of 
+ threads (default all cores). S and G are m x N matrices, or cell arrays 
+ if m differs between problems, B is 1 x N. info holds alpha, iterations, 
+ status, resolve and boundary of every problem as 1 x N rows.
+
+------------------------------------------------------------------------------
+*/
+
+/* number of problems in a matrix (columns) or a cell array */
+static size_t batch_count(const mxArray* a)
+{
+	return mxIsCell(a) ? mxGetNumberOfElements(a) : mxGetN(a);
+}
+
+/* copy correlogram k of a matrix or a cell array */
+static gsl_vector* batch_column(const mxArray* a, size_t k, const char* name)
+{
+	const double* ptr;
+	size_t n;
+	
+	if (mxIsCell(a))
+	{
+		const mxArray* c = mxGetCell(a, k);
+		if (!c || !mxIsDouble(c))
+			mexErrMsgIdAndTxt("contin:batch", "%s{%d} must be a double vector\n", name, (int) k + 1);
+		ptr = mxGetPr(c);
+		n   = mxGetNumberOfElements(c);
+	}
+	else
+	{
+		n   = mxGetM(a);
+		ptr = mxGetPr(a) + k * n;
+	}
+	
+	gsl_vector* v = gsl_vector_alloc(n);
+	gsl_vector_const_view view = gsl_vector_const_view_array(ptr, n);
+	gsl_vector_memcpy(v, &view.vector);
+	return v;
+}
+
+/* setting k, either shared or one entry per problem */
+static double batch_scalar(const mxArray* a, size_t k, size_t count, const char* name)
+{
+	size_t len = mxGetNumberOfElements(a);
+	if (len == 1)
+		return mxGetScalar(a);
+	if (len != count)
+		mexErrMsgIdAndTxt("contin:batch", "%s must be a scalar or have one entry per problem\n", name);
+	return mxGetPr(a)[k];
+}
+
+static void mex_batch(int nlhs, 
+					  mxArray *plhs[], 
+					  int nrhs, 
+					  const mxArray *prhs[])
+{
+	if (nrhs < 8 || nrhs > 10 || nlhs < 3 || nlhs > 4)
+	{
+		mexErrMsgTxt("Not enough input arguments\n\n"
+				"[S, G, B, info] = contin('batch', T, Y, VAR, s0, s1, m, alpha, kernel, grid, opts)\n"
+				"T, Y, VAR\tone correlogram per column or per cell\n"
+				"s0, s1, m, alpha, kernel\tscalars or one entry per problem\n"
+				"grid, opts\t(optional) as for a single problem, shared,\n"
+				"\topts.threads number of threads (default all cores)\n");
+		return;
+	}
+	
+	size_t count = batch_count(prhs[0]);
+	if (batch_count(prhs[1]) != count || batch_count(prhs[2]) != count)
+		mexErrMsgTxt("T, Y and VAR must hold the same number of correlograms\n");
+	
+	contin_options opts;
+	contin_options_default(&opts);
+	int nthreads = 0;
+	if (nrhs > 9)
+	{
+		parse_options(prhs[9], &opts);
+		mxArray* field = mxGetField(prhs[9], 0, "threads");
+		if (field && !mxIsEmpty(field))
+			nthreads = (int) mxGetScalar(field);
+	}
+	
+	gsl_vector* tau = NULL;
+	int gridType = GRID_LINEAR;
+	if (nrhs > 8 && mxGetNumberOfElements(prhs[8]) > 1)
+	{
+		int mt = mxGetNumberOfElements(prhs[8]);
+		gsl_vector_const_view view = gsl_vector_const_view_array(mxGetPr(prhs[8]), mt);
+		tau = gsl_vector_alloc(mt);
+		gsl_vector_memcpy(tau, &view.vector);
+	}
+	else if (nrhs > 8 && !mxIsEmpty(prhs[8]))
+		gridType = (int) mxGetScalar(prhs[8]);
+	
+	/*
+	 everything MATLAB owns is copied here, the workers only see gsl data
+	*/
+	
+	contin_problem* problems = mxCalloc(count, sizeof(contin_problem));
+	size_t k;
+	int common_m = 1;
+	
+	for (k = 0; k < count; k++)
+	{
+		contin_problem* pr = &problems[k];
+		
+		pr->t   = batch_column(prhs[0], k, "T");
+		pr->y   = batch_column(prhs[1], k, "Y");
+		pr->var = batch_column(prhs[2], k, "VAR");
+		if (pr->y->size != pr->t->size || pr->var->size != pr->t->size)
+			mexErrMsgIdAndTxt("contin:batch", "correlogram %d: t, y and var differ in length\n", (int) k + 1);
+		
+		pr->s0         = batch_scalar(prhs[3], k, count, "s0");
+		pr->s1         = batch_scalar(prhs[4], k, count, "s1");
+		pr->m          = (int) batch_scalar(prhs[5], k, count, "m");
+		pr->alpha      = batch_scalar(prhs[6], k, count, "alpha");
+		pr->kernelType = (int) batch_scalar(prhs[7], k, count, "kernel");
+		pr->gridType   = gridType;
+		pr->tau        = tau;
+		if (tau)
+			pr->m = tau->size;
+		if (!tau && gridType == GRID_LOG && pr->s0 <= 0)
+			mexErrMsgTxt("logarithmic grid needs s0 > 0\n");
+		
+		pr->opts = opts;
+		if (opts.criterion != ALPHA_FIXED)
+			pr->opts.path = regularization_path_alloc(ALPHA_GRID_SIZE);
+		
+		pr->s = gsl_vector_alloc(pr->m);
+		pr->g = gsl_vector_alloc(pr->m);
+		
+		if (pr->m != problems[0].m)
+			common_m = 0;
+	}
+	
+	int failed = contin_batch(problems, count, nthreads);
+	printf("Solved %lu inversions, %d without convergence", (unsigned long) count, failed);
+	
+	/*
+	 stack the results
+	*/
+	
+	mxArray* info = NULL;
+	double *ptr_alpha = NULL, *ptr_iter = NULL, *ptr_status = NULL;
+	mxLogical *ptr_resolve = NULL, *ptr_boundary = NULL;
+	if (nlhs > 3)
+	{
+		const char* fields[] = {"alpha", "iterations", "status", "resolve", "boundary"};
+		info = mxCreateStructMatrix(1, 1, 5, fields);
+		mxArray* a = mxCreateDoubleMatrix(1, count, mxREAL);
+		mxArray* it = mxCreateDoubleMatrix(1, count, mxREAL);
+		mxArray* st = mxCreateDoubleMatrix(1, count, mxREAL);
+		mxArray* rs = mxCreateLogicalMatrix(1, count);
+		mxArray* bd = mxCreateLogicalMatrix(1, count);
+		ptr_alpha    = mxGetPr(a);
+		ptr_iter     = mxGetPr(it);
+		ptr_status   = mxGetPr(st);
+		ptr_resolve  = mxGetLogicals(rs);
+		ptr_boundary = mxGetLogicals(bd);
+		mxSetField(info, 0, "alpha", a);
+		mxSetField(info, 0, "iterations", it);
+		mxSetField(info, 0, "status", st);
+		mxSetField(info, 0, "resolve", rs);
+		mxSetField(info, 0, "boundary", bd);
+		plhs[3] = info;
+	}
+	
+	int m0 = count ? problems[0].m : 0;
+	if (common_m)
+	{
+		plhs[0] = mxCreateDoubleMatrix(m0, count, mxREAL);
+		plhs[1] = mxCreateDoubleMatrix(m0, count, mxREAL);
+	}
+	else
+	{
+		plhs[0] = mxCreateCellMatrix(1, count);
+		plhs[1] = mxCreateCellMatrix(1, count);
+	}
+	plhs[2] = mxCreateDoubleMatrix(1, count, mxREAL);
+	double* ptr_b = mxGetPr(plhs[2]);
+	
+	int i;
+	for (k = 0; k < count; k++)
+	{
+		contin_problem* pr = &problems[k];
+		double *ptr_s, *ptr_g;
+		
+		if (common_m)
+		{
+			ptr_s = mxGetPr(plhs[0]) + k * m0;
+			ptr_g = mxGetPr(plhs[1]) + k * m0;
+		}
+		else
+		{
+			mxArray* cs = mxCreateDoubleMatrix(pr->m, 1, mxREAL);
+			mxArray* cg = mxCreateDoubleMatrix(pr->m, 1, mxREAL);
+			mxSetCell(plhs[0], k, cs);
+			mxSetCell(plhs[1], k, cg);
+			ptr_s = mxGetPr(cs);
+			ptr_g = mxGetPr(cg);
+		}
+		
+		for (i = 0; i < pr->m; i++)
+		{
+			ptr_s[i] = gsl_vector_get(pr->s, i);
+			ptr_g[i] = gsl_vector_get(pr->g, i);
+		}
+		ptr_b[k] = pr->b;
+		
+		if (info)
+		{
+			ptr_alpha[k]  = pr->opts.alpha;
+			ptr_iter[k]   = (double) pr->opts.iterations;
+			ptr_status[k] = pr->status;
+			ptr_resolve[k] = contin_resolve(pr->status);
+			ptr_boundary[k] = pr->opts.boundary;
+		}
+		
+		gsl_vector_free(pr->t);
+		gsl_vector_free(pr->y);
+		gsl_vector_free(pr->var);
+		gsl_vector_free(pr->s);
+		gsl_vector_free(pr->g);
+		if (pr->opts.path)
+			regularization_path_free(pr->opts.path);
+	}
+	
+	if (tau)
+		gsl_vector_free(tau);
+	mxFree(problems);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ persistent handles
+ 
+ h = contin('create', t, s0, s1, m, kernel, grid, opts)
+ [s, g, b, info] = contin('solve', h, y, var, alpha, opts)
+ [S, G, B, info] = contin('solvemany', h, Y, VAR, alpha, opts)
+ contin('destroy', h), contin('destroy') releases all handles
+ 
+ the handles live in malloc'ed memory that survives between MEX calls, 
+ create returns the existing handle for an identical lag grid, tau grid, 
+ kernel, opts.ktol and opts.htol unless counts were pooled on it, each 
+ create has to be matched by a destroy before the handle is freed, 
+ solvemany takes one correlogram per column or cell like the batch entry 
+ point and alpha as a scalar or one entry per problem
+ 
+ opts of solve and solvemany are those of a single solve. opts.g0 and 
+ opts.b0 start every correlogram from the same (g, b), or from its own 
+ column of an m x N opts.g0 and entry of opts.b0. opts.bootstrap is only 
+ taken for a single correlogram, opts.single only by a solve without a 
+ handle, the weighted kernel of a handle stays in double
+
+------------------------------------------------------------------------------
+*/
+
+/* the handles and the worker pool go when the MEX file is cleared */
+static void mex_exit(void)
+{
+	contin_handle_destroy_all();
+	contin_set_threads(1);
+}
+
+static contin_handle* handle_get(const mxArray* a)
+{
+	contin_handle* h = contin_handle_lookup((int) mxGetScalar(a));
+	if (!h)
+		mexErrMsgTxt("invalid contin handle\n");
+	return h;
+}
+
+static void mex_create(int nlhs, 
+					   mxArray *plhs[], 
+					   int nrhs, 
+					   const mxArray *prhs[])
+{
+	if (nrhs < 5 || nrhs > 7 || nlhs > 1)
+	{
+		mexErrMsgTxt("Not enough input arguments\n\n"
+				"h = contin('create', t, s0, s1, m, kernel, grid, opts)\n");
+		return;
+	}
+	
+	contin_options opts;
+	contin_options_default(&opts);
+	if (nrhs > 6)
+		parse_options(prhs[6], &opts);
 	
-	C.n = nn;
-	C.L = gsl_vector_alloc( C.n );
-	C.U = gsl_vector_alloc( C.n );
+	int n = mxGetNumberOfElements(prhs[0]);
+	gsl_vector_const_view t = gsl_vector_const_view_array(mxGetPr(prhs[0]), n);
+	
+	double s0      = mxGetScalar(prhs[1]);
+	double s1      = mxGetScalar(prhs[2]);
+	int m          = (int) mxGetScalar(prhs[3]);
+	int kernelType = (int) mxGetScalar(prhs[4]);
+	int gridType   = GRID_LINEAR;
+	
+	gsl_vector* tau;
+	if (nrhs > 5 && mxGetNumberOfElements(prhs[5]) > 1)
+	{
+		/* user supplied grid, integrated in ln(s) */
+		m = mxGetNumberOfElements(prhs[5]);
+		gsl_vector_const_view view = gsl_vector_const_view_array(mxGetPr(prhs[5]), m);
+		tau = gsl_vector_alloc(m);
+		gsl_vector_memcpy(tau, &view.vector);
+		gridType = GRID_LOG;
+	}
+	else
+	{
+		if (nrhs > 5 && !mxIsEmpty(prhs[5]))
+			gridType = (int) mxGetScalar(prhs[5]);
+		if (gridType == GRID_LOG && s0 <= 0)
+			mexErrMsgTxt("logarithmic grid needs s0 > 0\n");
+		tau = gsl_vector_alloc(m);
+		tau_grid(s0, s1, gridType, tau);
+	}
+	
+	gsl_vector* tcopy = gsl_vector_alloc(n);
+	gsl_vector_memcpy(tcopy, &t.vector);
+	int id = contin_handle_create(tcopy, tau, gridType, kernelType, opts.ktol, opts.htol);
+	gsl_vector_free(tcopy);
+	gsl_vector_free(tau);
+	
+	mexAtExit(mex_exit);
+	plhs[0] = mxCreateDoubleScalar(id);
+}
 
-	gsl_vector_set_all( C.L,    0.0 );
-	gsl_vector_set_all( C.U,  100.0 );
+static void mex_destroy(int nlhs, 
+						mxArray *plhs[], 
+						int nrhs, 
+						const mxArray *prhs[])
+{
+	if (nrhs == 0)
+	{
+		contin_handle_destroy_all();
+		return;
+	}
 	
-	/* 
-	 these two lines allocate and set the initial iterate 
-	*/
+	handle_get(prhs[0]);
+	contin_handle_destroy((int) mxGetScalar(prhs[0]));
+}
+
+static void mex_solve_many(int nlhs, 
+						   mxArray *plhs[], 
+						   int nrhs, 
+						   const mxArray *prhs[])
+{
+	if (nrhs < 4 || nrhs > 5 || nlhs < 3 || nlhs > 4)
+	{
+		mexErrMsgTxt("Not enough input arguments\n\n"
+				"[s, g, b, info] = contin('solve', h, y, var, alpha, opts)\n"
+				"[S, G, B, info] = contin('solvemany', h, Y, VAR, alpha, opts)\n");
+		return;
+	}
 	
-	X = gsl_vector_alloc( nn );
-	gsl_vector_set_all( X, 1.0 );
-	/* we better set the background parameter to 0 */
-	gsl_vector_set(X, X->size - 1, 0);
+	contin_handle* h = handle_get(prhs[0]);
+	int n = h->p->t->size;
+	int m = h->p->tau->size;
 	
+	/* a single correlogram may be given as a row or a column */
+	size_t count = mxIsCell(prhs[1]) || mxGetM(prhs[1]) > 1 ? batch_count(prhs[1]) : 1;
+	if (batch_count(prhs[2]) != batch_count(prhs[1]))
+		mexErrMsgTxt("Y and VAR must hold the same number of correlograms\n");
 	
-	/*
-	 allocate the necessary memory for an instance of the
-	 optimization algorithm of type T. Initializes its parameters 
-	 to default values. If the you want to tune the method by 
-	 changing the default values to some parameter this should 
-	 be done 
-	*/
+	contin_options opts;
+	contin_options_default(&opts);
+	const mxArray* o = nrhs > 4 ? prhs[4] : NULL;
+	if (o)
+		parse_options(o, &opts);
+	if (opts.single)
+		mexErrMsgTxt("opts.single is not supported with a handle, its kernel stays in double\n");
 	
-	M = ool_conmin_minimizer_alloc( T, nn );
-	ool_conmin_parameters_default( T, (void*)(&P) );
+	gsl_vector* model = o ? default_model(o, m) : NULL;
+	opts.model = model;
 	
-	/*
-	 everything is put together. It states that this instance of 
-	 the method M is responsible for minimizing function F, subject 
-	 to constraints C, starting from point X, with parameters P. 
-	*/
+	contin_bootstrap* bs = bootstrap_alloc_mx(o, m);
+	if (bs && count > 1)
+	{
+		contin_bootstrap_free(bs);
+		if (model)
+			gsl_vector_free(model);
+		mexErrMsgTxt("opts.bootstrap takes a single correlogram, use 'solve'\n");
+	}
+	set_threads(o);
+	if (opts.criterion != ALPHA_FIXED)
+		opts.path = regularization_path_alloc(ALPHA_GRID_SIZE);
 	
-	ool_conmin_minimizer_set( M, &F, &C, X, (void*)(&P) );
+	plhs[0] = mxCreateDoubleMatrix(m, count, mxREAL);
+	plhs[1] = mxCreateDoubleMatrix(m, count, mxREAL);
+	plhs[2] = mxCreateDoubleMatrix(1, count, mxREAL);
 	
-	/*
-	 The iteration counter is initialized and some information
-	 concerning the initial point is displayed. The iteration 
-	 loop is repeated while the maximum number of iterations was not reached
-	 and the status is OOL_CONTINUE. Further conditions could also be 
-	 considered (maximum number of function/gradient evaluation for example).
-	 The iteration counter is incremented and one single iteration of the 
-	 method is performed. Current iterate is checked for optimality. 
-	 Finally some information concerning this iteration is displayed. 
-	*/
+	mxArray* a  = mxCreateDoubleMatrix(1, count, mxREAL);
+	mxArray* it = mxCreateDoubleMatrix(1, count, mxREAL);
+	mxArray* st = mxCreateDoubleMatrix(1, count, mxREAL);
+	mxArray* rs = mxCreateLogicalMatrix(1, count);
 	
-	ii = 0;
-	status = OOL_CONTINUE;
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g = gsl_vector_alloc(m);
+	size_t k, nsetup = h->nsetup;
+	int i, failed = 0;
 	
-	/*printf( "%4i : ", ii );
-		iteration_echo ( M );
-	printf( "\n" );			*/
-
-	while( ii < nmax && status == OOL_CONTINUE )
+	for (k = 0; k < count; k++)
 	{
-		ii++;
-		ool_conmin_minimizer_iterate( M );
-		status = ool_conmin_is_optimal( M );
-
-	/*	if( ii % 100 == 0 )
+		gsl_vector* y;
+		gsl_vector* var;
+		if (count == 1 && !mxIsCell(prhs[1]))
 		{
-			printf( "%4i ", ii );
-			iteration_echo( M );
-		}					*/
+			gsl_vector_const_view vy = gsl_vector_const_view_array(mxGetPr(prhs[1]), mxGetNumberOfElements(prhs[1]));
+			gsl_vector_const_view vv = gsl_vector_const_view_array(mxGetPr(prhs[2]), mxGetNumberOfElements(prhs[2]));
+			y   = gsl_vector_alloc(vy.vector.size);
+			var = gsl_vector_alloc(vv.vector.size);
+			gsl_vector_memcpy(y, &vy.vector);
+			gsl_vector_memcpy(var, &vv.vector);
+		}
+		else
+		{
+			y   = batch_column(prhs[1], k, "Y");
+			var = batch_column(prhs[2], k, "VAR");
+		}
+		
+		double b;
+		double alpha = batch_scalar(prhs[3], k, count, "alpha");
+		gsl_vector* x0 = o ? warm_start_column(o, m, k, count) : NULL;
+		opts.x0 = x0;
+		int status = bs ? contin_handle_bootstrap(h, y, var, alpha, &opts, s, g, &b, bs) 
+						: contin_handle_solve(h, y, var, alpha, &opts, s, g, &b);
+		gsl_vector_free(y);
+		gsl_vector_free(var);
+		if (x0)
+			gsl_vector_free(x0);
+		opts.x0 = NULL;
+		
+		if (status == OOL_EBADLEN)
+		{
+			gsl_vector_free(s);
+			gsl_vector_free(g);
+			if (model)
+				gsl_vector_free(model);
+			if (bs)
+				contin_bootstrap_free(bs);
+			if (opts.path)
+				regularization_path_free(opts.path);
+			mexErrMsgIdAndTxt("contin:solve", "correlogram %d does not match the %d lags of the handle\n", (int) k + 1, n);
+		}
+		if (status != OOL_SUCCESS)
+			failed++;
+		
+		double* ptr_s = mxGetPr(plhs[0]) + k * m;
+		double* ptr_g = mxGetPr(plhs[1]) + k * m;
+		for (i = 0; i < m; i++)
+		{
+			ptr_s[i] = gsl_vector_get(s, i);
+			ptr_g[i] = gsl_vector_get(g, i);
+		}
+		mxGetPr(plhs[2])[k] = b;
+		mxGetPr(a)[k]  = opts.alpha;
+		mxGetPr(it)[k] = (double) opts.iterations;
+		mxGetPr(st)[k] = status;
+		mxGetLogicals(rs)[k] = contin_resolve(status);
 	}
 	
-	if(status == OOL_SUCCESS)
-		printf("Convergence in %i iterations", ii);
+	printf("Solved %lu inversions, %d without convergence, %lu kernel setups", 
+		   (unsigned long) count, failed, (unsigned long) (h->nsetup - nsetup));
+	
+	if (nlhs > 3)
+	{
+		const char* fields[] = {"alpha", "iterations", "status", "resolve"};
+		plhs[3] = mxCreateStructMatrix(1, 1, 4, fields);
+		mxSetField(plhs[3], 0, "alpha", a);
+		mxSetField(plhs[3], 0, "iterations", it);
+		mxSetField(plhs[3], 0, "status", st);
+		mxSetField(plhs[3], 0, "resolve", rs);
+		if (bs)
+			bootstrap_to_mx(plhs[3], bs);
+	}
 	else
-		printf("Stopped with %i iterations", ii);
+	{
+		mxDestroyArray(a);
+		mxDestroyArray(it);
+		mxDestroyArray(st);
+		mxDestroyArray(rs);
+	}
+	
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	if (model)
+		gsl_vector_free(model);
+	if (bs)
+		contin_bootstrap_free(bs);
+	if (opts.path)
+		regularization_path_free(opts.path);
+}
 
-/*	printf( "\nvariables................: %6i"
-			"\nfunction evaluations.....: %6i"
-			"\ngradient evaluations.....: %6i"
-			"\nfunction value...........: % .6e"
-			"\nprojected gradient norm..: % .6e\n",
-			nn,
-			ool_conmin_minimizer_fcount( M ),
-			ool_conmin_minimizer_gcount( M ),
-			ool_conmin_minimizer_minimum( M ),
-			ool_conmin_minimizer_size( M ));	*/
+/*
+------------------------------------------------------------------------------
 
-	gsl_vector_memcpy(s, p->tau);
-	int i;
-	for (i = 0; i < g->size; i++)
-		gsl_vector_set(g, i, gsl_vector_get(M->x, i));
-	*b =  gsl_vector_get(M->x, m);
+ n = contin('add', h, Y, VAR)
+ [s, g, b, info] = contin('pooled', h, alpha, opts)
+ contin('reset', h)
+ 
+ the counts of one angle pooled on a handle with a dense kernel, add 
+ keeps only the sufficient statistics of one or more correlograms (as 
+ columns or cells like solvemany) and returns how many were added so 
+ far, pooled solves all of them from the Gram matrix, started from the 
+ previous pooled solution, info.chi2 is their summed weighted residual, 
+ reset forgets them, see contin_accumulate.c
+
+------------------------------------------------------------------------------
+*/
+
+static void mex_add(int nlhs, 
+					mxArray *plhs[], 
+					int nrhs, 
+					const mxArray *prhs[])
+{
+	if (nrhs != 3 || nlhs > 1)
+	{
+		mexErrMsgTxt("Not enough input arguments\n\n"
+				"n = contin('add', h, Y, VAR)\n");
+		return;
+	}
 	
-	gsl_vector_free( C.L );
-	gsl_vector_free( C.U );
-	gsl_vector_free( X );
+	contin_handle* h = handle_get(prhs[0]);
+	int n = h->p->t->size;
+	size_t k, count = mxIsCell(prhs[1]) || mxGetM(prhs[1]) > 1 ? batch_count(prhs[1]) : 1;
+	if (batch_count(prhs[2]) != batch_count(prhs[1]))
+		mexErrMsgTxt("Y and VAR must hold the same number of correlograms\n");
+	if (!h->p->K)
+		mexErrMsgTxt("pooling needs a handle with a dense kernel, ktol = htol = 0\n");
+	
+	for (k = 0; k < count; k++)
+	{
+		int status;
+		if (count == 1 && !mxIsCell(prhs[1]))
+		{
+			gsl_vector_const_view vy = gsl_vector_const_view_array(mxGetPr(prhs[1]), mxGetNumberOfElements(prhs[1]));
+			gsl_vector_const_view vv = gsl_vector_const_view_array(mxGetPr(prhs[2]), mxGetNumberOfElements(prhs[2]));
+			status = contin_handle_add(h, &vy.vector, &vv.vector);
+		}
+		else
+		{
+			gsl_vector* y   = batch_column(prhs[1], k, "Y");
+			gsl_vector* var = batch_column(prhs[2], k, "VAR");
+			status = contin_handle_add(h, y, var);
+			gsl_vector_free(y);
+			gsl_vector_free(var);
+		}
+		if (status == OOL_EBADLEN)
+			mexErrMsgIdAndTxt("contin:add", "correlogram %d does not match the %d lags of the handle\n", (int) k + 1, n);
+		if (status == OOL_EINVAL)
+			mexErrMsgIdAndTxt("contin:add", "the handle is shared by %d creates, pooling needs one of its own\n", h->refs);
+	}
+	
+	plhs[0] = mxCreateDoubleScalar((double) h->acc->count);
+}
 
-	ool_conmin_minimizer_free( M );
+static void mex_pooled(int nlhs, 
+					   mxArray *plhs[], 
+					   int nrhs, 
+					   const mxArray *prhs[])
+{
+	if (nrhs < 2 || nrhs > 3 || nlhs < 3 || nlhs > 4)
+	{
+		mexErrMsgTxt("Not enough input arguments\n\n"
+				"[s, g, b, info] = contin('pooled', h, alpha, opts)\n");
+		return;
+	}
+	
+	contin_handle* h = handle_get(prhs[0]);
+	int m = h->p->tau->size;
+	if (!h->acc || h->acc->count == 0)
+		mexErrMsgTxt("no counts added to the handle, see contin('add', ...)\n");
+	
+	contin_options opts;
+	contin_options_default(&opts);
+	if (nrhs > 2)
+		parse_options(prhs[2], &opts);
+	if (opts.criterion != ALPHA_FIXED)
+		opts.path = regularization_path_alloc(ALPHA_GRID_SIZE);
+	
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g = gsl_vector_alloc(m);
+	gsl_vector* x0 = nrhs > 2 ? warm_start(prhs[2], m) : NULL;
+	gsl_vector* model = nrhs > 2 ? default_model(prhs[2], m) : NULL;
+	opts.x0 = x0;
+	opts.model = model;
 	
-	return OOL_SUCCESS;
+	double b;
+	int status = contin_handle_pooled(h, mxGetScalar(prhs[1]), &opts, s, g, &b);
+	
+	plhs[0] = vector_to_mx(s);
+	plhs[1] = vector_to_mx(g);
+	plhs[2] = mxCreateDoubleScalar(b);
+	if (nlhs > 3)
+	{
+		plhs[3] = info_to_mx(&opts, status);
+		mxAddField(plhs[3], "counts");
+		mxAddField(plhs[3], "chi2");
+		mxSetField(plhs[3], 0, "counts", mxCreateDoubleScalar((double) h->acc->count));
+		mxSetField(plhs[3], 0, "chi2", mxCreateDoubleScalar(h->acc->chi2));
+	}
+	
+	if (opts.path)
+		regularization_path_free(opts.path);
+	if (x0)
+		gsl_vector_free(x0);
+	if (model)
+		gsl_vector_free(model);
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+}
+
+static void mex_reset(int nlhs, 
+					  mxArray *plhs[], 
+					  int nrhs, 
+					  const mxArray *prhs[])
+{
+	if (nrhs != 1)
+	{
+		mexErrMsgTxt("Not enough input arguments\n\n"
+				"contin('reset', h)\n");
+		return;
+	}
 	
+	contin_handle* h = handle_get(prhs[0]);
+	if (h->acc)
+		contin_accumulator_reset(h->acc);
 }
 
 /*
 ------------------------------------------------------------------------------
 
- Matlab wrapper
- 
- to produce a matlab executable we have to compile this file
- with: mex -lool -lgsl -lgslcblas -lm contin.c
- 
- Within in the matlab shell we can then invoke the algorithm by 
- [tau, s] = contin(t, y, dy, tau0, tau1, m, alpha)
+ coarse-to-fine entry point, the levels of contin2.m in the native solver
  
- (t, y, dy) observed data (should be a multi-exponential)
- (tau, s) is the spectral function unveiling the relaxation times
- of the observed data. 
+ [s, g, b, info] = contin('multires', t, y, var, s0, s1, m, alpha, cycles, kernel, opts)
  
- y(t) = integral(exp(-t/tau)*s(tau),{tau, tau0, tau1})
+ solves on m, m + 20, ..., m + 20*(cycles - 1) points of a logarithmic 
+ grid between s0 and s1, every level started from the one below, and 
+ skips the finer levels once a level changes g by less than opts.mtol 
+ (default 1e-3) relative to its norm. alpha holds for the finest grid, 
+ coarser levels get it scaled to their spacing, see contin_multires.c. 
+ s and g are on the finest grid, info.levels tells how many levels were 
+ solved
+
+------------------------------------------------------------------------------
+*/
+
+static gsl_vector* mx_to_vector(const mxArray* a)
+{
+	size_t n = mxGetNumberOfElements(a);
+	gsl_vector_const_view v = gsl_vector_const_view_array(mxGetPr(a), n);
+	gsl_vector* x = gsl_vector_alloc(n);
+	gsl_vector_memcpy(x, &v.vector);
+	return x;
+}
+
+static void mex_multires(int nlhs, 
+						 mxArray *plhs[], 
+						 int nrhs, 
+						 const mxArray *prhs[])
+{
+	if (nrhs < 8 || nrhs > 10 || nlhs < 2 || nlhs > 4)
+	{
+		mexErrMsgTxt("Not enough input arguments\n\n"
+				"[s, g, b, info] = contin('multires', t, y, var, s0, s1, m, alpha, cycles, kernel, opts)\n");
+		return;
+	}
+	
+	size_t n = mxGetNumberOfElements(prhs[0]);
+	if (mxGetNumberOfElements(prhs[1]) != n || mxGetNumberOfElements(prhs[2]) != n)
+		mexErrMsgTxt("t, y and var differ in length\n");
+	
+	double s0      = mxGetScalar(prhs[3]);
+	double s1      = mxGetScalar(prhs[4]);
+	int m          = (int) mxGetScalar(prhs[5]);
+	double alpha   = mxGetScalar(prhs[6]);
+	int cycles     = (int) mxGetScalar(prhs[7]);
+	int kernelType = nrhs > 8 && !mxIsEmpty(prhs[8]) ? (int) mxGetScalar(prhs[8]) : 0;
+	double tol     = MULTIRES_TOL;
+	
+	if (s0 <= 0 || s1 <= s0)
+		mexErrMsgTxt("logarithmic grid needs 0 < s0 < s1\n");
+	if (m < 2 || cycles < 1)
+		mexErrMsgTxt("m must be at least 2 and cycles at least 1\n");
+	
+	contin_options opts;
+	contin_options_default(&opts);
+	if (nrhs > 9)
+	{
+		parse_options(prhs[9], &opts);
+		mxArray* field = mxGetField(prhs[9], 0, "mtol");
+		if (field && !mxIsEmpty(field))
+			tol = mxGetScalar(field);
+	}
+	if (opts.criterion != ALPHA_FIXED)
+		mexErrMsgTxt("opts.alpha must be 'fixed' for 'multires'\n");
+	set_threads(nrhs > 9 ? prhs[9] : NULL);
+	
+	gsl_vector* t   = mx_to_vector(prhs[0]);
+	gsl_vector* y   = mx_to_vector(prhs[1]);
+	gsl_vector* var = mx_to_vector(prhs[2]);
+	
+	int mf = m + MULTIRES_STEP * (cycles - 1);
+	gsl_vector* s = gsl_vector_alloc(mf);
+	gsl_vector* g = gsl_vector_alloc(mf);
+	double b;
+	int levels;
+	
+	int status = contin_multires(t, y, var, alpha, s0, s1, m, cycles, kernelType, tol, 
+								 &opts, s, g, &b, &levels);
+	printf("%d of %d levels, %lu iterations", levels, cycles, (unsigned long) opts.iterations);
+	
+	plhs[0] = vector_to_mx(s);
+	plhs[1] = vector_to_mx(g);
+	if (nlhs > 2)
+		plhs[2] = mxCreateDoubleScalar(b);
+	if (nlhs > 3)
+	{
+		const char* fields[] = {"iterations", "status", "levels"};
+		plhs[3] = mxCreateStructMatrix(1, 1, 3, fields);
+		mxSetField(plhs[3], 0, "iterations", mxCreateDoubleScalar((double) opts.iterations));
+		mxSetField(plhs[3], 0, "status", mxCreateDoubleScalar(status));
+		mxSetField(plhs[3], 0, "levels", mxCreateDoubleScalar(levels));
+	}
+	
+	gsl_vector_free(t);
+	gsl_vector_free(y);
+	gsl_vector_free(var);
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ global entry point
  
- alpha is the magnitude of the regularizer
- m is the number of equidistant intervals for the quadratization
- of the integral.
+ [D, g, a, b, info] = contin('global', T, Y, VAR, q2, D0, D1, m, alpha, opts)
  
+ T, Y, VAR hold one correlogram per angle per column or per cell, q2 has 
+ one q^2 per angle in the units of 1/(D*t). All angles share g on a 
+ logarithmic grid of m points between D0 and D1, a are their amplitudes 
+ (mean 1), b their baselines, info.chi2 their weighted residuals and 
+ info.passes the amplitude passes. opts as for a single solve, opts.g0 
+ starts from a previous g, opts.solver = 'nnls' is the fastest on the 
+ summed blocks
 
 ------------------------------------------------------------------------------
 */
 
-#ifdef MATLAB_MEX_FILE
+static void mex_global(int nlhs, 
+					   mxArray *plhs[], 
+					   int nrhs, 
+					   const mxArray *prhs[])
+{
+	if (nrhs < 8 || nrhs > 9 || nlhs < 2 || nlhs > 5)
+	{
+		mexErrMsgTxt("Not enough input arguments\n\n"
+				"[D, g, a, b, info] = contin('global', T, Y, VAR, q2, D0, D1, m, alpha, opts)\n");
+		return;
+	}
+	
+	size_t count = batch_count(prhs[0]);
+	if (batch_count(prhs[1]) != count || batch_count(prhs[2]) != count 
+		|| mxGetNumberOfElements(prhs[3]) != count)
+		mexErrMsgTxt("T, Y, VAR and q2 must hold the same number of angles\n");
+	
+	double D0    = mxGetScalar(prhs[4]);
+	double D1    = mxGetScalar(prhs[5]);
+	int m        = (int) mxGetScalar(prhs[6]);
+	double alpha = mxGetScalar(prhs[7]);
+	if (D0 <= 0 || D1 <= D0)
+		mexErrMsgTxt("logarithmic grid needs 0 < D0 < D1\n");
+	if (m < 2)
+		mexErrMsgTxt("m must be at least 2\n");
+	
+	contin_options opts;
+	contin_options_default(&opts);
+	gsl_vector* x0 = NULL;
+	gsl_vector* model = NULL;
+	if (nrhs > 8)
+	{
+		parse_options(prhs[8], &opts);
+		x0 = warm_start(prhs[8], m);
+		if (x0)
+			gsl_vector_set(x0, m, 0);
+		model = default_model(prhs[8], m);
+	}
+	opts.x0 = x0;
+	opts.model = model;
+	if (opts.criterion != ALPHA_FIXED)
+		mexErrMsgTxt("opts.alpha must be 'fixed' for 'global'\n");
+	set_threads(nrhs > 8 ? prhs[8] : NULL);
+	
+	gsl_vector* D = gsl_vector_alloc(m);
+	tau_grid(D0, D1, GRID_LOG, D);
+	contin_global* gl = contin_global_alloc(D, GRID_LOG);
+	
+	size_t k;
+	for (k = 0; k < count; k++)
+	{
+		gsl_vector* t   = batch_column(prhs[0], k, "T");
+		gsl_vector* y   = batch_column(prhs[1], k, "Y");
+		gsl_vector* var = batch_column(prhs[2], k, "VAR");
+		int status = contin_global_add(gl, t, y, var, mxGetPr(prhs[3])[k]);
+		gsl_vector_free(t);
+		gsl_vector_free(y);
+		gsl_vector_free(var);
+		if (status != GSL_SUCCESS)
+		{
+			contin_global_free(gl);
+			gsl_vector_free(D);
+			mexErrMsgIdAndTxt("contin:global", "angle %d: t, y and var differ in length or q2 <= 0\n", (int) k + 1);
+		}
+	}
+	
+	gsl_vector* g = gsl_vector_alloc(m);
+	int status = contin_global_solve(gl, alpha, &opts, D, g);
+	printf("%lu angles, %lu amplitude passes, %lu iterations", (unsigned long) count, 
+		   (unsigned long) gl->passes, (unsigned long) opts.iterations);
+	
+	plhs[0] = vector_to_mx(D);
+	plhs[1] = vector_to_mx(g);
+	if (nlhs > 2)
+		plhs[2] = vector_to_mx(gl->a);
+	if (nlhs > 3)
+		plhs[3] = vector_to_mx(gl->b);
+	if (nlhs > 4)
+	{
+		plhs[4] = info_to_mx(&opts, status);
+		mxAddField(plhs[4], "passes");
+		mxAddField(plhs[4], "chi2");
+		mxSetField(plhs[4], 0, "passes", mxCreateDoubleScalar((double) gl->passes));
+		mxSetField(plhs[4], 0, "chi2", vector_to_mx(gl->chi2));
+	}
+	
+	if (x0)
+		gsl_vector_free(x0);
+	if (model)
+		gsl_vector_free(model);
+	gsl_vector_free(D);
+	gsl_vector_free(g);
+	contin_global_free(gl);
+}
 
 void mexFunction(int nlhs, 
 				 mxArray *plhs[], 
 				 int nrhs, 
 				 const mxArray *prhs[])
 {
-	if(nrhs =! 8 || nlhs!= 3)
+	/* contin('command', ...) selects an entry point other than a single solve */
+	if (nrhs > 0 && mxIsChar(prhs[0]))
+	{
+		char* command = mxArrayToString(prhs[0]);
+		void (*entry)(int, mxArray**, int, const mxArray**) = NULL;
+		
+		if (strcmp(command, "batch") == 0)
+			entry = mex_batch;
+		else if (strcmp(command, "create") == 0)
+			entry = mex_create;
+		else if (strcmp(command, "solve") == 0 || strcmp(command, "solvemany") == 0)
+			entry = mex_solve_many;
+		else if (strcmp(command, "destroy") == 0)
+			entry = mex_destroy;
+		else if (strcmp(command, "multires") == 0)
+			entry = mex_multires;
+		else if (strcmp(command, "add") == 0)
+			entry = mex_add;
+		else if (strcmp(command, "pooled") == 0)
+			entry = mex_pooled;
+		else if (strcmp(command, "reset") == 0)
+			entry = mex_reset;
+		else if (strcmp(command, "global") == 0)
+			entry = mex_global;
+		mxFree(command);
+		
+		if (!entry)
+			mexErrMsgTxt("unknown command, use 'batch', 'create', 'solve', 'solvemany', 'destroy', 'multires', "
+						 "'add', 'pooled', 'reset' or 'global'\n");
+		entry(nlhs, plhs, nrhs - 1, prhs + 1);
+		return;
+	}
+	
+	if(nrhs < 8 || nrhs > 10 || nlhs < 3 || nlhs > 4)
 	{
 		 mexErrMsgTxt("Not enough input arguments\n\n"
-				"[s, g, b] = contin(t, y, var, s0, s1, m, alpha, kernel)\n"
+				"[s, g, b, info] = contin(t, y, var, s0, s1, m, alpha, kernel, grid, opts)\n"
 				"\ncontin minimizes ||y(t) - (∫K(t,s)g(s)ds + b)||\n"
 				"t\ttime-axis of data\n"
 				"y\ty-axis of data\n"
@@ -706,7 +2956,24 @@ void mexFunction(int nlhs,
 				"s1\tlargest possible time constant\n"
 				"m\tnumber of equidistant intervals for quadratization\n"
 				"alpha\tstrength of regularizer\n"
-				"kernel\t0: Multi-exponential, 1: Multi-lorentzian\n");
+				"kernel\t0: Multi-exponential, 1: Multi-lorentzian\n"
+				"grid\t(optional) 0: linear in s (default), 1: logarithmic in s,\n"
+				"\tor a vector of s values (s0, s1, m are then ignored),\n"
+				"\tlogarithmic grids are integrated in ln(s)\n"
+				"opts\t(optional) struct, opts.solver = 'spg' (default), 'pgrad', 'nnls' or 'mem',\n"
+				"\topts.model default model of 'mem', flat if not given,\n"
+				"\topts.tol, opts.nmax, opts.M, opts.L, opts.U tune the minimizer,\n"
+				"\topts.alpha = 'fixed' (default), 'gcv', 'lcurve' or 'discrepancy',\n"
+				"\topts.g0, opts.b0 initial g and b, e.g. a previous solution,\n"
+				"\topts.ktol > 0 drops kernel entries below ktol*column maximum,\n"
+				"\topts.htol > 0 stores the kernel as low-rank blocks of accuracy htol,\n"
+				"\topts.single = true iterates on a float kernel and refines in double,\n"
+				"\topts.rtol > 0 solves in the singular vectors above rtol*s(1),\n"
+				"\topts.precondition = true scales SPG by the Gram diagonal,\n"
+				"\topts.deadline in seconds and opts.stall in iterations bound a solve,\n"
+				"\topts.threads splits the products of a large kernel over threads,\n"
+				"\topts.bootstrap = R adds quantile bands of R noisy replicates to info\n"
+				"info\t(optional) alpha used, outcome and the scanned regularization path\n");
 		return;
 	}
 	
@@ -734,14 +3001,82 @@ void mexFunction(int nlhs,
 	int m          = (int) mxGetScalar(prhs[5]);
 	double alpha   = mxGetScalar(prhs[6]);
 	int kernelType = (int) mxGetScalar(prhs[7]);
+	int gridType   = GRID_LINEAR;
+	
+	contin_options opts;
+	contin_options_default(&opts);
+	if (nrhs > 9)
+		parse_options(prhs[9], &opts);
+	if (opts.criterion != ALPHA_FIXED)
+		opts.path = regularization_path_alloc(ALPHA_GRID_SIZE);
+	set_threads(nrhs > 9 ? prhs[9] : NULL);
+	
+	gsl_vector* tau;
+	if (nrhs > 8 && mxGetNumberOfElements(prhs[8]) > 1)
+	{
+		/* user supplied grid, integrated in ln(s) */
+		m = mxGetNumberOfElements(prhs[8]);
+		gsl_vector_const_view tv = gsl_vector_const_view_array(mxGetPr(prhs[8]), m);
+		tau = gsl_vector_alloc(m);
+		gsl_vector_memcpy(tau, &tv.vector);
+		gridType = GRID_LOG;
+	}
+	else
+	{
+		if (nrhs > 8 && !mxIsEmpty(prhs[8]))
+			gridType = (int) mxGetScalar(prhs[8]);
+		if (gridType == GRID_LOG && s0 <= 0)
+			mexErrMsgTxt("logarithmic grid needs s0 > 0\n");
+		tau = gsl_vector_alloc(m);
+		tau_grid(s0, s1, gridType, tau);
+	}
 	
-	parameter* p = parameter_alloc(t, y, var, alpha, s0, s1, m, kernelType);
+	/* a compressed kernel is built directly, the dense one never exists */
+	parameter* p = parameter_alloc_kernel(t, alpha, tau, gridType, kernelType, opts.ktol, opts.htol);
+	parameter_set_data(p, y, var);
+	parameter_single(p, opts.single);
+	gsl_vector_free(tau);
 	
 	gsl_vector* s = gsl_vector_alloc(m);
 	gsl_vector* g = gsl_vector_alloc(m);
 	
+	gsl_vector* x0 = NULL;
+	gsl_vector* model = NULL;
+	if (nrhs > 9)
+	{
+		x0 = warm_start(prhs[9], m);
+		model = default_model(prhs[9], m);
+	}
+	opts.x0 = x0;
+	opts.model = model;
+	
+	contin_bootstrap* bs = bootstrap_alloc_mx(nrhs > 9 ? prhs[9] : NULL, m);
+	
 	double b;	// background
-	contin(p, s, g, &b);
+	int status = bs ? contin_bootstrap_solve(p, &opts, s, g, &b, bs) : contin_solve(p, &opts, s, g, &b);
+	if (opts.solver == SOLVER_NNLS)
+		printf("NNLS solution after %lu factorization updates", (unsigned long) opts.iterations);
+	else if (opts.solver == SOLVER_MEM && status == OOL_SUCCESS)
+		printf("MEM solution after %lu Newton iterations", (unsigned long) opts.iterations);
+	else if (status == OOL_SUCCESS)
+		printf("Convergence in %lu iterations", (unsigned long) opts.iterations);
+	else if (status == CONTIN_DEADLINE)
+		printf("Deadline after %lu iterations", (unsigned long) opts.iterations);
+	else if (status == OOL_ENOPROG)
+		printf("Stalled after %lu iterations", (unsigned long) opts.iterations);
+	else
+		printf("Stopped with %lu iterations", (unsigned long) opts.iterations);
+	if (x0)
+	{
+		printf(" from warm start");
+		gsl_vector_free(x0);
+	}
+	if (model)
+		gsl_vector_free(model);
+	if (opts.criterion != ALPHA_FIXED)
+		printf(", alpha = %g", opts.alpha);
+	if (bs)
+		printf(", %lu replicates in %lu iterations", (unsigned long) bs->R, (unsigned long) bs->iterations);
 	
 	parameter_free(p);
 	
@@ -749,6 +3084,16 @@ void mexFunction(int nlhs,
 	plhs[0] = mxCreateDoubleMatrix(m, 1, mxREAL); //mxReal is our data-type
 	plhs[1] = mxCreateDoubleMatrix(m, 1, mxREAL); //mxReal is our data-type
 	plhs[2] = mxCreateDoubleScalar(b);
+	if (nlhs > 3)
+		plhs[3] = info_to_mx(&opts, status);
+	if (bs)
+	{
+		if (nlhs > 3)
+			bootstrap_to_mx(plhs[3], bs);
+		contin_bootstrap_free(bs);
+	}
+	if (opts.path)
+		regularization_path_free(opts.path);
 	
 	//Get a pointer to the data space in our newly allocated memory
 
@@ -771,7 +3116,8 @@ void mexFunction(int nlhs,
 }
 #endif
 
-#ifndef MATLAB_MEX_FILE
+/* contin_test.c and contin_bench.c bring their own main */
+#if !defined(MATLAB_MEX_FILE) && !defined(CONTIN_NO_MAIN)
 int main( void )
 {
 	/*
@@ -798,7 +3144,7 @@ int main( void )
 	 compute parameters for the inversion problem	
 	*/
 	
-	parameter* p = parameter_alloc(t, y, sigma, 0.01, 0.1, 4.0, m , 0);
+	parameter* p = parameter_alloc(t, y, sigma, 0.01, 0.1, 4.0, m , 0, GRID_LINEAR);
 	
 	/*
 	release used memory
@@ -837,7 +3183,7 @@ int main( void )
 	
 	gsl_vector_free(X);
 	gsl_vector_free(G);
-	contin(p, s, g, &b);
+	contin(p, NULL, s, g, &b, NULL);
 	
 	saveData(p->t, p->y, "in.txt");
 	saveData(s,    g, "out.txt");
@@ -0,0 +1,631 @@
+/*
+------------------------------------------------------------------------------
+
+ Marcus Hennig
+ hennig@ill.fr
+
+ Description: declarations shared by the CONTIN solver engines, see contin.c 
+ for the description of the problem
+
+------------------------------------------------------------------------------
+*/
+
+#ifndef CONTIN_H
+#define CONTIN_H
+
+#include <ool/ool_conmin.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_blas.h>
+
+/* the C++ specializations of contin_fixed.cpp share these declarations */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+------------------------------------------------------------------------------
+
+ scratch space for the objective evaluations, allocated once per problem 
+ so that the minimizer iterations do not touch the heap
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	gsl_vector* r;		/* weighted residual, length n */
+	gsl_vector* d2g;	/* second derivative of g, length m */
+	gsl_vector* d4g;	/* fourth derivative of g, length m */
+	gsl_matrix* part;	/* per row block A^T*r of a split product, NULL if not split */
+	gsl_vector* um;		/* c.*x or K^T*(sw.*x) of a product through K, NULL unless single */
+	gsl_vector* un;		/* sw.*x or K*(c.*x), NULL unless single */
+	size_t neval;		/* evaluations served from the scratch space */
+	
+} workspace;
+
+/*
+------------------------------------------------------------------------------
+
+ SVD of the regularized problem in standard form, see contin_alpha.c
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct standard_form
+{
+	gsl_matrix* U;		/* left singular vectors, n x min(n, m) */
+	gsl_vector* s;		/* singular values, min(n, m) */
+	
+} standard_form;
+
+void standard_form_free(standard_form* sf);
+
+/* leading SVD basis of the weighted kernel, see contin_reduced.c */
+struct reduced;
+
+/*
+------------------------------------------------------------------------------
+
+ skyline storage of a kernel, column j keeps rows first(j) ... last(j) - 1 
+ at data + offset(j), see contin_skyline.c
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	size_t size1;		/* rows n */
+	size_t size2;		/* columns m */
+	size_t* first;		/* first stored row of each column */
+	size_t* last;		/* one past the last stored row */
+	size_t* offset;		/* start of each column in data, m + 1 entries */
+	double* data;
+	
+} skyline;
+
+skyline* skyline_alloc_from(const gsl_matrix* K, double tol);
+skyline* skyline_alloc_kernel(const gsl_vector* t, const gsl_vector* tau, int kernelType, double tol);
+skyline* skyline_alloc_like(const skyline* S);
+void skyline_free(skyline* S);
+double skyline_fill(const skyline* S);
+void skyline_column(const skyline* S, size_t j, gsl_vector* col);
+int skyline_dgemv(CBLAS_TRANSPOSE_t trans, double alpha, const skyline* S, 
+				  const gsl_vector* x, double beta, gsl_vector* y);
+void skyline_dsyrk(const skyline* S, gsl_matrix* C);
+
+/*
+------------------------------------------------------------------------------
+
+ hierarchical low-rank storage of a kernel, a list of blocks that are 
+ either dense or U^T*V with small rank, see contin_hmatrix.c
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	size_t i0, j0;		/* first row and column of the block */
+	size_t size1;		/* rows */
+	size_t size2;		/* columns */
+	gsl_matrix* D;		/* dense block, NULL if low rank */
+	gsl_matrix* U;		/* rank x size1, the block is U^T*V, NULL for rank 0 */
+	gsl_matrix* V;		/* rank x size2 */
+	
+} hblock;
+
+typedef struct
+{
+	size_t size1;		/* rows n */
+	size_t size2;		/* columns m */
+	size_t nblock;
+	hblock* block;
+	gsl_vector* z;		/* scratch for products with the largest rank */
+	
+} hmatrix;
+
+hmatrix* hmatrix_alloc_kernel(const gsl_vector* t, const gsl_vector* tau, int kernelType, double tol);
+hmatrix* hmatrix_alloc_like(const hmatrix* H);
+void hmatrix_free(hmatrix* H);
+void hmatrix_weight(hmatrix* A, const hmatrix* K, const gsl_vector* rw, const gsl_vector* cw);
+double hmatrix_fill(const hmatrix* H);
+size_t hmatrix_rank(const hmatrix* H);
+void hmatrix_column(const hmatrix* H, size_t j, gsl_vector* col);
+int hmatrix_dgemv(CBLAS_TRANSPOSE_t trans, double alpha, const hmatrix* H, 
+				  const gsl_vector* x, double beta, gsl_vector* y);
+
+/*
+------------------------------------------------------------------------------
+
+ parameter struct for optimazation routine 
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct 
+{
+	gsl_matrix* K;		/* matrix for integration kernel, NULL if compressed */
+	gsl_vector* y;		/* y-axis of observed data */
+	gsl_vector* t;		/* t-axis of observed data */
+	gsl_vector* tau;	/* tau-axis for time constants */
+	gsl_vector* w;		/* weights for euclidian norm */
+	gsl_vector* c;		/* weights due to numerical intergration */
+	gsl_matrix* A;		/* weighted kernel A(i,j) = sqrt(w(i))*c(j)*K(i,j), NULL if compressed or single */
+	gsl_matrix_float* Af;	/* A rounded to float, NULL unless parameter_single */
+	skyline* Ks;		/* compressed K, NULL if dense */
+	skyline* As;		/* compressed A on the structure of Ks */
+	hmatrix* Kh;		/* hierarchical K, NULL if not used */
+	hmatrix* Ah;		/* hierarchical A on the blocks of Kh */
+	gsl_vector* sw;		/* sqrt(w), the weighted background column */
+	gsl_vector* swy;	/* sqrt(w)*y, the weighted data */
+	gsl_matrix* G;		/* Gram matrix [A, sqrt(w)]^T*[A, sqrt(w)] */
+	gsl_matrix* H;		/* hessian 2*G + 2*a^2*D2^T*D2 of the objective */
+	workspace* ws;		/* scratch space for fun, fun_df, fun_fdf */
+	standard_form* sf;	/* factorization for the alpha scan, NULL until needed */
+	struct reduced* rd;	/* basis for reduced solves, NULL until needed */
+	double alpha;		/* strenght of regularizer */
+	
+} parameter;
+
+/*
+------------------------------------------------------------------------------
+
+ tau grids: GRID_LINEAR is integrated in tau, GRID_LOG in ln(tau)
+
+------------------------------------------------------------------------------
+*/
+
+enum { GRID_LINEAR = 0, GRID_LOG = 1 };
+
+/*
+------------------------------------------------------------------------------
+
+ solver engines 
+ 
+ SOLVER_SPG:    spectral projected gradient from OOL
+ SOLVER_NNLS:   Lawson-Hanson active set on the stacked least-squares problem
+ SOLVER_PGRAD:  monotone projected gradient from OOL
+ SOLVER_GENCAN: rejected by contin_solve with OOL_EINVAL, the gencan objects 
+                of the bundled libool.a store size_t indices in their 
+                gsl_vector_uint index set and corrupt memory on 64-bit hosts
+ SOLVER_MEM:    maximum entropy instead of smoothness, see contin_mem.c
+ 
+ the OOL engines minimize in the box [L, U] of contin_minimizer, by default 
+ [0, 100], NNLS only constrains g, b >= 0, MEM keeps g > 0 by itself and 
+ leaves b free
+
+------------------------------------------------------------------------------
+*/
+
+enum { SOLVER_SPG = 0, SOLVER_NNLS = 1, SOLVER_PGRAD = 2, SOLVER_GENCAN = 3, SOLVER_MEM = 4 };
+
+#define MEM_TOL        1e-10	/* predicted decrease relative to the objective at the minimum */
+#define MEM_FLOOR      1e-8		/* lower bound of g relative to the default model */
+#define MEM_LAMBDA     1e-3		/* shift of the Newton system after a poor step */
+#define MEM_NEWTON     1e-6		/* shift below which the steps count as Newton steps */
+#define MEM_LAMBDA_MAX 1e12		/* shift at which the iteration gives up */
+#define MEM_ARC_MIN    1e-3		/* shortest step tried along the projection arc */
+
+typedef struct
+{
+	double tol;			/* projected gradient tolerance, <= 0 for the OOL default */
+	size_t nmax;		/* iteration limit */
+	size_t M;			/* memory of the nonmonotone SPG line search, 0 for the default */
+	double L;			/* lower bound of g and b */
+	double U;			/* upper bound of g and b */
+	double deadline;	/* wall-clock budget of one solve in seconds, 0 for none */
+	size_t stall;		/* stop after this many iterations without a better objective, 0 for never */
+	
+} contin_minimizer;
+
+/*
+ outcome of contin and contin_solve, g and b are the iterate with the 
+ smallest objective seen so far in every case
+ 
+ OOL_SUCCESS:     converged to the projected gradient tolerance
+ OOL_EMAXITER:    iteration budget nmax used up
+ CONTIN_DEADLINE: wall-clock budget used up
+ OOL_ENOPROG:     stalled, no better objective for stall iterations
+ 
+ contin_resolve is true for the two budget outcomes, whose result is worth 
+ a re-solve without budget started from it once there is time
+*/
+
+enum { CONTIN_DEADLINE = 1201 };
+
+int contin_resolve(int status);
+
+
+/*
+------------------------------------------------------------------------------
+
+ regularization path, criteria scanned over a logarithmic alpha grid from 
+ one SVD of the kernel, see contin_alpha.c
+
+------------------------------------------------------------------------------
+*/
+
+enum { ALPHA_FIXED = -1, ALPHA_GCV = 0, ALPHA_LCURVE = 1, ALPHA_DISCREPANCY = 2 };
+
+typedef struct
+{
+	gsl_vector* alpha;	/* alpha grid, ascending */
+	gsl_vector* rho;	/* squared weighted residual |r|^2 */
+	gsl_vector* eta;	/* squared smoothness |D2*g|^2 */
+	gsl_vector* gcv;	/* generalized cross validation function */
+	gsl_vector* kappa;	/* curvature of the L-curve */
+	size_t igcv;		/* index of the GCV minimum */
+	size_t ilcurve;		/* index of the L-curve corner */
+	size_t idiscrepancy;	/* index chosen by the discrepancy principle */
+	
+} regularization_path;
+
+/*
+------------------------------------------------------------------------------
+
+ options of contin_solve, alpha is scanned first unless criterion is 
+ ALPHA_FIXED, into path if one is given
+
+------------------------------------------------------------------------------
+*/
+
+#define ALPHA_GRID_SIZE 200
+
+typedef struct
+{
+	int solver;					/* SOLVER_SPG, SOLVER_NNLS, SOLVER_PGRAD, SOLVER_GENCAN or SOLVER_MEM */
+	contin_minimizer minimizer;	/* tolerance, limit and box of the OOL engines */
+	int criterion;				/* ALPHA_FIXED, ALPHA_GCV, ALPHA_LCURVE, ALPHA_DISCREPANCY */
+	regularization_path* path;	/* optional, receives the scanned criteria */
+	const gsl_vector* x0;		/* optional initial (g, b) for SPG, e.g. a previous solution */
+	const gsl_vector* model;	/* optional default model of SOLVER_MEM, m entries, flat if NULL */
+	double ktol;				/* > 0 stores the kernel as skyline with this tolerance */
+	double htol;				/* > 0 stores the kernel as hierarchical low-rank blocks */
+	int single;					/* stores A in float, the result is refined in double */
+	double rtol;				/* > 0 solves in the singular vectors above rtol*s(1) */
+	int precondition;			/* OOL engines on variables scaled by the Gram diagonal */
+	double alpha;				/* out: alpha used for the solve */
+	size_t iterations;			/* out: iterations or factorization updates used */
+	size_t rank;				/* out: size k of the reduced basis, 0 for a full solve */
+	double truncation;			/* out: s(k+1)/s(1), the largest singular value dropped */
+	int boundary;				/* out: the selected alpha is an end of the scanned grid */
+	
+} contin_options;
+
+void contin_options_default(contin_options* opts);
+
+regularization_path* regularization_path_alloc(size_t nalpha);
+void regularization_path_free(regularization_path* path);
+int contin_regularization_path(parameter* p, regularization_path* path);
+double regularization_path_select(const regularization_path* path, int criterion);
+int regularization_path_boundary(const regularization_path* path, int criterion);
+
+/*
+------------------------------------------------------------------------------
+
+ reduced problem in the leading k left singular vectors U of [A, sqrt(w)], 
+ kept in p->rd until the weights change, see contin_reduced.c
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct reduced
+{
+	gsl_matrix* U;		/* leading left singular vectors, n x k */
+	gsl_vector* s;		/* all singular values of [A, sqrt(w)] */
+	double tol;			/* relative cut the basis was built for */
+	parameter* q;		/* U^T*A, U^T*sqrt(w), U^T*sqrt(w)*y, k rows */
+	
+} reduced;
+
+void reduced_free(reduced* rd);
+parameter* parameter_reduce(parameter* p, double tol);
+parameter* parameter_alloc_projected(const parameter* p, const gsl_matrix* R);
+
+/*
+------------------------------------------------------------------------------
+
+ sufficient statistics of the counts of one angle, pooled solves from the 
+ (m + 1) x (m + 1) Gram matrix alone, see contin_accumulate.c
+
+------------------------------------------------------------------------------
+*/
+
+#define GRAM_ROOT_TOL 1e-12	/* eigenvalues of G kept, relative to the largest */
+
+typedef struct
+{
+	parameter* p;		/* borrowed dense kernel, reweighted with w by the solves */
+	gsl_vector* w;		/* sum of the weights 1/var */
+	gsl_vector* wy;		/* sum of w.*y */
+	double yWy;			/* sum of y^T*W*y */
+	gsl_vector* KWy;	/* K^T*sum(W*y) */
+	size_t count;		/* counts added */
+	int stale;			/* w changed since the square root was built */
+	gsl_vector* wg;		/* w of the square root */
+	gsl_matrix* V;		/* leading eigenvectors of G, (m + 1) x k */
+	gsl_vector* ev;		/* their eigenvalues */
+	parameter* q;		/* square root S^(1/2)*V^T of G as k rows */
+	gsl_vector* x;		/* last pooled (g, b), NULL before the first solve */
+	gsl_vector* v;		/* scratch, n */
+	size_t ngram;		/* Gram matrices built */
+	double chi2;		/* out: pooled weighted residual of the last solve */
+	
+} contin_accumulator;
+
+contin_accumulator* contin_accumulator_alloc(parameter* p);
+void contin_accumulator_free(contin_accumulator* acc);
+void contin_accumulator_reset(contin_accumulator* acc);
+int contin_accumulator_add(contin_accumulator* acc, const gsl_vector* y, const gsl_vector* var);
+int contin_accumulator_solve(contin_accumulator* acc, double alpha, contin_options* opts, 
+							 gsl_vector* s, gsl_vector* g, double* b);
+
+/*
+------------------------------------------------------------------------------
+
+ one distribution in the diffusion coefficient D for several angles with 
+ the kernel exp(-D*q^2*t), their own amplitudes and baselines, from m x m 
+ blocks per angle, see contin_global.c
+
+------------------------------------------------------------------------------
+*/
+
+#define GLOBAL_TOL    1e-4	/* relative change of the amplitudes that ends the passes */
+#define GLOBAL_PASSES 50	/* limit of the amplitude passes */
+
+typedef struct
+{
+	gsl_matrix* G;		/* (P*A)^T*P*A, A the weighted kernel, P projects out sqrt(w), m x m */
+	gsl_vector* h;		/* (P*A)^T*sqrt(w)*y */
+	gsl_vector* kb;		/* sqrt(w)^T*A / sum(w), the baseline g accounts for */
+	double yy;			/* |P*sqrt(w)*y|^2 */
+	double yb;			/* w^T*y / sum(w) */
+	double q2;			/* q^2 of the angle */
+	
+} global_angle;
+
+typedef struct
+{
+	gsl_vector* D;		/* grid of the diffusion coefficient */
+	gsl_vector* c;		/* its quadrature weights */
+	global_angle* angle;	/* the angles added */
+	size_t nangles;
+	size_t nalloc;
+	gsl_vector* x;		/* last (g, 0), NULL before the first solve */
+	gsl_vector* a;		/* out: amplitudes, mean 1 */
+	gsl_vector* b;		/* out: baselines */
+	gsl_vector* chi2;	/* out: weighted residuals */
+	size_t passes;		/* out: amplitude passes of the last solve */
+	
+} contin_global;
+
+contin_global* contin_global_alloc(const gsl_vector* D, int gridType);
+void contin_global_free(contin_global* gl);
+int contin_global_add(contin_global* gl, const gsl_vector* t, const gsl_vector* y, 
+					  const gsl_vector* var, double q2);
+int contin_global_solve(contin_global* gl, double alpha, contin_options* opts, 
+						gsl_vector* s, gsl_vector* g);
+
+/*
+------------------------------------------------------------------------------
+
+ coarse-to-fine solve on logarithmic grids with the levels of contin2.m, 
+ see contin_multires.c
+
+------------------------------------------------------------------------------
+*/
+
+#define MULTIRES_STEP 20	/* grid points added per level */
+#define MULTIRES_TOL  1e-3	/* relative change of g that ends the refinement */
+
+int contin_multires(gsl_vector* t, gsl_vector* y, gsl_vector* var, double alpha, 
+					double s0, double s1, int m, int levels, int kernelType, double tol, 
+					contin_options* opts, gsl_vector* s, gsl_vector* g, double* b, int* used);
+
+/*
+------------------------------------------------------------------------------
+
+ Monte Carlo uncertainty of a solution, replicates of the data perturbed 
+ with its variance are solved on the setup of the base problem, see 
+ contin_bootstrap.c
+
+------------------------------------------------------------------------------
+*/
+
+#define PEAK_MIN 0.05	/* maxima below this fraction of the largest are no peaks */
+
+typedef struct
+{
+	size_t R;				/* replicates */
+	unsigned long seed;		/* replicate r draws its noise from seed + r */
+	gsl_vector* level;		/* quantile levels of the bands */
+	gsl_matrix* g;			/* replicate distributions, R x m */
+	gsl_vector* b;			/* replicate backgrounds */
+	gsl_matrix* band;		/* quantiles of g, levels x m */
+	gsl_vector* peak;		/* peak positions of the base solution, NULL without peaks */
+	gsl_matrix* peaks;		/* peak positions of the replicates, R x peaks */
+	gsl_matrix* peak_band;	/* quantiles of the peak positions, levels x peaks */
+	gsl_vector* spread;		/* standard deviation of ln(position) of each peak */
+	size_t failed;			/* replicates that did not converge */
+	size_t iterations;		/* iterations of all replicates */
+	
+} contin_bootstrap;
+
+contin_bootstrap* contin_bootstrap_alloc(size_t R, size_t m, const gsl_vector* level, unsigned long seed);
+void contin_bootstrap_free(contin_bootstrap* bs);
+int contin_bootstrap_solve(parameter* p, contin_options* opts, gsl_vector* s, gsl_vector* g, 
+						   double* b, contin_bootstrap* bs);
+
+/*
+------------------------------------------------------------------------------
+
+ one inversion of a batch, see contin_batch.c
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	gsl_vector* t;			/* data, owned by the caller */
+	gsl_vector* y;
+	gsl_vector* var;
+	double s0;				/* grid, ignored if tau is given */
+	double s1;
+	int m;
+	int gridType;
+	gsl_vector* tau;		/* optional user grid, integrated in ln(tau) */
+	double alpha;
+	int kernelType;
+	contin_options opts;	/* per problem, receives alpha and iterations */
+	gsl_vector* s;			/* out: grid, m entries allocated by the caller */
+	gsl_vector* g;			/* out: distribution, m entries */
+	double b;				/* out: background */
+	int status;				/* out: outcome of contin_solve, see contin_resolve */
+	
+} contin_problem;
+
+int contin_problem_solve(contin_problem* pr);
+int contin_batch(contin_problem* problems, size_t count, int nthreads);
+int contin_threads_default(void);
+
+/*
+------------------------------------------------------------------------------
+
+ worker pool for a single large solve, see contin_threads.c, the dense 
+ kernel build, products and Gram matrix of n*m >= PARALLEL_MIN entries 
+ run in chunks of PARALLEL_ROWS rows or PARALLEL_COLS columns
+
+------------------------------------------------------------------------------
+*/
+
+#define PARALLEL_MIN  (1 << 18)
+#define PARALLEL_ROWS 256
+#define PARALLEL_COLS 64
+
+typedef void (*chunk_function)(void* arg, size_t chunk);
+
+void contin_set_threads(int nthreads);
+int contin_get_threads(void);
+void parallel_chunks(size_t nchunks, chunk_function f, void* arg);
+
+/*
+------------------------------------------------------------------------------
+
+ persistent solver handle, see contin_handle.c
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	parameter* p;		/* resident kernel, weights and factorizations */
+	int gridType;
+	int kernelType;
+	double ktol;		/* skyline tolerance, 0 for a dense kernel */
+	double htol;		/* low-rank block tolerance, 0 if not used */
+	size_t nsolve;		/* solves served */
+	size_t nsetup;		/* solves that had to rebuild the weighted kernel */
+	contin_accumulator* acc;	/* pooled counts, NULL until contin_handle_add */
+	int refs;			/* holders, contin_handle_release frees at 0 */
+	
+} contin_handle;
+
+contin_handle* contin_handle_alloc(gsl_vector* t, const gsl_vector* tau, int gridType, int kernelType, 
+								   double ktol, double htol);
+void contin_handle_free(contin_handle* h);
+int contin_handle_shareable(const contin_handle* h, const gsl_vector* t, const gsl_vector* tau, 
+							int gridType, int kernelType, double ktol, double htol);
+void contin_handle_retain(contin_handle* h);
+int contin_handle_release(contin_handle* h);
+int contin_handle_create(gsl_vector* t, const gsl_vector* tau, int gridType, int kernelType, 
+						 double ktol, double htol);
+contin_handle* contin_handle_lookup(int id);
+void contin_handle_destroy(int id);
+void contin_handle_destroy_all(void);
+int contin_handle_matches(const contin_handle* h, const gsl_vector* t, const gsl_vector* tau, 
+						  int gridType, int kernelType, double ktol, double htol);
+int contin_handle_solve(contin_handle* h, gsl_vector* y, gsl_vector* var, double alpha, 
+						contin_options* opts, gsl_vector* s, gsl_vector* g, double* b);
+int contin_handle_bootstrap(contin_handle* h, gsl_vector* y, gsl_vector* var, double alpha, 
+							contin_options* opts, gsl_vector* s, gsl_vector* g, double* b, 
+							contin_bootstrap* bs);
+int contin_handle_add(contin_handle* h, const gsl_vector* y, const gsl_vector* var);
+int contin_handle_pooled(contin_handle* h, double alpha, contin_options* opts, 
+						 gsl_vector* s, gsl_vector* g, double* b);
+
+/*
+------------------------------------------------------------------------------
+
+ kernel construction, see contin_kernel.c
+
+------------------------------------------------------------------------------
+*/
+
+enum { KERNEL_SCALAR = 0, KERNEL_AVX2 = 1, KERNEL_AVX512 = 2 };
+
+void kernel_build(gsl_matrix* K, const gsl_vector* t, const gsl_vector* tau, int kernelType);
+int kernel_isa_supported(int isa);
+int kernel_get_isa(void);
+int kernel_set_isa(int isa);
+
+/*
+------------------------------------------------------------------------------
+
+ dense products and Gram matrix instantiated for the (n, m) of common 
+ correlator geometries, they return 0 and leave the work to BLAS for 
+ any other size, see contin_fixed.cpp
+
+------------------------------------------------------------------------------
+*/
+
+int fixed_dgemv(CBLAS_TRANSPOSE_t trans, double alpha, const gsl_matrix* A, 
+				const gsl_vector* x, double beta, gsl_vector* y);
+int fixed_dsyrk(const gsl_matrix* A, gsl_matrix* C);
+int fixed_set_enabled(int enabled);
+int fixed_size(int k, int* n, int* m);
+
+workspace* workspace_alloc(int n, int m);
+void workspace_free(workspace* ws);
+
+void tau_grid(double tau0, double tau1, int gridType, gsl_vector* tau);
+void quadrature_weights(const gsl_vector* tau, int gridType, gsl_vector* c);
+
+parameter* parameter_alloc_kernel(gsl_vector* t, double alpha, const gsl_vector* tau, 
+								  int gridType, int kernelType, double ktol, double htol);
+int parameter_set_data(parameter* p, gsl_vector* y, gsl_vector* var);
+parameter* parameter_alloc_grid(gsl_vector* t, gsl_vector* y, gsl_vector* var, 
+								double alpha, const gsl_vector* tau, 
+								int gridType, int kernelType);
+parameter* parameter_alloc(gsl_vector* t, gsl_vector* y, gsl_vector* var, 
+						   double alpha, double tau0, double tau1, int m, 
+						   int kernelType, int gridType);
+void parameter_free(parameter* p);
+void parameter_compress(parameter* p, double tol);
+void parameter_hmatrix(parameter* p, double tol, int kernelType);
+void parameter_single(parameter* p, int single);
+void parameter_matvec(const parameter* p, CBLAS_TRANSPOSE_t trans, double alpha, 
+					  const gsl_vector* x, double beta, gsl_vector* y);
+void parameter_column(const parameter* p, size_t j, gsl_vector* col);
+void parameter_gram(parameter* p);
+void parameter_hessian(parameter* p);
+void parameter_set_alpha(parameter* p, double alpha);
+
+void diff2(const gsl_vector *x, gsl_vector * ddg);
+void residual(const gsl_vector* x, parameter* p, gsl_vector* r);
+void residual_df(const gsl_vector* r, const gsl_vector* d4g, parameter* p, gsl_vector* grad);
+
+double fun(const gsl_vector* x, void* params);
+void fun_df(const gsl_vector *x, void* params, gsl_vector *grad);
+void fun_fdf(const gsl_vector *x, void* params, double *f, gsl_vector *grad);
+void fun_Hv(const gsl_vector *x, void *params, const gsl_vector *v, gsl_vector *hv);
+
+int contin(parameter* p, const contin_options* opts, gsl_vector* s, gsl_vector* g, double* b, size_t* iterations);
+int contin_nnls(parameter* p, gsl_vector* s, gsl_vector* g, double* b, size_t* nupdates);
+int contin_mem(parameter* p, const contin_options* opts, gsl_vector* s, gsl_vector* g, double* b, size_t* iterations);
+int contin_solve(parameter* p, contin_options* opts, gsl_vector* s, gsl_vector* g, double* b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
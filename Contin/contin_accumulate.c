@@ -0,0 +1,295 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: CONTIN on the pooled counts of one angle
+
+ Counts y_k with variance var_k measured on the same lag grid are pooled
+ by summing their objectives. With W_k = diag(1/var_k) the data term is
+
+ sum_k |W_k^(1/2)*(K*C*g + b - y_k)|^2 = x^T*G*x - 2*x^T*h + sum_k y_k^T*W_k*y_k
+
+ for x = (g, b), where G = [K*C, 1]^T*W*[K*C, 1] with W = sum_k W_k and
+ h = [C*K^T*sum_k W_k*y_k; sum(sum_k W_k*y_k)]. A count therefore only
+ adds to the sums W, W*y, y^T*W*y and K^T*W*y, O(n*m), the correlograms
+ themselves are never needed again.
+
+ A solve builds G for the summed weights on the kernel of the borrowed
+ parameter, O(n*m^2) and only if W changed other than by a common
+ factor, which just scales G. The SVD G = V*S*V^T gives the square root
+ R = S^(1/2)*V^T, and |R*x - S^(-1/2)*V^T*h|^2 differs from the data term
+ by a constant, so the unchanged engines solve the pooled problem as one
+ of m + 1 rows at O(m^2) per iteration, started from the previous pooled
+ solution. Eigenvalues below GRAM_ROOT_TOL of the largest are dropped,
+ that is singular values of the weighted kernel below about 1e-6 of the
+ largest, where h has no component either.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <gsl/gsl_linalg.h>
+#include "contin.h"
+
+contin_accumulator* contin_accumulator_alloc(parameter* p)
+{
+	contin_accumulator* acc = malloc(sizeof(contin_accumulator));
+	int n = p->t->size;
+	int m = p->tau->size;
+
+	acc->p     = p;
+	acc->w     = gsl_vector_alloc(n);
+	acc->wy    = gsl_vector_alloc(n);
+	acc->KWy   = gsl_vector_alloc(m);
+	acc->wg    = gsl_vector_alloc(n);
+	acc->v     = gsl_vector_alloc(n);
+	acc->V     = NULL;
+	acc->ev    = NULL;
+	acc->q     = NULL;
+	acc->x     = NULL;
+	acc->ngram = 0;
+	acc->chi2  = 0;
+
+	contin_accumulator_reset(acc);
+
+	return acc;
+}
+
+void contin_accumulator_free(contin_accumulator* acc)
+{
+	if ( acc->w ) gsl_vector_free( acc->w );
+	if ( acc->wy ) gsl_vector_free( acc->wy );
+	if ( acc->KWy ) gsl_vector_free( acc->KWy );
+	if ( acc->wg ) gsl_vector_free( acc->wg );
+	if ( acc->v ) gsl_vector_free( acc->v );
+	if ( acc->V ) gsl_matrix_free( acc->V );
+	if ( acc->ev ) gsl_vector_free( acc->ev );
+	if ( acc->q ) parameter_free( acc->q );
+	if ( acc->x ) gsl_vector_free( acc->x );
+	free(acc);
+}
+
+/* forget all counts, the square root is rebuilt by the next solve */
+void contin_accumulator_reset(contin_accumulator* acc)
+{
+	gsl_vector_set_zero(acc->w);
+	gsl_vector_set_zero(acc->wy);
+	gsl_vector_set_zero(acc->KWy);
+	gsl_vector_set_zero(acc->wg);
+	acc->yWy   = 0;
+	acc->count = 0;
+	acc->stale = 1;
+
+	if (acc->x)
+	{
+		gsl_vector_free(acc->x);
+		acc->x = NULL;
+	}
+}
+
+/*
+------------------------------------------------------------------------------
+
+ add the count y with variance var, O(n*m)
+
+------------------------------------------------------------------------------
+*/
+
+int contin_accumulator_add(contin_accumulator* acc, const gsl_vector* y, const gsl_vector* var)
+{
+	size_t n = acc->w->size;
+	size_t i;
+
+	if (y->size != n || var->size != n)
+		return OOL_EBADLEN;
+
+	for (i = 0; i < n; i++)
+	{
+		double wi = 1.0 / gsl_vector_get(var, i);
+		double yi = gsl_vector_get(y, i);
+
+		*gsl_vector_ptr(acc->w, i)  += wi;
+		*gsl_vector_ptr(acc->wy, i) += wi * yi;
+		acc->yWy += wi * yi * yi;
+		gsl_vector_set(acc->v, i, wi * yi);
+	}
+	gsl_blas_dgemv(CblasTrans, 1.0, acc->p->K, acc->v, 1.0, acc->KWy);
+
+	acc->count++;
+	acc->stale = 1;
+
+	return GSL_SUCCESS;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ G for the summed weights on the borrowed parameter and its square root
+ as the projected problem acc->q
+
+------------------------------------------------------------------------------
+*/
+
+static void accumulator_root(contin_accumulator* acc)
+{
+	parameter* p = acc->p;
+	size_t n = p->t->size;
+	size_t m = p->tau->size;
+	size_t i, j, k;
+
+	/* the pooled problem has the summed weights, y only enters through h */
+	for (i = 0; i < n; i++)
+	{
+		double wi = gsl_vector_get(acc->w, i);
+		gsl_vector_set(acc->v, i, 1.0 / wi);
+		gsl_vector_set(acc->wg, i, gsl_vector_get(acc->wy, i) / wi);
+	}
+	parameter_set_data(p, acc->wg, acc->v);
+	gsl_vector_memcpy(acc->wg, acc->w);
+
+	gsl_matrix* U = gsl_matrix_alloc(m + 1, m + 1);
+	gsl_matrix* V = gsl_matrix_alloc(m + 1, m + 1);
+	gsl_vector* s = gsl_vector_alloc(m + 1);
+	gsl_vector* work = gsl_vector_alloc(m + 1);
+
+	gsl_matrix_memcpy(U, p->G);
+	gsl_linalg_SV_decomp(U, V, s, work);
+
+	double s1 = gsl_vector_get(s, 0);
+	for (k = 1; k < m + 1 && gsl_vector_get(s, k) > GRAM_ROOT_TOL * s1; k++)
+		;
+
+	if (acc->V)
+	{
+		gsl_matrix_free(acc->V);
+		gsl_vector_free(acc->ev);
+		parameter_free(acc->q);
+	}
+	acc->V  = gsl_matrix_alloc(m + 1, k);
+	acc->ev = gsl_vector_alloc(k);
+	gsl_matrix_const_view Vk = gsl_matrix_const_submatrix(V, 0, 0, m + 1, k);
+	gsl_vector_const_view sk = gsl_vector_const_subvector(s, 0, k);
+	gsl_matrix_memcpy(acc->V, &Vk.matrix);
+	gsl_vector_memcpy(acc->ev, &sk.vector);
+
+	/* R = S^(1/2)*V^T in k rows */
+	gsl_matrix* R = gsl_matrix_alloc(k, m + 1);
+	for (i = 0; i < k; i++)
+		for (j = 0; j < m + 1; j++)
+			gsl_matrix_set(R, i, j, sqrt(gsl_vector_get(s, i)) * gsl_matrix_get(V, j, i));
+	acc->q = parameter_alloc_projected(p, R);
+	acc->ngram++;
+
+	gsl_matrix_free(R);
+	gsl_matrix_free(U);
+	gsl_matrix_free(V);
+	gsl_vector_free(s);
+	gsl_vector_free(work);
+}
+
+/* the summed weights are lambda times those of the root, 0 if not */
+static double accumulator_scale(const contin_accumulator* acc)
+{
+	size_t i;
+
+	if (gsl_vector_get(acc->wg, 0) <= 0)
+		return 0;
+	double lambda = gsl_vector_get(acc->w, 0) / gsl_vector_get(acc->wg, 0);
+
+	for (i = 0; i < acc->w->size; i++)
+		if (fabs(gsl_vector_get(acc->w, i) - lambda * gsl_vector_get(acc->wg, i))
+			> 1e-12 * gsl_vector_get(acc->w, i))
+			return 0;
+	return lambda;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ solve the pooled counts like contin_solve, opts->x0 defaults to the
+ previous pooled solution
+
+------------------------------------------------------------------------------
+*/
+
+int contin_accumulator_solve(contin_accumulator* acc,
+							 double alpha,
+							 contin_options* opts,
+							 gsl_vector* s,
+							 gsl_vector* g,
+							 double* b)
+{
+	size_t m = acc->p->tau->size;
+	size_t i, j;
+
+	if (acc->count == 0 || s->size != m || g->size != m)
+		return OOL_EBADLEN;
+
+	if (acc->stale)
+	{
+		double lambda = acc->q ? accumulator_scale(acc) : 0;
+		if (lambda > 0)
+		{
+			/* G scales with the weights, R and the eigenvalues follow */
+			parameter* q = acc->q;
+			gsl_matrix_scale(q->A, sqrt(lambda));
+			gsl_vector_scale(q->sw, sqrt(lambda));
+			gsl_matrix_scale(q->G, lambda);
+			gsl_vector_scale(acc->ev, lambda);
+			gsl_vector_memcpy(acc->wg, acc->w);
+			parameter_hessian(q);
+			if (q->sf)
+			{
+				standard_form_free(q->sf);
+				q->sf = NULL;
+			}
+			if (q->rd)
+			{
+				reduced_free(q->rd);
+				q->rd = NULL;
+			}
+		}
+		else
+			accumulator_root(acc);
+		acc->stale = 0;
+	}
+
+	/* the data of the square root, S^(-1/2)*V^T*h */
+	parameter* q = acc->q;
+	double hb = 0;
+	for (i = 0; i < acc->wy->size; i++)
+		hb += gsl_vector_get(acc->wy, i);
+
+	for (i = 0; i < acc->ev->size; i++)
+	{
+		double vh = gsl_matrix_get(acc->V, m, i) * hb;
+		for (j = 0; j < m; j++)
+			vh += gsl_matrix_get(acc->V, j, i) * gsl_vector_get(acc->p->c, j) * gsl_vector_get(acc->KWy, j);
+		gsl_vector_set(q->swy, i, vh / sqrt(gsl_vector_get(acc->ev, i)));
+	}
+	gsl_vector_memcpy(q->y, q->swy);
+
+	if (q->alpha != alpha)
+		parameter_set_alpha(q, alpha);
+
+	const gsl_vector* x0 = opts->x0;
+	if (!x0)
+		opts->x0 = acc->x;
+	int status = contin_solve(q, opts, s, g, b);
+	opts->x0 = x0;
+
+	if (!acc->x)
+		acc->x = gsl_vector_alloc(m + 1);
+	gsl_vector_view xg = gsl_vector_subvector(acc->x, 0, m);
+	gsl_vector_memcpy(&xg.vector, g);
+	gsl_vector_set(acc->x, m, *b);
+
+	/* the pooled chi^2 is the residual of the root up to the constant */
+	double r2, h2;
+	residual(acc->x, q, q->ws->r);
+	gsl_blas_ddot(q->ws->r, q->ws->r, &r2);
+	gsl_blas_ddot(q->swy, q->swy, &h2);
+	acc->chi2 = r2 + acc->yWy - h2;
+
+	return status;
+}
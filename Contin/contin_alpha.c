@@ -0,0 +1,362 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: automatic choice of the regularization strength alpha
+ 
+ With the background eliminated by the projection P = I - sw*sw^T/|sw|^2 
+ and the substitution h = D2*g (D2 is invertible) the unconstrained CONTIN 
+ problem takes the standard form
+ 
+ min |At*h - yt|^2 + alpha^2*|h|^2, At = P*A*D2^-1, yt = P*sqrt(w)*y
+ 
+ One SVD At = U*S*V^T, computed once, gives with beta = U^T*yt and the 
+ filter factors f = s^2/(s^2 + alpha^2) the residual norm, the smoothness 
+ norm and the effective number of parameters for every alpha in closed 
+ form, so the generalized cross validation, the corner of the L-curve and 
+ the discrepancy principle are scanned over a dense alpha grid without a 
+ single minimization. Only the selected alpha is then solved with the 
+ non-negativity constraint.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <gsl/gsl_linalg.h>
+#include "contin.h"
+
+/*
+------------------------------------------------------------------------------
+
+ allocate a path of nalpha grid points
+
+------------------------------------------------------------------------------
+*/
+
+regularization_path* regularization_path_alloc(size_t nalpha)
+{
+	regularization_path* path = malloc(sizeof(regularization_path));
+	
+	path->alpha = gsl_vector_alloc(nalpha);
+	path->rho   = gsl_vector_alloc(nalpha);
+	path->eta   = gsl_vector_alloc(nalpha);
+	path->gcv   = gsl_vector_alloc(nalpha);
+	path->kappa = gsl_vector_alloc(nalpha);
+	path->igcv = path->ilcurve = path->idiscrepancy = 0;
+	
+	return path;
+}
+
+void regularization_path_free(regularization_path* path)
+{
+	if ( path->alpha ) gsl_vector_free( path->alpha );
+	if ( path->rho   ) gsl_vector_free( path->rho   );
+	if ( path->eta   ) gsl_vector_free( path->eta   );
+	if ( path->gcv   ) gsl_vector_free( path->gcv   );
+	if ( path->kappa ) gsl_vector_free( path->kappa );
+	free( path );
+}
+
+/*
+------------------------------------------------------------------------------
+
+ inverse of D2 = tridiag(1, -2, 1), with 1-based indices
+ D2^-1(i,j) = -min(i,j)*(m + 1 - max(i,j))/(m + 1)
+
+------------------------------------------------------------------------------
+*/
+
+static void diff2_inverse(gsl_matrix* Dinv)
+{
+	int m = Dinv->size1;
+	int i, j;
+	
+	for (i = 1; i <= m; i++)
+		for (j = 1; j <= m; j++)
+			gsl_matrix_set(Dinv, i - 1, j - 1, 
+						   -(double) GSL_MIN(i, j) * (m + 1 - GSL_MAX(i, j)) / (m + 1));
+}
+
+/*
+------------------------------------------------------------------------------
+
+ SVD of the standard form At = U*S*V^T, it only depends on the weighted 
+ kernel and is kept in p->sf until the weights change
+
+------------------------------------------------------------------------------
+*/
+
+void standard_form_free(standard_form* sf)
+{
+	if ( sf->U ) gsl_matrix_free( sf->U );
+	if ( sf->s ) gsl_vector_free( sf->s );
+	free( sf );
+}
+
+static standard_form* standard_form_alloc(parameter* p)
+{
+	int n = p->t->size;
+	int m = p->tau->size;
+	int k = GSL_MIN(n, m);
+	int j;
+	
+	standard_form* sf = malloc(sizeof(standard_form));
+	
+	gsl_matrix* PA   = gsl_matrix_alloc(n, m);
+	gsl_matrix* Dinv = gsl_matrix_alloc(m, m);
+	gsl_matrix* At   = gsl_matrix_alloc(n, m);
+	
+	/* eliminate the background, P*x = x - (sw^T*x/sw^T*sw)*sw */
+	double sw2, c;
+	gsl_blas_ddot(p->sw, p->sw, &sw2);
+	
+	for (j = 0; j < m; j++)
+	{
+		gsl_vector_view col = gsl_matrix_column(PA, j);
+		parameter_column(p, j, &col.vector);
+		gsl_blas_ddot(p->sw, &col.vector, &c);
+		gsl_blas_daxpy(-c / sw2, p->sw, &col.vector);
+	}
+	
+	diff2_inverse(Dinv);
+	gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, PA, Dinv, 0.0, At);
+	
+	sf->s = gsl_vector_alloc(k);
+	gsl_vector* work = gsl_vector_alloc(k);
+	
+	if (n >= m)
+	{
+		/* At = U*S*V^T, U overwrites At */
+		gsl_matrix* V = gsl_matrix_alloc(m, m);
+		gsl_linalg_SV_decomp(At, V, sf->s, work);
+		gsl_matrix_free(V);
+		sf->U = At;
+	}
+	else
+	{
+		/* At^T = U*S*V^T, the left singular vectors of At are V */
+		gsl_matrix* AtT = gsl_matrix_alloc(m, n);
+		gsl_matrix* V   = gsl_matrix_alloc(n, n);
+		gsl_matrix_transpose_memcpy(AtT, At);
+		gsl_linalg_SV_decomp(AtT, V, sf->s, work);
+		gsl_matrix_free(AtT);
+		gsl_matrix_free(At);
+		sf->U = V;
+	}
+	
+	gsl_vector_free(work);
+	gsl_matrix_free(PA);
+	gsl_matrix_free(Dinv);
+	
+	return sf;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ projected data beta = U^T*yt, yt = P*sqrt(w)*y, ydelta returns the part 
+ of |yt|^2 outside the range of At
+
+------------------------------------------------------------------------------
+*/
+
+static void standard_form_project(parameter* p, gsl_vector* beta, double* ydelta)
+{
+	int n = p->t->size;
+	gsl_vector* yt = gsl_vector_alloc(n);
+	double sw2, c, y2, b2;
+	
+	gsl_blas_ddot(p->sw, p->sw, &sw2);
+	gsl_vector_memcpy(yt, p->swy);
+	gsl_blas_ddot(p->sw, yt, &c);
+	gsl_blas_daxpy(-c / sw2, p->sw, yt);
+	
+	gsl_blas_dgemv(CblasTrans, 1.0, p->sf->U, yt, 0.0, beta);
+	
+	gsl_blas_ddot(yt, yt, &y2);
+	gsl_blas_ddot(beta, beta, &b2);
+	*ydelta = GSL_MAX(y2 - b2, 0.0);
+	
+	gsl_vector_free(yt);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ curvature of the L-curve (log|r|, log|h|) at alpha, 
+ see P. C. Hansen, Regularization Tools, lcfun
+
+------------------------------------------------------------------------------
+*/
+
+static double lcurve_curvature(const gsl_vector* s, const gsl_vector* beta, double alpha)
+{
+	double eta = 0, rho = 0, phi = 0, psi = 0, dphi = 0, dpsi = 0;
+	int i;
+	
+	for (i = 0; i < s->size; i++)
+	{
+		double si = gsl_vector_get(s, i);
+		if (si <= 0)
+			continue;
+		
+		double bi = gsl_vector_get(beta, i);
+		double xi = bi / si;
+		double f  = si * si / (si * si + alpha * alpha);
+		double cf = 1 - f;
+		double f1 = -2 * f * cf / alpha;
+		double f2 = -f1 * (3 - 4 * f) / alpha;
+		
+		eta  += f * f * xi * xi;
+		rho  += cf * cf * bi * bi;
+		phi  += f  * f1 * xi * xi;
+		psi  += cf * f1 * bi * bi;
+		dphi += (f1 * f1 + f * f2) * xi * xi;
+		dpsi += (-f1 * f1 + cf * f2) * bi * bi;
+	}
+	
+	eta = sqrt(eta);
+	rho = sqrt(rho);
+	
+	double deta  =  phi / eta;
+	double drho  = -psi / rho;
+	double ddeta =  dphi / eta - deta * (deta / eta);
+	double ddrho = -dpsi / rho - drho * (drho / rho);
+	
+	double dlogeta  = deta / eta;
+	double dlogrho  = drho / rho;
+	double ddlogeta = ddeta / eta - dlogeta * dlogeta;
+	double ddlogrho = ddrho / rho - dlogrho * dlogrho;
+	
+	return (dlogrho * ddlogeta - ddlogrho * dlogeta) 
+		/ pow(dlogrho * dlogrho + dlogeta * dlogeta, 1.5);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ scan the criteria over a logarithmic alpha grid spanning the singular 
+ values of the standard form, alpha is not changed in p
+
+------------------------------------------------------------------------------
+*/
+
+int contin_regularization_path(parameter* p, regularization_path* path)
+{
+	double ydelta;
+	int n = p->t->size;
+	int i, j;
+	
+	/* factor once per weighted kernel, project every new data set */
+	if (!p->sf)
+		p->sf = standard_form_alloc(p);
+	
+	const gsl_vector* s = p->sf->s;
+	gsl_vector* beta = gsl_vector_alloc(s->size);
+	standard_form_project(p, beta, &ydelta);
+	
+	/* the background uses up one degree of freedom */
+	double ndof = n - 1;
+	
+	double smax = gsl_vector_max(s);
+	double smin = GSL_MAX(gsl_vector_min(s), 1e-8 * smax);
+	if (smin <= 0 || smin >= smax)
+		smin = 1e-8 * smax;
+	
+	size_t nalpha = path->alpha->size;
+	double best_gcv = GSL_POSINF, best_kappa = GSL_NEGINF;
+	
+	path->igcv = path->ilcurve = path->idiscrepancy = 0;
+	
+	for (j = 0; j < nalpha; j++)
+	{
+		double alpha = smin * pow(smax / smin, nalpha > 1 ? (double) j / (nalpha - 1) : 0.0);
+		double rho = ydelta, eta = 0, trace = 0;
+		
+		for (i = 0; i < s->size; i++)
+		{
+			double si = gsl_vector_get(s, i);
+			double bi = gsl_vector_get(beta, i);
+			double f  = si * si / (si * si + alpha * alpha);
+			
+			rho   += (1 - f) * (1 - f) * bi * bi;
+			trace += f;
+			if (si > 0)
+				eta += f * f * (bi / si) * (bi / si);
+		}
+		
+		double gcv   = rho / ((ndof - trace) * (ndof - trace));
+		double kappa = lcurve_curvature(s, beta, alpha);
+		
+		gsl_vector_set(path->alpha, j, alpha);
+		gsl_vector_set(path->rho,   j, rho);
+		gsl_vector_set(path->eta,   j, eta);
+		gsl_vector_set(path->gcv,   j, gcv);
+		gsl_vector_set(path->kappa, j, kappa);
+		
+		if (gcv < best_gcv)
+		{
+			best_gcv = gcv;
+			path->igcv = j;
+		}
+		if (kappa > best_kappa)
+		{
+			best_kappa = kappa;
+			path->ilcurve = j;
+		}
+		
+		/* 
+		 discrepancy principle: largest alpha whose residual does not 
+		 exceed the noise level, chi^2 = ndof for weights 1/var 
+		*/
+		if (rho <= ndof)
+			path->idiscrepancy = j;
+	}
+	
+	gsl_vector_free(beta);
+	
+	return OOL_SUCCESS;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ alpha selected by criterion on a scanned path
+
+------------------------------------------------------------------------------
+*/
+
+static size_t regularization_path_index(const regularization_path* path, int criterion)
+{
+	switch (criterion)
+	{
+		case ALPHA_LCURVE:
+			return path->ilcurve;
+		case ALPHA_DISCREPANCY:
+			return path->idiscrepancy;
+		default:
+			return path->igcv;
+	}
+}
+
+double regularization_path_select(const regularization_path* path, int criterion)
+{
+	return gsl_vector_get(path->alpha, regularization_path_index(path, criterion));
+}
+
+/*
+------------------------------------------------------------------------------
+
+ nonzero if the criterion selected the first or last alpha of the grid, 
+ its optimum then lies outside the singular values of the standard form 
+ (GCV or L-curve at the smallest alpha) or no alpha meets the noise level 
+ (discrepancy at either end), the variance of the data is worth a look
+
+------------------------------------------------------------------------------
+*/
+
+int regularization_path_boundary(const regularization_path* path, int criterion)
+{
+	size_t j = regularization_path_index(path, criterion);
+	return j == 0 || j + 1 == path->alpha->size;
+}
@@ -0,0 +1,156 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: batch inversion of many correlograms on a pool of threads
+ 
+ Every problem is set up, solved and released by one worker with its own 
+ parameter struct and workspace, no state is shared between problems. The 
+ workers only take the index of the next problem from a shared counter, so 
+ the result of a problem does not depend on the thread that solved it or 
+ on the number of threads and is bitwise identical to the serial path 
+ contin_problem_solve.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "contin.h"
+
+/*
+------------------------------------------------------------------------------
+
+ set up, solve and release a single problem
+
+------------------------------------------------------------------------------
+*/
+
+int contin_problem_solve(contin_problem* pr)
+{
+	parameter* p;
+	
+	if (pr->tau)
+		p = parameter_alloc_kernel(pr->t, pr->alpha, pr->tau, GRID_LOG, pr->kernelType, 
+								   pr->opts.ktol, pr->opts.htol);
+	else
+	{
+		gsl_vector* tau = gsl_vector_alloc(pr->m);
+		tau_grid(pr->s0, pr->s1, pr->gridType, tau);
+		p = parameter_alloc_kernel(pr->t, pr->alpha, tau, pr->gridType, pr->kernelType, 
+								   pr->opts.ktol, pr->opts.htol);
+		gsl_vector_free(tau);
+	}
+	
+	parameter_set_data(p, pr->y, pr->var);
+	parameter_single(p, pr->opts.single);
+	pr->status = contin_solve(p, &pr->opts, pr->s, pr->g, &pr->b);
+	parameter_free(p);
+	
+	return pr->status;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ work queue shared by the pool
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	contin_problem* problems;
+	size_t count;
+	size_t next;			/* index of the next unsolved problem */
+	pthread_mutex_t lock;
+	
+} batch_queue;
+
+static void* batch_worker(void* arg)
+{
+	batch_queue* q = (batch_queue*) arg;
+	size_t i;
+	
+	for (;;)
+	{
+		pthread_mutex_lock(&q->lock);
+		i = q->next++;
+		pthread_mutex_unlock(&q->lock);
+		
+		if (i >= q->count)
+			break;
+		contin_problem_solve(&q->problems[i]);
+	}
+	
+	return NULL;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ number of threads used for nthreads <= 0
+
+------------------------------------------------------------------------------
+*/
+
+int contin_threads_default(void)
+{
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	return ncpu > 0 ? (int) ncpu : 1;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ solve count problems on nthreads threads, nthreads <= 0 uses all cores, 
+ returns the number of problems that did not converge
+
+------------------------------------------------------------------------------
+*/
+
+int contin_batch(contin_problem* problems, size_t count, int nthreads)
+{
+	size_t i;
+	int k, failed = 0;
+	
+	if (nthreads <= 0)
+		nthreads = contin_threads_default();
+	if (nthreads > count)
+		nthreads = count;
+	
+	if (nthreads <= 1)
+	{
+		for (i = 0; i < count; i++)
+			contin_problem_solve(&problems[i]);
+	}
+	else
+	{
+		batch_queue q;
+		q.problems = problems;
+		q.count    = count;
+		q.next     = 0;
+		pthread_mutex_init(&q.lock, NULL);
+		
+		pthread_t* threads = malloc((nthreads - 1) * sizeof(pthread_t));
+		int started = 0;
+		for (k = 0; k < nthreads - 1; k++)
+			if (pthread_create(&threads[started], NULL, batch_worker, &q) == 0)
+				started++;
+		
+		/* the calling thread helps, so the batch finishes even without workers */
+		batch_worker(&q);
+		
+		for (k = 0; k < started; k++)
+			pthread_join(threads[k], NULL);
+		
+		free(threads);
+		pthread_mutex_destroy(&q.lock);
+	}
+	
+	for (i = 0; i < count; i++)
+		if (problems[i].status != OOL_SUCCESS)
+			failed++;
+	
+	return failed;
+}
@@ -0,0 +1,1027 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: timings of the CONTIN engines and kernels
+
+ Prints one table per section, the sections named on the command line or
+ all of them: kernel, fixed, threads, engines, compressed, reduced,
+ single, multires, pooled, global. Times are wall-clock, the data come
+ from contin_fixture.c. The section alv runs only when named, it is the
+ C counterpart of benchmark_contin.m on the example correlograms and
+ takes minutes. Not part of the MEX, build it like contin_test.c:
+
+   g++ -O2 -c contin_fixed.cpp
+   gcc -std=gnu99 -O2 -DCONTIN_NO_MAIN -o contin_bench contin_bench.c \
+       contin_fixture.c contin.c contin_nnls.c contin_alpha.c contin_batch.c \
+       contin_handle.c contin_kernel.c contin_skyline.c contin_hmatrix.c \
+       contin_reduced.c contin_multires.c contin_threads.c contin_bootstrap.c \
+       contin_accumulate.c contin_mem.c contin_global.c contin_fixed.o \
+       -lool -lgsl -lgslcblas -lm -lpthread -lstdc++
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+#include <dirent.h>
+#include "contin_fixture.h"
+
+#ifndef CONTIN_ALV_DATA
+#define CONTIN_ALV_DATA "../example/example-data/LS"
+#endif
+
+static double wall_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static int matrix_identical(const gsl_matrix* a, const gsl_matrix* b)
+{
+	size_t i;
+	for (i = 0; i < a->size1; i++)
+		if (memcmp(gsl_matrix_const_ptr(a, i, 0), gsl_matrix_const_ptr(b, i, 0), a->size2 * sizeof(double)))
+			return 0;
+	return 1;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ vectorized kernel construction against the reference loop on an
+ equidistant and a multi-tau lag grid with a logarithmic tau grid
+
+------------------------------------------------------------------------------
+*/
+
+static double ulp_error(double x, long double ref)
+{
+	double r = (double) ref;
+	if (fabsl(ref) < DBL_MIN)
+		return 0;
+	return (double) (fabsl((long double) x - ref) / (nextafter(r, INFINITY) - r));
+}
+
+static double kernel_time(gsl_matrix* K, const gsl_vector* t, const gsl_vector* tau,
+						  int kernelType, int reps)
+{
+	int r;
+	double t0 = wall_time();
+	for (r = 0; r < reps; r++)
+		kernel_build(K, t, tau, kernelType);
+	return (wall_time() - t0) / reps;
+}
+
+static void kernel_benchmark(int n, int m)
+{
+	const char* isa_name[] = {"scalar", "avx2", "avx512"};
+	const char* grid_name[] = {"equidistant", "multi-tau"};
+	int isa0 = kernel_get_isa();
+	int i, j, grid, kernelType, isa;
+
+	gsl_vector* t   = gsl_vector_alloc(n);
+	gsl_vector* tau = gsl_vector_alloc(m);
+	gsl_matrix* K   = gsl_matrix_alloc(n, m);
+
+	/*
+	 exp alone, with tau = 1 the argument -t/tau is exact
+	*/
+
+	int nx = 100000;
+	gsl_vector* x  = gsl_vector_alloc(nx);
+	gsl_vector* one = gsl_vector_alloc(1);
+	gsl_matrix* ex = gsl_matrix_alloc(nx, 1);
+	gsl_vector_set_all(one, 1.0);
+	for (i = 0; i < nx; i++)
+		gsl_vector_set(x, i, 708.0 * sin(1.0 + i) * sin(1.0 + i));
+
+	for (isa = KERNEL_SCALAR; isa <= KERNEL_AVX512; isa++)
+	{
+		if (!kernel_isa_supported(isa))
+			continue;
+		kernel_set_isa(isa);
+		kernel_build(ex, x, one, 0);
+
+		double emax = 0;
+		for (i = 0; i < nx; i++)
+			emax = GSL_MAX(emax, ulp_error(gsl_matrix_get(ex, i, 0), expl(-(long double) gsl_vector_get(x, i))));
+		printf("exp %-6s: max error %4.2f ulp\n", isa_name[isa], emax);
+	}
+
+	/*
+	 whole kernels against the reference loop, which the vectorized rows
+	 have to reproduce up to the exp error and the rounding the recurrence
+	 accumulates over KERNEL_RESTART rows; exp(-t/tau) moves by t/tau*eps
+	 with the rounding of its argument, so large t/tau give many ulp
+	*/
+
+	gsl_matrix* Kref = gsl_matrix_alloc(n, m);
+	tau_grid(1e-3, 1e2, GRID_LOG, tau);
+
+	for (grid = 0; grid < 2; grid++)
+	{
+		fixture_lags(t, grid);
+
+		for (kernelType = 0; kernelType < 2; kernelType++)
+		{
+			int reps = 20;
+
+			kernel_set_isa(KERNEL_SCALAR);
+			double t_ref = kernel_time(Kref, t, tau, kernelType, reps);
+
+			for (isa = KERNEL_SCALAR; isa <= KERNEL_AVX512; isa++)
+			{
+				if (!kernel_isa_supported(isa))
+					continue;
+				kernel_set_isa(isa);
+
+				double time = kernel_time(K, t, tau, kernelType, reps);
+				/* ulp, and relative in units of the rounding of the argument t/tau */
+				double emax = 0, earg = 0;
+				for (i = 0; i < n; i++)
+					for (j = 0; j < m; j++)
+					{
+						double r = gsl_matrix_get(Kref, i, j);
+						double x = gsl_vector_get(t, i) / gsl_vector_get(tau, j);
+						emax = GSL_MAX(emax, ulp_error(gsl_matrix_get(K, i, j), r));
+						if (r >= DBL_MIN)
+							earg = GSL_MAX(earg, fabs(gsl_matrix_get(K, i, j) / r - 1) / ((1 + x) * DBL_EPSILON));
+					}
+
+				printf("kernel %d, %-11s grid, %-6s: %7.3f ms, speedup %5.2f, "
+					   "against the scalar loop %5.1f ulp, %4.2f eps*(1 + t/tau)\n",
+					   kernelType, grid_name[grid], isa_name[isa], 1e3 * time, t_ref / time, emax, earg);
+			}
+		}
+	}
+
+	gsl_matrix_free(Kref);
+	kernel_set_isa(isa0);
+	gsl_vector_free(x);
+	gsl_vector_free(one);
+	gsl_matrix_free(ex);
+	gsl_vector_free(t);
+	gsl_vector_free(tau);
+	gsl_matrix_free(K);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the specialized against the generic products for every instantiated
+ size, then a whole solve on the ALV-7004 geometry
+
+------------------------------------------------------------------------------
+*/
+
+/* seconds per call of the three products, generic with enabled = 0 */
+static void fixed_time(const gsl_matrix* A, const gsl_vector* x, const gsl_vector* r,
+					   gsl_vector* y, gsl_vector* z, gsl_matrix* C, int enabled, int reps,
+					   double* time)
+{
+	int previous = fixed_set_enabled(enabled);
+	int k;
+
+	double t0 = wall_time();
+	for (k = 0; k < reps; k++)
+		if (!fixed_dgemv(CblasNoTrans, 1.0, A, x, 0.0, y))
+			gsl_blas_dgemv(CblasNoTrans, 1.0, A, x, 0.0, y);
+	double t1 = wall_time();
+	for (k = 0; k < reps; k++)
+		if (!fixed_dgemv(CblasTrans, 1.0, A, r, 0.0, z))
+			gsl_blas_dgemv(CblasTrans, 1.0, A, r, 0.0, z);
+	double t2 = wall_time();
+	for (k = 0; k < reps / 10 + 1; k++)
+		if (!fixed_dsyrk(A, C))
+			gsl_blas_dsyrk(CblasUpper, CblasTrans, 1.0, A, 0.0, C);
+	double t3 = wall_time();
+
+	time[0] = (t1 - t0) / reps;
+	time[1] = (t2 - t1) / reps;
+	time[2] = (t3 - t2) / (reps / 10 + 1);
+	fixed_set_enabled(previous);
+}
+
+/* largest difference relative to the largest entry */
+static double fixed_error(const double* a, const double* b, size_t n, size_t stride)
+{
+	double emax = 0, amax = 0;
+	size_t i;
+	for (i = 0; i < n; i++)
+	{
+		emax = GSL_MAX(emax, fabs(a[i * stride] - b[i * stride]));
+		amax = GSL_MAX(amax, fabs(a[i * stride]));
+	}
+	return amax > 0 ? emax / amax : emax;
+}
+
+static void fixed_benchmark(int reps)
+{
+	const char* variant = kernel_get_isa() == KERNEL_SCALAR ? "base" : "avx2";
+	int i, j, k, n, m;
+
+	for (k = 0; fixed_size(k, &n, &m); k++)
+	{
+		gsl_matrix* A  = gsl_matrix_alloc(n, m);
+		gsl_matrix* C0 = gsl_matrix_alloc(m, m);
+		gsl_matrix* C1 = gsl_matrix_alloc(m, m);
+		gsl_vector* x  = gsl_vector_alloc(m);
+		gsl_vector* r  = gsl_vector_alloc(n);
+		gsl_vector* y0 = gsl_vector_alloc(n);
+		gsl_vector* y1 = gsl_vector_alloc(n);
+		gsl_vector* z0 = gsl_vector_alloc(m);
+		gsl_vector* z1 = gsl_vector_alloc(m);
+
+		for (i = 0; i < n; i++)
+		{
+			gsl_vector_set(r, i, sin(1.0 + i));
+			for (j = 0; j < m; j++)
+				gsl_matrix_set(A, i, j, exp(-(i + 1.0) / (j + 1.0)));
+		}
+		for (j = 0; j < m; j++)
+			gsl_vector_set(x, j, cos(1.0 + j));
+
+		double tg[3], tf[3];
+		fixed_time(A, x, r, y0, z0, C0, 0, reps, tg);
+		fixed_time(A, x, r, y1, z1, C1, 1, reps, tf);
+
+		/* the upper triangle only, row by row */
+		double eg = 0;
+		for (j = 0; j < m; j++)
+			eg = GSL_MAX(eg, fixed_error(gsl_matrix_ptr(C0, j, j), gsl_matrix_ptr(C1, j, j), m - j, 1));
+
+		printf("fixed n = %3d, m = %3d, %s: A*x %6.2f us, speedup %5.2f, A^T*r %6.2f us, speedup %5.2f, "
+			   "Gram %7.1f us, speedup %5.2f, max rel error %.1e\n", n, m, variant,
+			   1e6 * tf[0], tg[0] / tf[0], 1e6 * tf[1], tg[1] / tf[1], 1e6 * tf[2], tg[2] / tf[2],
+			   GSL_MAX(GSL_MAX(fixed_error(y0->data, y1->data, n, 1), fixed_error(z0->data, z1->data, m, 1)), eg));
+
+		gsl_matrix_free(A);
+		gsl_matrix_free(C0);
+		gsl_matrix_free(C1);
+		gsl_vector_free(x);
+		gsl_vector_free(r);
+		gsl_vector_free(y0);
+		gsl_vector_free(y1);
+		gsl_vector_free(z0);
+		gsl_vector_free(z1);
+	}
+
+	/*
+	 SPG on the lags of an ALV-7004 correlogram between 1 us and 50 ms,
+	 the whole solve with and without the specialization
+	*/
+
+	fixture* fx = fixture_alloc(125, 1e-3, 50, 1e-6);
+	fixture_exponentials(fx, 0.6, 0.05, 0.4, 2, 1e-3, 0);
+	m = 100;
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g[2];
+	size_t iterations[2];
+	double time[2];
+
+	for (k = 0; k < 2; k++)
+	{
+		int previous = fixed_set_enabled(k);
+		contin_options opts;
+		double b;
+
+		g[k] = gsl_vector_alloc(m);
+		double t0 = wall_time();
+		parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 0.5, 1e-3, 50, m, 0, GRID_LOG);
+		contin_options_default(&opts);
+		contin_solve(p, &opts, s, g[k], &b);
+		time[k] = wall_time() - t0;
+		iterations[k] = opts.iterations;
+
+		parameter_free(p);
+		fixed_set_enabled(previous);
+	}
+
+	printf("fixed ALV-7004 solve n = %d, m = %d: generic %lu iterations in %.1f ms, specialized %lu in %.1f ms, "
+		   "speedup %.2f, |dg|/|g| = %.1e\n", (int) fx->t->size, m, (unsigned long) iterations[0], 1e3 * time[0],
+		   (unsigned long) iterations[1], 1e3 * time[1], time[0] / time[1], fixture_distance(g[1], g[0]));
+
+	fixture_free(fx);
+	gsl_vector_free(s);
+	gsl_vector_free(g[0]);
+	gsl_vector_free(g[1]);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ scaling of the setup, the products and a solve of fixed length with the
+ number of threads, and the check that every result is bitwise the one
+ of the serial run
+
+------------------------------------------------------------------------------
+*/
+
+static void thread_benchmark(int n, int m)
+{
+	int ncpu = contin_threads_default();
+	int nmax = GSL_MAX(ncpu, 2);
+	int k, r, reps = 20;
+	double base[5];
+
+	fixture* fx = fixture_alloc(n, 1e-4, 100, 1e-4);
+	fixture_exponentials(fx, 0.5, 0.02, 0.5, 3, 1e-3, 0);
+
+	gsl_vector* x  = gsl_vector_alloc(m);
+	gsl_vector* z  = gsl_vector_alloc(n);
+	gsl_vector* s  = gsl_vector_alloc(m);
+	gsl_vector* g  = gsl_vector_alloc(m);
+	gsl_vector* ax = gsl_vector_alloc(n);
+	gsl_vector* az = gsl_vector_alloc(m);
+	gsl_vector_set_all(x, 1.0);
+	gsl_vector_set_all(z, 1.0);
+
+	gsl_matrix* K0 = NULL;
+	gsl_matrix* G0 = NULL;
+	gsl_vector* ax0 = gsl_vector_alloc(n);
+	gsl_vector* az0 = gsl_vector_alloc(m);
+	gsl_vector* g0  = gsl_vector_alloc(m);
+	double tbase[3] = {0, 0, 0};
+
+	contin_options opts;
+	contin_options_default(&opts);
+	opts.minimizer.nmax = 200;
+
+	printf("n = %d, m = %d, %d cores, speedups against 1 thread in parentheses\n", n, m, ncpu);
+	printf("threads      setup ms          A*x ms        A^T*r ms         gram ms       200 it ms  identical\n");
+	for (k = 1; k <= nmax; k++)
+	{
+		contin_set_threads(k);
+
+		double t0 = wall_time();
+		parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-4, 100, m, 0, GRID_LOG);
+		double t1 = wall_time();
+		for (r = 0; r < reps; r++)
+			parameter_matvec(p, CblasNoTrans, 1.0, x, 0.0, ax);
+		double t2 = wall_time();
+		for (r = 0; r < reps; r++)
+			parameter_matvec(p, CblasTrans, 1.0, z, 0.0, az);
+		double t3 = wall_time();
+		parameter_gram(p);
+		double t4 = wall_time();
+		double b;
+		contin(p, &opts, s, g, &b, NULL);
+		double t5 = wall_time();
+
+		double time[5] = {t1 - t0, (t2 - t1) / reps, (t3 - t2) / reps, t4 - t3, t5 - t4};
+		int identical = 1, i;
+		if (k == 1)
+		{
+			memcpy(base, time, sizeof(base));
+			K0 = gsl_matrix_alloc(n, m);
+			G0 = gsl_matrix_alloc(m + 1, m + 1);
+			gsl_matrix_memcpy(K0, p->K);
+			gsl_matrix_memcpy(G0, p->G);
+			gsl_vector_memcpy(ax0, ax);
+			gsl_vector_memcpy(az0, az);
+			gsl_vector_memcpy(g0, g);
+
+			/* the unsplit products for reference */
+			gsl_matrix_view GA = gsl_matrix_submatrix(p->G, 0, 0, m, m);
+			double b0 = wall_time();
+			for (r = 0; r < reps; r++)
+				gsl_blas_dgemv(CblasNoTrans, 1.0, p->A, x, 0.0, ax);
+			double b1 = wall_time();
+			for (r = 0; r < reps; r++)
+				gsl_blas_dgemv(CblasTrans, 1.0, p->A, z, 0.0, az);
+			double b2 = wall_time();
+			gsl_blas_dsyrk(CblasUpper, CblasTrans, 1.0, p->A, 0.0, &GA.matrix);
+			double b3 = wall_time();
+			tbase[0] = (b1 - b0) / reps;
+			tbase[1] = (b2 - b1) / reps;
+			tbase[2] = b3 - b2;
+		}
+		else
+			identical = matrix_identical(K0, p->K) && matrix_identical(G0, p->G)
+				&& !memcmp(ax0->data, ax->data, n * sizeof(double))
+				&& !memcmp(az0->data, az->data, m * sizeof(double))
+				&& !memcmp(g0->data, g->data, m * sizeof(double));
+
+		printf("%7d", contin_get_threads());
+		for (i = 0; i < 5; i++)
+			printf("  %7.2f (%4.2f)", 1e3 * time[i], base[i] / time[i]);
+		printf("  %s%s\n", identical ? "yes" : "NO", k > ncpu ? ", more threads than cores" : "");
+
+		parameter_free(p);
+	}
+	printf("unsplit                    %7.2f         %7.2f         %7.2f\n",
+		   1e3 * tbase[0], 1e3 * tbase[1], 1e3 * tbase[2]);
+	contin_set_threads(1);
+
+	fixture_free(fx);
+	gsl_vector_free(x);
+	gsl_vector_free(z);
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	gsl_vector_free(ax);
+	gsl_vector_free(az);
+	gsl_vector_free(ax0);
+	gsl_vector_free(az0);
+	gsl_vector_free(g0);
+	gsl_matrix_free(K0);
+	gsl_matrix_free(G0);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the engines on a log grid of growing size, iterations beyond the limit
+ are marked with *
+
+------------------------------------------------------------------------------
+*/
+
+static void engine_benchmark(void)
+{
+	const char* name[] = {"spg", "nnls", "pgrad", "gencan", "mem"};
+	int solvers[] = {SOLVER_NNLS, SOLVER_SPG, SOLVER_PGRAD, SOLVER_MEM};
+	int sizes[] = {40, 80, 160};
+	int k, l;
+
+	fixture* fx = fixture_alloc(200, 1e-3, 50, 1e-4);
+	fixture_exponentials(fx, 0.5, 0.2, 0.5, 4, 1e-3, 0);
+
+	printf("  m  solver  iterations        ms    objective\n");
+	for (k = 0; k < 3; k++)
+	{
+		int m = sizes[k];
+		parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, 0, GRID_LOG);
+		gsl_vector* s = gsl_vector_alloc(m);
+		gsl_vector* g = gsl_vector_alloc(m);
+		double b;
+
+		for (l = 0; l < 4; l++)
+		{
+			contin_options opts;
+			contin_options_default(&opts);
+			opts.solver = solvers[l];
+			opts.minimizer.nmax = 20000;
+			double t0 = wall_time();
+			int status = contin_solve(p, &opts, s, g, &b);
+			double t1 = wall_time();
+
+			printf("%3d  %-6s  %10lu%s %8.1f  %.6e\n", m, name[solvers[l]],
+				   (unsigned long) opts.iterations, status == OOL_SUCCESS ? " " : "*",
+				   1e3 * (t1 - t0), fixture_objective(p, g, b));
+		}
+
+		gsl_vector_free(s);
+		gsl_vector_free(g);
+		parameter_free(p);
+	}
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ skyline and hierarchical kernels against the dense one on lag and tau
+ grids spanning eight decades
+
+------------------------------------------------------------------------------
+*/
+
+static void compressed_benchmark(void)
+{
+	int m = 1000, reps = 20, k, r;
+	size_t i;
+	const char* name[] = {"dense", "skyline", "hmatrix"};
+	double fill[] = {1, 0, 0};
+
+	fixture* fx = fixture_alloc(4000, 1e-6, 1e2, 1);
+	fixture_exponentials(fx, 1, 1e-3, 2, 1, 0, 0);
+	gsl_vector* tau = gsl_vector_alloc(m);
+	gsl_vector* x   = gsl_vector_alloc(m + 1);
+	gsl_vector* G   = gsl_vector_alloc(m + 1);
+	tau_grid(1e-6, 1e2, GRID_LOG, tau);
+	for (i = 0; i < m + 1; i++)
+		gsl_vector_set(x, i, 1.0 + sin(i));
+
+	printf("kernel    fill  build ms  gradient ms\n");
+	for (k = 0; k < 3; k++)
+	{
+		/* the build is the kernel and the Gram matrix, the compressed ones without K */
+		double t0 = wall_time();
+		parameter* p = parameter_alloc_kernel(fx->t, 0.01, tau, GRID_LOG, 0, 
+											  k == 1 ? 1e-12 : 0, k == 2 ? 1e-10 : 0);
+		parameter_set_data(p, fx->y, fx->var);
+		if (k == 1)
+			fill[k] = skyline_fill(p->Ks);
+		else if (k == 2)
+			fill[k] = hmatrix_fill(p->Kh);
+		double t1 = wall_time();
+		for (r = 0; r < reps; r++)
+			fun_df(x, p, G);
+		double t2 = wall_time();
+
+		printf("%-7s  %5.3f  %8.1f  %11.2f\n", name[k], fill[k], 1e3 * (t1 - t0), 1e3 * (t2 - t1) / reps);
+		parameter_free(p);
+	}
+
+	gsl_vector_free(tau);
+	gsl_vector_free(x);
+	gsl_vector_free(G);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ reduced solve in the leading singular vectors against the full solve
+
+------------------------------------------------------------------------------
+*/
+
+static void reduced_benchmark(void)
+{
+	int m = 80;
+	fixture* fx = fixture_alloc(2000, 1e-6, 1e1, 1);
+	fixture_exponentials(fx, 1, 1e-4, 2, 1e-2, 0, 0);
+	gsl_vector* tau = gsl_vector_alloc(m);
+	gsl_vector* s   = gsl_vector_alloc(m);
+	gsl_vector* gf  = gsl_vector_alloc(m);
+	gsl_vector* gr  = gsl_vector_alloc(m);
+	double bf, br;
+	contin_options opts;
+
+	tau_grid(1e-6, 1e1, GRID_LOG, tau);
+	parameter* p = parameter_alloc_grid(fx->t, fx->y, fx->var, 0.01, tau, GRID_LOG, 0);
+
+	contin_options_default(&opts);
+	double t0 = wall_time();
+	contin_solve(p, &opts, s, gf, &bf);
+	double t1 = wall_time();
+	size_t itf = opts.iterations;
+
+	opts.rtol = 1e-10;
+	contin_solve(p, &opts, s, gr, &br);
+	double t2 = wall_time();
+	contin_solve(p, &opts, s, gr, &br);
+	double t3 = wall_time();
+
+	printf("reduced solve: k = %lu of %d, truncation %.1e, |dg|/|g| = %.1e, "
+		   "%lu/%lu iterations, full %.0f ms, reduced %.0f ms (%.0f ms with the SVD), speedup %.1f\n",
+		   (unsigned long) opts.rank, m + 1, opts.truncation, fixture_distance(gr, gf),
+		   (unsigned long) itf, (unsigned long) opts.iterations, 1e3 * (t1 - t0), 1e3 * (t3 - t2),
+		   1e3 * (t2 - t1), (t1 - t0) / (t3 - t2));
+
+	gsl_vector_free(tau);
+	gsl_vector_free(s);
+	gsl_vector_free(gf);
+	gsl_vector_free(gr);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ float kernel with double refinement against the double kernel, on a
+ size where the products are split
+
+------------------------------------------------------------------------------
+*/
+
+static void single_benchmark(void)
+{
+	int n = 4000, m = 100, reps = 20, j, k;
+	fixture* fx = fixture_alloc(n, 1e-4, 100, 1e-4);
+	fixture_exponentials(fx, 0.5, 0.02, 0.5, 3, 1e-3, 0);
+
+	gsl_vector* s  = gsl_vector_alloc(m);
+	gsl_vector* xm = gsl_vector_alloc(m);
+	gsl_vector* xn = gsl_vector_alloc(n);
+	gsl_vector* ym = gsl_vector_alloc(m);
+	gsl_vector* yn = gsl_vector_alloc(n);
+	gsl_vector* g[2];
+	double b[2], tmv[2];
+	size_t its[2];
+	gsl_vector_set_all(xm, 1.0);
+	gsl_vector_set_all(xn, 1.0);
+
+	parameter* p[2];
+	for (k = 0; k < 2; k++)
+	{
+		contin_options opts;
+		p[k] = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-4, 100, m, 0, GRID_LOG);
+		parameter_single(p[k], k);
+
+		double t0 = wall_time();
+		for (j = 0; j < reps; j++)
+		{
+			parameter_matvec(p[k], CblasNoTrans, 1.0, xm, 0.0, yn);
+			parameter_matvec(p[k], CblasTrans, 1.0, xn, 0.0, ym);
+		}
+		tmv[k] = 1e3 * (wall_time() - t0) / reps;
+
+		g[k] = gsl_vector_alloc(m);
+		contin_options_default(&opts);
+		contin_solve(p[k], &opts, s, g[k], &b[k]);
+		its[k] = opts.iterations;
+	}
+
+	/* both objectives exact, on the double kernel */
+	printf("single kernel: A*x + A^T*r %.2f ms against %.2f ms, %lu iterations against %lu, "
+		   "|dg|/|g| = %.1e, objective %.6e / %.6e\n", tmv[1], tmv[0], (unsigned long) its[1],
+		   (unsigned long) its[0], fixture_distance(g[1], g[0]),
+		   fixture_objective(p[0], g[1], b[1]), fixture_objective(p[0], g[0], b[0]));
+
+	for (k = 0; k < 2; k++)
+	{
+		gsl_vector_free(g[k]);
+		parameter_free(p[k]);
+	}
+	gsl_vector_free(s);
+	gsl_vector_free(xm);
+	gsl_vector_free(xn);
+	gsl_vector_free(ym);
+	gsl_vector_free(yn);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ coarse-to-fine levels of contin2.m against a cold solve on the finest grid
+
+------------------------------------------------------------------------------
+*/
+
+static void multires_benchmark(void)
+{
+	const char* solver_name[] = {"spg", "nnls"};
+	int m = 40, cycles = 5, levels, k;
+	int mf = m + MULTIRES_STEP * (cycles - 1);
+	fixture* fx = fixture_alloc(200, 1e-3, 50, 1e-4);
+	fixture_exponentials(fx, 0.5, 0.2, 0.5, 4, 1e-3, 0);
+	gsl_vector* s  = gsl_vector_alloc(mf);
+	gsl_vector* gd = gsl_vector_alloc(mf);
+	gsl_vector* gm = gsl_vector_alloc(mf);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, mf, 0, GRID_LOG);
+	double bd, bm;
+	contin_options opts;
+
+	for (k = 0; k < 2; k++)
+	{
+		int solver = k == 0 ? SOLVER_SPG : SOLVER_NNLS;
+
+		contin_options_default(&opts);
+		opts.solver = solver;
+		double t0 = wall_time();
+		parameter* pc = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, mf, 0, GRID_LOG);
+		int sd = contin_solve(pc, &opts, s, gd, &bd);
+		parameter_free(pc);
+		double t1 = wall_time();
+		size_t itd = opts.iterations;
+
+		contin_options_default(&opts);
+		opts.solver = solver;
+		int sm = contin_multires(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, cycles, 0, MULTIRES_TOL,
+								 &opts, s, gm, &bm, &levels);
+		double t2 = wall_time();
+
+		printf("multires %-4s: %d of %d levels, %lu iterations in %.1f ms (status %d), "
+			   "finest grid %lu iterations in %.1f ms (status %d), |dg|/|g| = %.1e, objective %.6e / %.6e\n",
+			   solver_name[k], levels, cycles, (unsigned long) opts.iterations, 1e3 * (t2 - t1), sm,
+			   (unsigned long) itd, 1e3 * (t1 - t0), sd, fixture_distance(gm, gd),
+			   fixture_objective(p, gm, bm), fixture_objective(p, gd, bd));
+	}
+
+	gsl_vector_free(s);
+	gsl_vector_free(gd);
+	gsl_vector_free(gm);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the cost of adding a count and of a pooled solve as the counts of a
+ live run come in
+
+------------------------------------------------------------------------------
+*/
+
+static void pooled_benchmark(void)
+{
+	int n = 200, m = 40, nc = 6, k;
+	size_t i;
+	fixture* fx = fixture_alloc(n, 1e-4, 100, 1e-6);
+	gsl_vector* tau = gsl_vector_alloc(m);
+	gsl_vector* s   = gsl_vector_alloc(m);
+	gsl_vector* g   = gsl_vector_alloc(m);
+	double b;
+
+	tau_grid(1e-3, 50, GRID_LOG, tau);
+	contin_handle* h = contin_handle_alloc(fx->t, tau, GRID_LOG, 0, 0, 0);
+
+	printf("counts  add us  pooled ms  iterations  setups  chi2\n");
+	for (k = 0; k < nc; k++)
+	{
+		contin_options opts;
+		fixture_exponentials(fx, 0.5, 0.02, 0.5, 3, 1e-3, 7 * k);
+		for (i = 0; i < n; i++)
+			gsl_vector_set(fx->var, i, k < 2 ? 1e-6 : 1e-6 * (1 + 0.1 * k + 1e-3 * i));
+
+		double t0 = wall_time();
+		contin_handle_add(h, fx->y, fx->var);
+		double t1 = wall_time();
+		contin_options_default(&opts);
+		contin_handle_pooled(h, 1.0, &opts, s, g, &b);
+		double t2 = wall_time();
+
+		printf("%6d  %6.1f  %9.1f  %10lu  %6lu  %.6e\n", k + 1, 1e6 * (t1 - t0), 1e3 * (t2 - t1),
+			   (unsigned long) opts.iterations, (unsigned long) h->nsetup, h->acc->chi2);
+	}
+
+	contin_handle_free(h);
+	gsl_vector_free(tau);
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ one D distribution for several angles, the cost of adding and solving
+ against the number of angles
+
+------------------------------------------------------------------------------
+*/
+
+static void global_benchmark(void)
+{
+	int m = 60, k, j;
+	size_t N, nangles[] = {4, 16, 64};
+	fixture* fx = fixture_alloc(200, 1e-4, 100, 1e-6);
+	gsl_vector* D = gsl_vector_alloc(m);
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g = gsl_vector_alloc(m);
+
+	tau_grid(1e-2, 1e3, GRID_LOG, D);
+
+	printf("angles  add ms  solve ms  passes  iterations  peaks D (true 1 and 30)\n");
+	for (k = 0; k < 3; k++)
+	{
+		contin_options opts;
+		contin_global* gl = contin_global_alloc(D, GRID_LOG);
+		N = nangles[k];
+
+		double t0 = wall_time();
+		for (j = 0; j < N; j++)
+		{
+			double q2 = 0.5 * pow(16, (double) j / (N - 1));
+			double a = 1 + 0.3 * sin(j);
+			fixture_exponentials(fx, 0.5 * a, 1 / q2, 0.5 * a, 1 / (30 * q2), 1e-3, 3 * j);
+			gsl_vector_add_constant(fx->y, 0.01 * j / N);
+			contin_global_add(gl, fx->t, fx->y, fx->var, q2);
+		}
+		double t1 = wall_time();
+		contin_options_default(&opts);
+		opts.solver = SOLVER_NNLS;
+		contin_global_solve(gl, 1.0, &opts, s, g);
+		double t2 = wall_time();
+
+		printf("%6lu  %6.1f  %8.1f  %6lu  %10lu ", (unsigned long) N, 1e3 * (t1 - t0), 1e3 * (t2 - t1),
+			   (unsigned long) gl->passes, (unsigned long) opts.iterations);
+		double gmax = gsl_vector_max(g);
+		for (j = 1; j + 1 < m; j++)
+			if (gsl_vector_get(g, j) > gsl_vector_get(g, j - 1)
+				&& gsl_vector_get(g, j) >= gsl_vector_get(g, j + 1)
+				&& gsl_vector_get(g, j) >= PEAK_MIN * gmax)
+				printf(" %.4g", gsl_vector_get(s, j));
+		printf("\n");
+
+		contin_global_free(gl);
+	}
+
+	gsl_vector_free(D);
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ benchmark_contin.m without MATLAB: every ALV correlogram below
+ CONTIN_ALV_DATA is read like Instruments.ALVBASE.read_dynamic_file,
+ normalized like DLS.Point.correct_G, reduced like reduce_laplace and 
+ inverted like invert_laplace by every engine, gencan included, on linear 
+ tau grids of growing size, the table is the one of benchmark_contin.m
+
+------------------------------------------------------------------------------
+*/
+
+#define ALV_LAGS   400
+#define ALV_POINTS 10
+
+static size_t alv_read(const char* path, double* tau, double* g, double* dg)
+{
+	FILE* f = fopen(path, "r");
+	char line[1024];
+	size_t n = 0, nd = 0;
+	double a, c;
+
+	if (!f)
+		return 0;
+	while (fgets(line, sizeof line, f) && strncmp(line, "\"Correlation\"", 13))
+		;
+	while (n < ALV_LAGS && fgets(line, sizeof line, f) && sscanf(line, "%lf %lf", &a, &c) == 2)
+	{
+		tau[n] = a;
+		g[n++] = c;
+	}
+	while (fgets(line, sizeof line, f) && strncmp(line, "\"StandardDeviation\"", 19))
+		;
+	while (nd < n && fgets(line, sizeof line, f) && sscanf(line, "%lf %lf", &a, &c) == 2)
+		dg[nd++] = c;
+	fclose(f);
+	return nd == n ? n : 0;
+}
+
+/* correct_G and reduce_laplace, y = sqrt(G) on ALV_POINTS windows and its variance */
+static int alv_reduce(const char* path, gsl_vector* t, gsl_vector* y, gsl_vector* var)
+{
+	double tau[ALV_LAGS], g[ALV_LAGS], dg[ALV_LAGS];
+	size_t n = alv_read(path, tau, g, dg);
+	size_t i, k, l = 0, c = 0;
+	double norm = 0;
+
+	for (i = 0; i < n; i++)
+		if (tau[i] > 1e-5 && tau[i] < 1e-4)
+		{
+			norm += g[i];
+			c++;
+		}
+	if (!c)
+		return 0;
+	norm = fabs(norm / c);
+
+	for (i = 0; i < n; i++)
+		if (tau[i] > 1e-3 && tau[i] < 50 && g[i] > 0)
+		{
+			tau[l] = tau[i];
+			g[l]   = g[i] / norm;
+			dg[l]  = dg[i] / norm;
+			l++;
+		}
+	size_t lN = l / ALV_POINTS;
+	if (lN < 5)
+		return 0;
+
+	for (i = 0; i < ALV_POINTS; i++)
+	{
+		double ti = 0, gi = 0, dgi = 0;
+		for (k = lN * i; k < lN * i + 5; k++)
+		{
+			ti  += tau[k] / 5;
+			gi  += g[k] / 5;
+			dgi += dg[k] / 5;
+		}
+		double yi = sqrt(GSL_MAX(gi, 0));
+		double dy = 0.5 / GSL_MAX(yi, DBL_EPSILON) * dgi;
+		gsl_vector_set(t, i, ti);
+		gsl_vector_set(y, i, yi);
+		gsl_vector_set(var, i, dy * dy);
+	}
+	return 1;
+}
+
+static void alv_benchmark(void)
+{
+	const char* name[] = {"spg", "nnls", "pgrad", "gencan", "mem"};
+	int solvers[] = {SOLVER_SPG, SOLVER_PGRAD, SOLVER_GENCAN, SOLVER_NNLS, SOLVER_MEM};
+	int sizes[] = {50, 100, 200, 400};
+	double alpha = 0.15;
+	double time[5][4] = {{0}}, iterations[5][4] = {{0}};
+	int converged[5][4] = {{0}}, rejected[5] = {0};
+	size_t nfile = 0;
+	int i, j, k;
+
+	gsl_vector* t   = gsl_vector_alloc(ALV_POINTS);
+	gsl_vector* y   = gsl_vector_alloc(ALV_POINTS);
+	gsl_vector* var = gsl_vector_alloc(ALV_POINTS);
+
+	DIR* top = opendir(CONTIN_ALV_DATA);
+	struct dirent* run;
+	while (top && (run = readdir(top)))
+	{
+		char dir[1024], path[2048];
+		snprintf(dir, sizeof dir, "%s/%s", CONTIN_ALV_DATA, run->d_name);
+		DIR* sub = run->d_name[0] == '.' ? NULL : opendir(dir);
+		struct dirent* file;
+		while (sub && (file = readdir(sub)))
+		{
+			size_t len = strlen(file->d_name);
+			if (len < 4 || strcmp(file->d_name + len - 4, ".ASC"))
+				continue;
+			snprintf(path, sizeof path, "%s/%s", dir, file->d_name);
+			if (!alv_reduce(path, t, y, var))
+				continue;
+
+			for (i = 0; i < 5; i++)
+				for (j = 0; j < 4; j++)
+				{
+					int m = sizes[j];
+					gsl_vector* s = gsl_vector_alloc(m);
+					gsl_vector* g = gsl_vector_alloc(m);
+					double b;
+					contin_options opts;
+					contin_options_default(&opts);
+					opts.solver = solvers[i];
+
+					double t0 = wall_time();
+					parameter* p = parameter_alloc(t, y, var, alpha, gsl_vector_min(t), 
+												   gsl_vector_max(t), m, 0, GRID_LINEAR);
+					int status = contin_solve(p, &opts, s, g, &b);
+					parameter_free(p);
+					time[i][j] += wall_time() - t0;
+
+					iterations[i][j] += opts.iterations;
+					converged[i][j]  += status == OOL_SUCCESS;
+					rejected[i]      |= status == OOL_EINVAL;
+					gsl_vector_free(s);
+					gsl_vector_free(g);
+				}
+			nfile++;
+		}
+		if (sub)
+			closedir(sub);
+	}
+	if (top)
+		closedir(top);
+
+	printf("%lu correlograms, alpha = %g\n\n", (unsigned long) nfile, alpha);
+	printf("%8s %6s %12s %12s %10s\n", "solver", "m", "time [ms]", "iterations", "converged");
+	for (i = 0; i < 5; i++)
+		for (j = 0; j < 4; j++)
+		{
+			if (rejected[i])
+				printf("%8s %6d %12s\n", name[solvers[i]], sizes[j], "rejected");
+			else if (nfile)
+				printf("%8s %6d %12.2f %12.0f %6d/%lu\n", name[solvers[i]], sizes[j], 
+					   1e3 * time[i][j] / nfile, iterations[i][j] / nfile, 
+					   converged[i][j], (unsigned long) nfile);
+		}
+
+	gsl_vector_free(t);
+	gsl_vector_free(y);
+	gsl_vector_free(var);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the sections in the order of the description
+
+------------------------------------------------------------------------------
+*/
+
+static void run_kernel(void)   { kernel_benchmark(1000, 200); }
+static void run_fixed(void)    { fixed_benchmark(2000); }
+static void run_threads(void)  { thread_benchmark(8000, 200); }
+
+typedef struct
+{
+	const char* name;
+	void (*run)(void);
+	int named;					/* only runs when named on the command line */
+
+} section;
+
+int main(int argc, char** argv)
+{
+	section sections[] = {
+		{"kernel", run_kernel}, {"fixed", run_fixed}, {"threads", run_threads},
+		{"engines", engine_benchmark}, {"compressed", compressed_benchmark},
+		{"reduced", reduced_benchmark}, {"single", single_benchmark},
+		{"multires", multires_benchmark}, {"pooled", pooled_benchmark},
+		{"global", global_benchmark}, {"alv", alv_benchmark, 1}
+	};
+	int nsection = sizeof(sections) / sizeof(sections[0]);
+	int i, k;
+
+	for (k = 0; k < nsection; k++)
+	{
+		int selected = argc < 2 && !sections[k].named;
+		for (i = 1; i < argc; i++)
+			selected |= !strcmp(argv[i], sections[k].name);
+		if (!selected)
+			continue;
+		printf("-- %s\n", sections[k].name);
+		sections[k].run();
+	}
+	return 0;
+}
@@ -0,0 +1,375 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: Monte Carlo uncertainty bands of a CONTIN solution
+
+ The base problem is solved first, then R replicates of its data, each
+ perturbed with gaussian noise of the variance var. In the weighted data
+ sqrt(w).*y that noise has unit variance, so replicate r only replaces
+ swy by swy + e, with e drawn from its own generator seeded with
+ seed + r. The kernel, the weighted kernel, the Gram matrix, the hessian
+ and the reduced basis of the base problem do not depend on y and are
+ shared by all replicates, which only own their data and workspace. Every
+ replicate starts from the base solution at the base alpha.
+
+ The replicates run as chunks on the pool of contin_threads.c, nothing a
+ replicate computes depends on which thread ran it, so the bands are the
+ same for any number of threads.
+
+ The peaks of the base solution are its local maxima above PEAK_MIN of
+ the largest, each owns the grid points up to the minima next to it. The
+ position of a peak is the mean of ln(s) over its points weighted by the
+ mass g(j)*c(j), taken at the same points for every replicate.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_sort.h>
+#include <gsl/gsl_statistics.h>
+#include "contin.h"
+
+contin_bootstrap* contin_bootstrap_alloc(size_t R, size_t m, const gsl_vector* level, unsigned long seed)
+{
+	contin_bootstrap* bs = malloc(sizeof(contin_bootstrap));
+
+	bs->R         = R;
+	bs->seed      = seed;
+	bs->level     = gsl_vector_alloc(level->size);
+	bs->g         = gsl_matrix_alloc(R, m);
+	bs->b         = gsl_vector_alloc(R);
+	bs->band      = gsl_matrix_alloc(level->size, m);
+	bs->peak      = NULL;
+	bs->peaks     = NULL;
+	bs->peak_band = NULL;
+	bs->spread    = NULL;
+	bs->failed    = 0;
+	bs->iterations = 0;
+
+	gsl_vector_memcpy(bs->level, level);
+
+	return bs;
+}
+
+static void peaks_free(contin_bootstrap* bs)
+{
+	if ( bs->peak ) gsl_vector_free( bs->peak );
+	if ( bs->peaks ) gsl_matrix_free( bs->peaks );
+	if ( bs->peak_band ) gsl_matrix_free( bs->peak_band );
+	if ( bs->spread ) gsl_vector_free( bs->spread );
+	bs->peak      = NULL;
+	bs->peaks     = NULL;
+	bs->peak_band = NULL;
+	bs->spread    = NULL;
+}
+
+void contin_bootstrap_free(contin_bootstrap* bs)
+{
+	peaks_free(bs);
+	if ( bs->level ) gsl_vector_free( bs->level );
+	if ( bs->g ) gsl_matrix_free( bs->g );
+	if ( bs->b ) gsl_vector_free( bs->b );
+	if ( bs->band ) gsl_matrix_free( bs->band );
+	free(bs);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ a replicate of p, it shares everything but the data and the scratch
+ space, the hierarchical kernel gets its own product scratch z
+
+------------------------------------------------------------------------------
+*/
+
+static parameter* replicate_alloc(const parameter* p)
+{
+	parameter* q = malloc(sizeof(parameter));
+	int n = p->t->size;
+	int m = p->tau->size;
+
+	*q = *p;
+	q -> y   = gsl_vector_alloc( n );
+	q -> swy = gsl_vector_alloc( n );
+	q -> ws  = workspace_alloc( n, m );
+	q -> sf  = NULL;
+	q -> rd  = NULL;
+	q -> Kh  = NULL;
+
+	if (p->ws->um)
+	{
+		q->ws->um = gsl_vector_alloc(m);
+		q->ws->un = gsl_vector_alloc(n);
+	}
+	if (p->Ah)
+	{
+		q->Ah = malloc(sizeof(hmatrix));
+		*q->Ah = *p->Ah;
+		q->Ah->z = gsl_vector_alloc(p->Ah->z->size);
+	}
+
+	return q;
+}
+
+static void replicate_free(parameter* q)
+{
+	if (q->Ah)
+	{
+		gsl_vector_free(q->Ah->z);
+		free(q->Ah);
+	}
+	gsl_vector_free(q->y);
+	gsl_vector_free(q->swy);
+	workspace_free(q->ws);
+	free(q);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ peaks of the base solution, lo(k) <= j < hi(k) are the points of peak k,
+ returns the number of peaks
+
+------------------------------------------------------------------------------
+*/
+
+static size_t peaks_find(const gsl_vector* g, size_t* lo, size_t* hi)
+{
+	size_t m = g->size;
+	size_t j, k, npeaks = 0;
+	double gmax = gsl_vector_max(g);
+
+	if (gmax <= 0)
+		return 0;
+
+	for (j = 0; j < m; j++)
+	{
+		double gj = gsl_vector_get(g, j);
+		if ((j == 0 || gj > gsl_vector_get(g, j - 1))
+			&& (j == m - 1 || gj >= gsl_vector_get(g, j + 1))
+			&& gj >= PEAK_MIN * gmax)
+			hi[npeaks++] = j;
+	}
+
+	/* the minimum between two maxima ends the first peak and starts the second */
+	lo[0] = 0;
+	for (k = 0; k + 1 < npeaks; k++)
+	{
+		size_t jmin = hi[k];
+		for (j = hi[k]; j <= hi[k + 1]; j++)
+			if (gsl_vector_get(g, j) < gsl_vector_get(g, jmin))
+				jmin = j;
+		hi[k] = jmin;
+		lo[k + 1] = jmin;
+	}
+	if (npeaks)
+		hi[npeaks - 1] = m;
+
+	return npeaks;
+}
+
+/* position of the peak on lo <= j < hi, fallback if g has no mass there */
+static double peak_position(const gsl_vector* g, const gsl_vector* s, const gsl_vector* c,
+							size_t lo, size_t hi, double fallback)
+{
+	double mass = 0, moment = 0;
+	size_t j;
+
+	for (j = lo; j < hi; j++)
+	{
+		double mj = gsl_vector_get(g, j) * gsl_vector_get(c, j);
+		mass   += mj;
+		moment += mj * log(gsl_vector_get(s, j));
+	}
+
+	return mass > 0 ? exp(moment / mass) : fallback;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ one replicate per chunk
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	parameter* p;				/* the solved base problem */
+	const contin_options* opts;	/* options of the base solve */
+	const gsl_vector* x0;		/* base solution (g, b) */
+	contin_bootstrap* bs;
+	size_t npeaks;
+	const size_t* lo;
+	const size_t* hi;
+	size_t* iterations;			/* per replicate */
+	int* status;				/* per replicate */
+
+} bootstrap_task;
+
+static void replicate_chunk(void* arg, size_t r)
+{
+	bootstrap_task* bt = (bootstrap_task*) arg;
+	contin_bootstrap* bs = bt->bs;
+	parameter* p = bt->p;
+	size_t n = p->t->size;
+	size_t m = p->tau->size;
+	size_t i, k;
+
+	parameter* q = replicate_alloc(p);
+	gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
+	gsl_rng_set(rng, bs->seed + r);
+
+	for (i = 0; i < n; i++)
+	{
+		double swy = gsl_vector_get(p->swy, i) + gsl_ran_gaussian(rng, 1.0);
+		gsl_vector_set(q->swy, i, swy);
+		gsl_vector_set(q->y, i, swy / gsl_vector_get(p->sw, i));
+	}
+	gsl_rng_free(rng);
+
+	/* the base alpha, start and reduced basis */
+	contin_options ro = *bt->opts;
+	ro.criterion = ALPHA_FIXED;
+	ro.path      = NULL;
+	ro.x0        = bt->x0;
+	ro.rtol      = 0;
+
+	parameter* qr = NULL;
+	if (bt->opts->rtol > 0)
+	{
+		qr = replicate_alloc(p->rd->q);
+		gsl_blas_dgemv(CblasTrans, 1.0, p->rd->U, q->swy, 0.0, qr->swy);
+		gsl_vector_memcpy(qr->y, qr->swy);
+	}
+
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector_view g = gsl_matrix_row(bs->g, r);
+	bt->status[r] = contin_solve(qr ? qr : q, &ro, s, &g.vector, gsl_vector_ptr(bs->b, r));
+	bt->iterations[r] = ro.iterations;
+
+	for (k = 0; k < bt->npeaks; k++)
+		gsl_matrix_set(bs->peaks, r, k, peak_position(&g.vector, p->tau, p->c, bt->lo[k], bt->hi[k],
+													  gsl_vector_get(bs->peak, k)));
+
+	gsl_vector_free(s);
+	if (qr)
+		replicate_free(qr);
+	replicate_free(q);
+}
+
+/* quantiles at bs->level of every column of X into the rows of Q */
+static void column_quantiles(const gsl_matrix* X, const gsl_vector* level, gsl_matrix* Q)
+{
+	double* col = malloc(X->size1 * sizeof(double));
+	size_t i, j, l;
+
+	for (j = 0; j < X->size2; j++)
+	{
+		for (i = 0; i < X->size1; i++)
+			col[i] = gsl_matrix_get(X, i, j);
+		gsl_sort(col, 1, X->size1);
+
+		for (l = 0; l < level->size; l++)
+			gsl_matrix_set(Q, l, j, gsl_stats_quantile_from_sorted_data(col, 1, X->size1,
+																		 gsl_vector_get(level, l)));
+	}
+
+	free(col);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ solve p like contin_solve into s, g, b and the bs->R replicates into bs,
+ the replicates are split over the threads of contin_set_threads, returns
+ the status of the base solve
+
+------------------------------------------------------------------------------
+*/
+
+int contin_bootstrap_solve(parameter* p,
+						   contin_options* opts,
+						   gsl_vector* s,
+						   gsl_vector* g,
+						   double* b,
+						   contin_bootstrap* bs)
+{
+	size_t m = p->tau->size;
+	size_t R = bs->R;
+	size_t k, r;
+
+	int status = contin_solve(p, opts, s, g, b);
+
+	gsl_vector* x0 = gsl_vector_alloc(m + 1);
+	gsl_vector_view xg = gsl_vector_subvector(x0, 0, m);
+	gsl_vector_memcpy(&xg.vector, g);
+	gsl_vector_set(x0, m, *b);
+
+	size_t* lo = malloc(m * sizeof(size_t));
+	size_t* hi = malloc(m * sizeof(size_t));
+	size_t npeaks = peaks_find(g, lo, hi);
+
+	peaks_free(bs);
+	if (npeaks)
+	{
+		bs->peak      = gsl_vector_alloc(npeaks);
+		bs->peaks     = gsl_matrix_alloc(R, npeaks);
+		bs->peak_band = gsl_matrix_alloc(bs->level->size, npeaks);
+		bs->spread    = gsl_vector_alloc(npeaks);
+		for (k = 0; k < npeaks; k++)
+			gsl_vector_set(bs->peak, k, peak_position(g, p->tau, p->c, lo[k], hi[k], 0));
+	}
+
+	bootstrap_task bt;
+	bt.p          = p;
+	bt.opts       = opts;
+	bt.x0         = x0;
+	bt.bs         = bs;
+	bt.npeaks     = npeaks;
+	bt.lo         = lo;
+	bt.hi         = hi;
+	bt.iterations = malloc(R * sizeof(size_t));
+	bt.status     = malloc(R * sizeof(int));
+
+	parallel_chunks(R, replicate_chunk, &bt);
+
+	bs->failed = 0;
+	bs->iterations = 0;
+	for (r = 0; r < R; r++)
+	{
+		bs->failed += bt.status[r] != OOL_SUCCESS;
+		bs->iterations += bt.iterations[r];
+	}
+
+	column_quantiles(bs->g, bs->level, bs->band);
+	if (npeaks)
+	{
+		column_quantiles(bs->peaks, bs->level, bs->peak_band);
+
+		/* the relative spread, standard deviation of ln(position) */
+		for (k = 0; k < npeaks; k++)
+		{
+			double mean = 0, var = 0;
+			for (r = 0; r < R; r++)
+				mean += log(gsl_matrix_get(bs->peaks, r, k)) / R;
+			for (r = 0; r < R; r++)
+			{
+				double d = log(gsl_matrix_get(bs->peaks, r, k)) - mean;
+				var += d * d;
+			}
+			gsl_vector_set(bs->spread, k, R > 1 ? sqrt(var / (R - 1)) : 0);
+		}
+	}
+
+	free(bt.iterations);
+	free(bt.status);
+	free(lo);
+	free(hi);
+	gsl_vector_free(x0);
+
+	return status;
+}
@@ -0,0 +1,296 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: dense products for fixed correlator geometries
+
+ A correlator always delivers the same number of lags, and DLS.Point
+ inverts on a few tau grid sizes only, so the dense products A*x, A^T*r
+ and the Gram matrix A^T*A mostly run on a handful of (n, m). For those
+ the loops are instantiated from templates with n and m known to the
+ compiler: the trip counts are constants, the loops are unrolled and
+ vectorized without remainder handling, the adjoint accumulates in a
+ stack array of m instead of y, two rows at a time. Every size is built
+ twice, for the baseline instruction set and with AVX2 and FMA, the
+ variant follows kernel_get_isa of contin_kernel.c.
+
+ fixed_dgemv and fixed_dsyrk look the sizes up and return 0 for any other
+ geometry or a strided matrix, the caller then takes the generic BLAS
+ path. FIXED_SIZES lists the instantiated pairs, fixed_size enumerates
+ them for contin_test.c and contin_bench.c.
+
+------------------------------------------------------------------------------
+*/
+
+#include "contin.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define FIXED_X86
+#endif
+
+/* independent partial sums of a row product, two AVX2 registers */
+#define FIXED_LANES 8
+
+/*
+ n lags and m grid points, ALV-7004 correlograms have 238 lags, 125 of
+ them between 1 us and 50 ms where DLS.Point inverts
+*/
+#define FIXED_SIZES(X) \
+	X(10, 100)		/* DLS.Point.invert_laplace, 10 windows, 10 grid points per window */ \
+	X(125, 100)		/* ALV-7004 lags between 1 us and 50 ms */ \
+	X(125, 200) \
+	X(238, 100)		/* all lags of an ALV-7004 correlogram */ \
+	X(238, 200)
+
+/*
+------------------------------------------------------------------------------
+
+ the products for one (N, M), A row-major with M columns
+
+------------------------------------------------------------------------------
+*/
+
+template <int N, int M>
+struct fixed_product
+{
+	/* y = alpha*A*x + beta*y */
+	static inline __attribute__((always_inline))
+	void forward(double alpha, const double* __restrict A, const double* __restrict x,
+				 double beta, double* __restrict y)
+	{
+		const int M0 = M - M % FIXED_LANES;
+
+		for (int i = 0; i < N; i++)
+		{
+			const double* a = A + i * M;
+			double s[FIXED_LANES] = {0};
+
+			for (int j = 0; j < M0; j += FIXED_LANES)
+				for (int l = 0; l < FIXED_LANES; l++)
+					s[l] += a[j + l] * x[j + l];
+
+			double sum = 0;
+			for (int j = M0; j < M; j++)
+				sum += a[j] * x[j];
+			for (int l = 0; l < FIXED_LANES; l++)
+				sum += s[l];
+
+			y[i] = alpha * sum + (beta == 0 ? 0 : beta * y[i]);
+		}
+	}
+
+	/* y = alpha*A^T*x + beta*y */
+	static inline __attribute__((always_inline))
+	void adjoint(double alpha, const double* __restrict A, const double* __restrict x,
+				 double beta, double* __restrict y)
+	{
+		double acc[M];
+		int i, j;
+
+		for (j = 0; j < M; j++)
+			acc[j] = 0;
+
+		for (i = 0; i + 2 <= N; i += 2)
+		{
+			const double* a0 = A + i * M;
+			const double* a1 = a0 + M;
+			double x0 = x[i], x1 = x[i + 1];
+			for (j = 0; j < M; j++)
+				acc[j] += x0 * a0[j] + x1 * a1[j];
+		}
+		if (N % 2)
+		{
+			const double* a0 = A + (N - 1) * M;
+			double x0 = x[N - 1];
+			for (j = 0; j < M; j++)
+				acc[j] += x0 * a0[j];
+		}
+
+		for (j = 0; j < M; j++)
+			y[j] = alpha * acc[j] + (beta == 0 ? 0 : beta * y[j]);
+	}
+
+	/* upper triangle of C = A^T*A, C with row stride ldc */
+	static inline __attribute__((always_inline))
+	void gram(const double* __restrict A, double* __restrict C, size_t ldc)
+	{
+		int i, j, k;
+
+		for (j = 0; j < M; j++)
+			for (k = j; k < M; k++)
+				C[j * ldc + k] = 0;
+
+		for (i = 0; i + 2 <= N; i += 2)
+		{
+			const double* a0 = A + i * M;
+			const double* a1 = a0 + M;
+			for (j = 0; j < M; j++)
+			{
+				double u0 = a0[j], u1 = a1[j];
+				double* c = C + j * ldc;
+				for (k = j; k < M; k++)
+					c[k] += u0 * a0[k] + u1 * a1[k];
+			}
+		}
+		if (N % 2)
+		{
+			const double* a0 = A + (N - 1) * M;
+			for (j = 0; j < M; j++)
+			{
+				double u0 = a0[j];
+				double* c = C + j * ldc;
+				for (k = j; k < M; k++)
+					c[k] += u0 * a0[k];
+			}
+		}
+	}
+};
+
+typedef void (*fixed_gemv)(double, const double*, const double*, double, double*);
+typedef void (*fixed_syrk)(const double*, double*, size_t);
+
+template <int N, int M>
+static void forward_base(double alpha, const double* A, const double* x, double beta, double* y)
+{
+	fixed_product<N, M>::forward(alpha, A, x, beta, y);
+}
+
+template <int N, int M>
+static void adjoint_base(double alpha, const double* A, const double* x, double beta, double* y)
+{
+	fixed_product<N, M>::adjoint(alpha, A, x, beta, y);
+}
+
+template <int N, int M>
+static void gram_base(const double* A, double* C, size_t ldc)
+{
+	fixed_product<N, M>::gram(A, C, ldc);
+}
+
+#ifdef FIXED_X86
+
+template <int N, int M> __attribute__((target("avx2,fma")))
+static void forward_avx2(double alpha, const double* A, const double* x, double beta, double* y)
+{
+	fixed_product<N, M>::forward(alpha, A, x, beta, y);
+}
+
+template <int N, int M> __attribute__((target("avx2,fma")))
+static void adjoint_avx2(double alpha, const double* A, const double* x, double beta, double* y)
+{
+	fixed_product<N, M>::adjoint(alpha, A, x, beta, y);
+}
+
+template <int N, int M> __attribute__((target("avx2,fma")))
+static void gram_avx2(const double* A, double* C, size_t ldc)
+{
+	fixed_product<N, M>::gram(A, C, ldc);
+}
+
+	#define FIXED_VECTOR(f, n, m) f##_avx2<n, m>
+#else
+	#define FIXED_VECTOR(f, n, m) f##_base<n, m>
+#endif
+
+/*
+------------------------------------------------------------------------------
+
+ table of the instantiated sizes, base and vector variant
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	int n;
+	int m;
+	fixed_gemv forward[2];
+	fixed_gemv adjoint[2];
+	fixed_syrk gram[2];
+
+} fixed_entry;
+
+#define FIXED_ENTRY(n, m) \
+	{ n, m, { forward_base<n, m>, FIXED_VECTOR(forward, n, m) }, \
+			{ adjoint_base<n, m>, FIXED_VECTOR(adjoint, n, m) }, \
+			{ gram_base<n, m>, FIXED_VECTOR(gram, n, m) } },
+
+static const fixed_entry fixed_table[] = { FIXED_SIZES(FIXED_ENTRY) };
+
+#define FIXED_COUNT (sizeof(fixed_table) / sizeof(fixed_table[0]))
+
+static int fixed_enabled = 1;
+
+static const fixed_entry* fixed_lookup(size_t n, size_t m)
+{
+	size_t k;
+
+	if (!fixed_enabled)
+		return NULL;
+	for (k = 0; k < FIXED_COUNT; k++)
+		if (fixed_table[k].n == (int) n && fixed_table[k].m == (int) m)
+			return &fixed_table[k];
+	return NULL;
+}
+
+static int fixed_variant(void)
+{
+	return kernel_get_isa() != KERNEL_SCALAR;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ y = alpha*op(A)*x + beta*y like gsl_blas_dgemv if A is n x m of a
+ specialized size, contiguous, and x, y have unit stride, otherwise
+ nothing is done and 0 returned
+
+------------------------------------------------------------------------------
+*/
+
+extern "C" int fixed_dgemv(CBLAS_TRANSPOSE_t trans,
+						   double alpha,
+						   const gsl_matrix* A,
+						   const gsl_vector* x,
+						   double beta,
+						   gsl_vector* y)
+{
+	const fixed_entry* e = fixed_lookup(A->size1, A->size2);
+
+	if (!e || A->tda != A->size2 || x->stride != 1 || y->stride != 1)
+		return 0;
+
+	if (trans == CblasNoTrans)
+		e->forward[fixed_variant()](alpha, A->data, x->data, beta, y->data);
+	else
+		e->adjoint[fixed_variant()](alpha, A->data, x->data, beta, y->data);
+	return 1;
+}
+
+/* upper triangle of C = A^T*A like gsl_blas_dsyrk, 0 if A is not specialized */
+extern "C" int fixed_dsyrk(const gsl_matrix* A, gsl_matrix* C)
+{
+	const fixed_entry* e = fixed_lookup(A->size1, A->size2);
+
+	if (!e || A->tda != A->size2)
+		return 0;
+
+	e->gram[fixed_variant()](A->data, C->data, C->tda);
+	return 1;
+}
+
+extern "C" int fixed_set_enabled(int enabled)
+{
+	int previous = fixed_enabled;
+	fixed_enabled = enabled;
+	return previous;
+}
+
+/* the k-th instantiated size in n, m, 0 past the last */
+extern "C" int fixed_size(int k, int* n, int* m)
+{
+	if (k < 0 || (size_t) k >= FIXED_COUNT)
+		return 0;
+	*n = fixed_table[k].n;
+	*m = fixed_table[k].m;
+	return 1;
+}
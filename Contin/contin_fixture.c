@@ -0,0 +1,144 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: synthetic correlograms shared by contin_test.c and
+ contin_bench.c
+
+ The noise is the deterministic stand-in noise*sin(1e4*(i + 1) + phase),
+ which is uncorrelated enough between neighbouring lags to regularize
+ against while every run sees the same data. Not part of the MEX, the
+ build lines are in contin_test.c and contin_bench.c.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include "contin_fixture.h"
+
+/*
+------------------------------------------------------------------------------
+
+ n lags spaced logarithmically from t0 to t1, y = 0 and a constant variance
+
+------------------------------------------------------------------------------
+*/
+
+fixture* fixture_alloc(int n, double t0, double t1, double var)
+{
+	fixture* fx = malloc(sizeof(fixture));
+
+	fx->t   = gsl_vector_alloc(n);
+	fx->y   = gsl_vector_calloc(n);
+	fx->var = gsl_vector_alloc(n);
+	tau_grid(t0, t1, GRID_LOG, fx->t);
+	gsl_vector_set_all(fx->var, var);
+
+	return fx;
+}
+
+void fixture_free(fixture* fx)
+{
+	gsl_vector_free(fx->t);
+	gsl_vector_free(fx->y);
+	gsl_vector_free(fx->var);
+	free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ correlator lags from 1e-3 on, equidistant for multitau = 0, else 16
+ channels per block with the spacing doubling from block to block
+
+------------------------------------------------------------------------------
+*/
+
+void fixture_lags(gsl_vector* t, int multitau)
+{
+	double ti = 0, dt = 1e-3;
+	size_t i;
+
+	for (i = 0; i < t->size; i++)
+	{
+		if (multitau && i > 0 && i % 16 == 0)
+			dt *= 2;
+		ti += dt;
+		gsl_vector_set(t, i, multitau ? ti : 1e-3 * (i + 1));
+	}
+}
+
+/* y = a1*exp(-t/tau1) + a2*exp(-t/tau2) plus the stand-in noise */
+void fixture_exponentials(fixture* fx,
+						  double a1,
+						  double tau1,
+						  double a2,
+						  double tau2,
+						  double noise,
+						  double phase)
+{
+	size_t i;
+	for (i = 0; i < fx->t->size; i++)
+	{
+		double ti = gsl_vector_get(fx->t, i);
+		gsl_vector_set(fx->y, i, a1 * exp(-ti / tau1) + a2 * exp(-ti / tau2)
+					   + noise * sin(1e4 * (i + 1) + phase));
+	}
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the synthetic cases of test_contin.m, two exponentials on 39 equidistant
+ lags for kernelType 0, two Lorentzians on 501 for kernelType 1
+
+------------------------------------------------------------------------------
+*/
+
+fixture* fixture_test_case(int kernelType)
+{
+	int n = kernelType == 0 ? 39 : 501;
+	fixture* fx = fixture_alloc(n, 1, 2, kernelType == 0 ? 0.25 : 0.0625);
+	int i;
+
+	for (i = 0; i < n; i++)
+	{
+		double ti = kernelType == 0 ? 1 + 0.5 * i : 0.01 * i;
+		double yi = kernelType == 0
+			? 0.5 * exp(-ti / 2) + 0.5 * exp(-ti / 4)
+			: 3 * M_1_PI * 0.4 / (ti * ti + 0.4 * 0.4) + 5 * M_1_PI * 2 / (ti * ti + 2 * 2);
+		gsl_vector_set(fx->t, i, ti);
+		gsl_vector_set(fx->y, i, yi + (kernelType == 0 ? 0.015 : 0.25) * sin(1e4 * (i + 1)));
+	}
+
+	return fx;
+}
+
+/* objective of p at the distribution g and background b */
+double fixture_objective(parameter* p, const gsl_vector* g, double b)
+{
+	size_t m = g->size;
+	gsl_vector* x = gsl_vector_alloc(m + 1);
+	gsl_vector_view xg = gsl_vector_subvector(x, 0, m);
+
+	gsl_vector_memcpy(&xg.vector, g);
+	gsl_vector_set(x, m, b);
+	double f = fun(x, p);
+
+	gsl_vector_free(x);
+	return f;
+}
+
+/* |a - b|/|b| */
+double fixture_distance(const gsl_vector* a, const gsl_vector* b)
+{
+	double d = 0, nb = 0;
+	size_t i;
+	for (i = 0; i < a->size; i++)
+	{
+		double di = gsl_vector_get(a, i) - gsl_vector_get(b, i);
+		d  += di * di;
+		nb += gsl_vector_get(b, i) * gsl_vector_get(b, i);
+	}
+	return nb > 0 ? sqrt(d / nb) : sqrt(d);
+}
@@ -0,0 +1,32 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: synthetic correlograms shared by contin_test.c and
+ contin_bench.c, not part of the MEX
+
+------------------------------------------------------------------------------
+*/
+
+#ifndef CONTIN_FIXTURE_H
+#define CONTIN_FIXTURE_H
+
+#include "contin.h"
+
+typedef struct
+{
+	gsl_vector* t;		/* lags */
+	gsl_vector* y;		/* correlogram */
+	gsl_vector* var;	/* variance of y */
+
+} fixture;
+
+fixture* fixture_alloc(int n, double t0, double t1, double var);
+fixture* fixture_test_case(int kernelType);
+void fixture_free(fixture* fx);
+void fixture_lags(gsl_vector* t, int multitau);
+void fixture_exponentials(fixture* fx, double a1, double tau1, double a2, double tau2,
+						  double noise, double phase);
+double fixture_objective(parameter* p, const gsl_vector* g, double b);
+double fixture_distance(const gsl_vector* a, const gsl_vector* b);
+
+#endif
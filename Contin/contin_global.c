@@ -0,0 +1,358 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: one CONTIN distribution in D shared by several angles
+
+ Angle k with scattering vector q(k) measures
+
+ y_k(t) = a(k)*sum_j c(j)*exp(-D(j)*q(k)^2*t)*g(j) + b(k)
+
+ with its own amplitude a(k) and baseline b(k) but the same distribution
+ g of the diffusion coefficient D. For given amplitudes the baseline of
+ an angle is linear in g, b(k) = yb(k) - a(k)*kb(k)^T*g with the weighted
+ means yb and kb of the data and of the kernel columns. Eliminating it
+ projects the weighted kernel A_k and data sqrt(w)*y_k of the angle onto
+ the complement P_k of sqrt(w), and the stacked objective becomes
+
+ sum_k |a(k)*P_k*A_k*g - P_k*sqrt(w)*y_k|^2
+     = g^T*(sum_k a(k)^2*G_k)*g - 2*g^T*(sum_k a(k)*h_k) + sum_k yy(k)
+
+ with G_k = (P_k*A_k)^T*P_k*A_k and h_k = (P_k*A_k)^T*sqrt(w)*y_k. These
+ are built once per angle at O(n*m^2), contin_global_add, afterwards the
+ angles only enter as m x m blocks summed at O(m^2) each. A solve
+ alternates between g for fixed amplitudes, one problem in m unknowns
+ whatever the number of angles, and the amplitudes for fixed g, each the
+ one dimensional least squares a(k) = g^T*h_k/(g^T*G_k*g). The amplitudes
+ are normalized to mean 1, g is the distribution of the mean angle. The
+ passes end when no amplitude changes by more than GLOBAL_TOL.
+
+ The g problem runs through contin_solve on the square root of the
+ summed Gram matrix like contin_accumulate.c. The background column of
+ that root is a single row with data 0, its b is 0 at the minimum and
+ decoupled from g, the baselines of the angles follow from g afterwards.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <gsl/gsl_linalg.h>
+#include "contin.h"
+
+contin_global* contin_global_alloc(const gsl_vector* D, int gridType)
+{
+	contin_global* gl = malloc(sizeof(contin_global));
+	size_t m = D->size;
+
+	gl->D       = gsl_vector_alloc(m);
+	gl->c       = gsl_vector_alloc(m);
+	gl->angle   = NULL;
+	gl->nangles = 0;
+	gl->nalloc  = 0;
+	gl->x       = NULL;
+	gl->a       = NULL;
+	gl->b       = NULL;
+	gl->chi2    = NULL;
+	gl->passes  = 0;
+
+	gsl_vector_memcpy(gl->D, D);
+	quadrature_weights(gl->D, gridType, gl->c);
+
+	return gl;
+}
+
+void contin_global_free(contin_global* gl)
+{
+	size_t k;
+	for (k = 0; k < gl->nangles; k++)
+	{
+		gsl_matrix_free(gl->angle[k].G);
+		gsl_vector_free(gl->angle[k].h);
+		gsl_vector_free(gl->angle[k].kb);
+	}
+	free(gl->angle);
+
+	if ( gl->D ) gsl_vector_free( gl->D );
+	if ( gl->c ) gsl_vector_free( gl->c );
+	if ( gl->x ) gsl_vector_free( gl->x );
+	if ( gl->a ) gsl_vector_free( gl->a );
+	if ( gl->b ) gsl_vector_free( gl->b );
+	if ( gl->chi2 ) gsl_vector_free( gl->chi2 );
+	free(gl);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ add an angle, lags t, data y with variance var and q2 = q^2 in the units
+ that make D*q2*t dimensionless, O(n*m^2)
+
+------------------------------------------------------------------------------
+*/
+
+int contin_global_add(contin_global* gl,
+					  const gsl_vector* t,
+					  const gsl_vector* y,
+					  const gsl_vector* var,
+					  double q2)
+{
+	size_t n = t->size;
+	size_t m = gl->D->size;
+	size_t i, j;
+
+	if (y->size != n || var->size != n || q2 <= 0)
+		return OOL_EBADLEN;
+
+	if (gl->nangles == gl->nalloc)
+	{
+		gl->nalloc = gl->nalloc ? 2 * gl->nalloc : 8;
+		gl->angle  = realloc(gl->angle, gl->nalloc * sizeof(global_angle));
+	}
+	global_angle* ga = &gl->angle[gl->nangles];
+
+	/* exp(-D*q2*t) is the exponential kernel at tau = 1/(q2*D) */
+	gsl_vector* tau = gsl_vector_alloc(m);
+	for (j = 0; j < m; j++)
+		gsl_vector_set(tau, j, 1.0 / (q2 * gsl_vector_get(gl->D, j)));
+
+	gsl_matrix* A = gsl_matrix_alloc(n, m);
+	kernel_build(A, t, tau, 0);
+
+	gsl_vector* sw  = gsl_vector_alloc(n);
+	gsl_vector* swy = gsl_vector_alloc(n);
+	double S = 0;
+	for (i = 0; i < n; i++)
+	{
+		double swi = 1.0 / sqrt(gsl_vector_get(var, i));
+		gsl_vector_set(sw, i, swi);
+		gsl_vector_set(swy, i, swi * gsl_vector_get(y, i));
+		S += swi * swi;
+	}
+
+	/* weighted kernel and data with sqrt(w) projected out */
+	ga->kb = gsl_vector_alloc(m);
+	for (j = 0; j < m; j++)
+	{
+		gsl_vector_view col = gsl_matrix_column(A, j);
+		double kbj;
+		gsl_vector_mul(&col.vector, sw);
+		gsl_vector_scale(&col.vector, gsl_vector_get(gl->c, j));
+		gsl_blas_ddot(sw, &col.vector, &kbj);
+		gsl_blas_daxpy(-kbj / S, sw, &col.vector);
+		gsl_vector_set(ga->kb, j, kbj / S);
+	}
+	gsl_blas_ddot(sw, swy, &ga->yb);
+	ga->yb /= S;
+	gsl_blas_daxpy(-ga->yb, sw, swy);
+	gsl_blas_ddot(swy, swy, &ga->yy);
+
+	ga->G = gsl_matrix_alloc(m, m);
+	ga->h = gsl_vector_alloc(m);
+	gsl_blas_dsyrk(CblasUpper, CblasTrans, 1.0, A, 0.0, ga->G);
+	for (i = 0; i < m; i++)
+		for (j = 0; j < i; j++)
+			gsl_matrix_set(ga->G, i, j, gsl_matrix_get(ga->G, j, i));
+	gsl_blas_dgemv(CblasTrans, 1.0, A, swy, 0.0, ga->h);
+	ga->q2 = q2;
+
+	gl->nangles++;
+
+	gsl_vector_free(tau);
+	gsl_vector_free(sw);
+	gsl_vector_free(swy);
+	gsl_matrix_free(A);
+
+	return GSL_SUCCESS;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ CONTIN problem in g for the amplitudes a, the square root of
+ G = sum_k a(k)^2*G_k as its rows and one unit row for b
+
+------------------------------------------------------------------------------
+*/
+
+static parameter* global_root(const contin_global* gl, double alpha)
+{
+	size_t m = gl->D->size;
+	size_t i, j, k;
+
+	gsl_matrix* G = gsl_matrix_calloc(m, m);
+	gsl_vector* h = gsl_vector_calloc(m);
+	for (k = 0; k < gl->nangles; k++)
+	{
+		double ak = gsl_vector_get(gl->a, k);
+		for (i = 0; i < m; i++)
+			for (j = i; j < m; j++)
+				*gsl_matrix_ptr(G, i, j) += ak * ak * gsl_matrix_get(gl->angle[k].G, i, j);
+		gsl_blas_daxpy(ak, gl->angle[k].h, h);
+	}
+
+	for (i = 0; i < m; i++)
+		for (j = 0; j < i; j++)
+			gsl_matrix_set(G, i, j, gsl_matrix_get(G, j, i));
+
+	gsl_matrix* V = gsl_matrix_alloc(m, m);
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* work = gsl_vector_alloc(m);
+	gsl_linalg_SV_decomp(G, V, s, work);
+
+	double s1 = gsl_vector_get(s, 0);
+	size_t nk;
+	for (nk = 1; nk < m && gsl_vector_get(s, nk) > GRAM_ROOT_TOL * s1; nk++)
+		;
+
+	/* 
+	 R = S^(1/2)*V^T in nk rows, the last row pins b with the largest 
+	 curvature of G, a unit row would be the slowest direction by far
+	*/
+	gsl_matrix* R = gsl_matrix_calloc(nk + 1, m + 1);
+	for (i = 0; i < nk; i++)
+		for (j = 0; j < m; j++)
+			gsl_matrix_set(R, i, j, sqrt(gsl_vector_get(s, i)) * gsl_matrix_get(V, j, i));
+	gsl_matrix_set(R, nk, m, sqrt(s1));
+
+	/* only the grid and alpha of the template are read */
+	parameter shape;
+	shape.tau   = gl->D;
+	shape.c     = gl->c;
+	shape.alpha = alpha;
+	parameter* q = parameter_alloc_projected(&shape, R);
+
+	/* the data S^(-1/2)*V^T*h, 0 for b */
+	for (i = 0; i < nk; i++)
+	{
+		gsl_vector_view vi = gsl_matrix_column(V, i);
+		double vh;
+		gsl_blas_ddot(&vi.vector, h, &vh);
+		gsl_vector_set(q->swy, i, vh / sqrt(gsl_vector_get(s, i)));
+	}
+	gsl_vector_memcpy(q->y, q->swy);
+
+	gsl_matrix_free(G);
+	gsl_matrix_free(V);
+	gsl_matrix_free(R);
+	gsl_vector_free(h);
+	gsl_vector_free(s);
+	gsl_vector_free(work);
+
+	return q;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ solve for g on D with the amplitudes, baselines and residuals of the
+ angles in gl->a, gl->b, gl->chi2, s receives D, opts->x0 defaults to
+ the previous solution, opts->iterations sums the solves of all passes
+
+------------------------------------------------------------------------------
+*/
+
+int contin_global_solve(contin_global* gl,
+						double alpha,
+						contin_options* opts,
+						gsl_vector* s,
+						gsl_vector* g)
+{
+	size_t m = gl->D->size;
+	size_t N = gl->nangles;
+	size_t k;
+	int status = OOL_EMAXITER;
+
+	if (N == 0 || s->size != m || g->size != m || opts->criterion != ALPHA_FIXED)
+		return OOL_EBADLEN;
+
+	/* the amplitudes of the previous solve start the passes if N is unchanged */
+	if (gl->a && gl->a->size != N)
+	{
+		gsl_vector_free(gl->a);
+		gsl_vector_free(gl->b);
+		gsl_vector_free(gl->chi2);
+		gl->a = NULL;
+	}
+	if (!gl->a)
+	{
+		gl->a    = gsl_vector_alloc(N);
+		gl->b    = gsl_vector_alloc(N);
+		gl->chi2 = gsl_vector_alloc(N);
+		gsl_vector_set_all(gl->a, 1.0);
+	}
+	const gsl_vector* x0 = opts->x0;
+	if (!gl->x)
+		gl->x = gsl_vector_calloc(m + 1);
+	else if (!x0)
+		opts->x0 = gl->x;
+
+	size_t iterations = 0;
+	double b;
+	gsl_vector* Gg = gsl_vector_alloc(m);
+	gsl_vector_view xg = gsl_vector_subvector(gl->x, 0, m);
+
+	for (gl->passes = 1; gl->passes <= GLOBAL_PASSES; gl->passes++)
+	{
+		parameter* q = global_root(gl, alpha);
+		status = contin_solve(q, opts, s, g, &b);
+		parameter_free(q);
+		iterations += opts->iterations;
+
+		gsl_vector_memcpy(&xg.vector, g);
+		gsl_vector_set(gl->x, m, 0);
+		opts->x0 = gl->x;
+		if (status != OOL_SUCCESS && !contin_resolve(status))
+			break;
+
+		/* amplitudes for this g into gl->b, then normalized to mean 1 */
+		double change = 0, mean = 0;
+		for (k = 0; k < N; k++)
+		{
+			double gh, gGg;
+			gsl_blas_dsymv(CblasUpper, 1.0, gl->angle[k].G, g, 0.0, Gg);
+			gsl_blas_ddot(g, Gg, &gGg);
+			gsl_blas_ddot(g, gl->angle[k].h, &gh);
+			if (gh > 0 && gGg > 0)
+				gsl_vector_set(gl->b, k, gh / gGg);
+			else
+				gsl_vector_set(gl->b, k, gsl_vector_get(gl->a, k));
+			mean += gsl_vector_get(gl->b, k) / N;
+		}
+		for (k = 0; k < N; k++)
+		{
+			double ak = gsl_vector_get(gl->b, k) / mean;
+			change = GSL_MAX(change, fabs(ak - gsl_vector_get(gl->a, k)) / gsl_vector_get(gl->a, k));
+			gsl_vector_set(gl->a, k, ak);
+		}
+		gsl_vector_scale(&xg.vector, mean);
+		gsl_vector_memcpy(g, &xg.vector);
+
+		if (change < GLOBAL_TOL || contin_resolve(status))
+			break;
+	}
+	if (gl->passes > GLOBAL_PASSES)
+	{
+		gl->passes = GLOBAL_PASSES;
+		status = OOL_EMAXITER;
+	}
+	opts->x0 = x0;
+	opts->iterations = iterations;
+
+	/* baselines and residuals of the angles */
+	for (k = 0; k < N; k++)
+	{
+		const global_angle* ga = &gl->angle[k];
+		double ak = gsl_vector_get(gl->a, k);
+		double gh, gGg, kg;
+		gsl_blas_dsymv(CblasUpper, 1.0, ga->G, g, 0.0, Gg);
+		gsl_blas_ddot(g, Gg, &gGg);
+		gsl_blas_ddot(g, ga->h, &gh);
+		gsl_blas_ddot(g, ga->kb, &kg);
+		gsl_vector_set(gl->b, k, ga->yb - ak * kg);
+		gsl_vector_set(gl->chi2, k, ak * ak * gGg - 2 * ak * gh + ga->yy);
+	}
+
+	gsl_vector_free(Gg);
+
+	return status;
+}
@@ -0,0 +1,309 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: persistent CONTIN solver handles
+ 
+ A handle keeps one parameter struct alive between solves. The kernel 
+ K(t, tau) with its n*m exp() calls and the quadrature weights are built 
+ once when the handle is created, the weighted kernel, the Gram matrix, 
+ the hessian and the standard form SVD are rebuilt only when the variance 
+ of the data changes, so repeated inversions on the same lag grid only 
+ load the new data before solving. ktol > 0 keeps the kernel in skyline 
+ storage, htol > 0 as hierarchical low-rank blocks.
+ 
+ The counts of one angle can also be pooled on a handle with a dense 
+ kernel, contin_handle_add keeps only their sufficient statistics and 
+ contin_handle_pooled solves all counts added so far, see 
+ contin_accumulate.c.
+ 
+ A handle may be held by several callers on the same grids, each 
+ contin_handle_retain is matched by a contin_handle_release and the last 
+ release frees it. Pooled counts belong to one holder: a handle with 
+ counts is not shared again and counts are not added to a shared handle.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include "contin.h"
+
+contin_handle* contin_handle_alloc(gsl_vector* t, 
+								   const gsl_vector* tau, 
+								   int gridType, 
+								   int kernelType, 
+								   double ktol, 
+								   double htol)
+{
+	contin_handle* h = malloc(sizeof(contin_handle));
+	
+	h->p          = parameter_alloc_kernel(t, 0.0, tau, gridType, kernelType, ktol, htol);
+	h->gridType   = gridType;
+	h->kernelType = kernelType;
+	h->ktol       = ktol;
+	h->htol       = htol;
+	h->nsolve     = 0;
+	h->nsetup     = 0;
+	h->acc        = NULL;
+	h->refs       = 1;
+	
+	return h;
+}
+
+void contin_handle_free(contin_handle* h)
+{
+	if ( h->acc ) contin_accumulator_free( h->acc );
+	if ( h->p ) parameter_free( h->p );
+	free( h );
+}
+
+/*
+------------------------------------------------------------------------------
+
+ a handle is reused for the same lag grid, tau grid, kernel and tolerances
+
+------------------------------------------------------------------------------
+*/
+
+static int vector_equal(const gsl_vector* a, const gsl_vector* b)
+{
+	int i;
+	
+	if (a->size != b->size)
+		return 0;
+	for (i = 0; i < a->size; i++)
+		if (gsl_vector_get(a, i) != gsl_vector_get(b, i))
+			return 0;
+	return 1;
+}
+
+int contin_handle_matches(const contin_handle* h, 
+						  const gsl_vector* t, 
+						  const gsl_vector* tau, 
+						  int gridType, 
+						  int kernelType, 
+						  double ktol, 
+						  double htol)
+{
+	return h->gridType == gridType 
+		&& h->kernelType == kernelType 
+		&& h->ktol == ktol 
+		&& h->htol == htol 
+		&& vector_equal(h->p->t, t) 
+		&& vector_equal(h->p->tau, tau);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ a matching handle is handed to another holder only without pooled counts, 
+ which would otherwise leak into the pooled solves of the new holder
+
+------------------------------------------------------------------------------
+*/
+
+int contin_handle_shareable(const contin_handle* h, 
+							const gsl_vector* t, 
+							const gsl_vector* tau, 
+							int gridType, 
+							int kernelType, 
+							double ktol, 
+							double htol)
+{
+	return !h->acc && contin_handle_matches(h, t, tau, gridType, kernelType, ktol, htol);
+}
+
+void contin_handle_retain(contin_handle* h)
+{
+	h->refs++;
+}
+
+/* drops one holder, frees the handle and returns 1 when it was the last */
+int contin_handle_release(contin_handle* h)
+{
+	if (--h->refs > 0)
+		return 0;
+	contin_handle_free(h);
+	return 1;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the process-wide table behind contin('create', ...), ids start at 1, a 
+ create reuses a shareable handle and takes a reference on it, destroy 
+ drops one and clears the slot with the last
+
+------------------------------------------------------------------------------
+*/
+
+static contin_handle** handles = NULL;
+static int nhandles = 0;
+
+int contin_handle_create(gsl_vector* t, 
+						 const gsl_vector* tau, 
+						 int gridType, 
+						 int kernelType, 
+						 double ktol, 
+						 double htol)
+{
+	int k, free_slot = -1;
+	
+	for (k = 0; k < nhandles; k++)
+	{
+		if (!handles[k])
+		{
+			if (free_slot < 0)
+				free_slot = k;
+		}
+		else if (contin_handle_shareable(handles[k], t, tau, gridType, kernelType, ktol, htol))
+		{
+			contin_handle_retain(handles[k]);
+			return k + 1;
+		}
+	}
+	
+	if (free_slot < 0)
+	{
+		handles = realloc(handles, (nhandles + 1) * sizeof(contin_handle*));
+		free_slot = nhandles++;
+	}
+	handles[free_slot] = contin_handle_alloc(t, tau, gridType, kernelType, ktol, htol);
+	
+	return free_slot + 1;
+}
+
+/* the handle of id, NULL if it was never created or is destroyed */
+contin_handle* contin_handle_lookup(int id)
+{
+	if (id < 1 || id > nhandles)
+		return NULL;
+	return handles[id - 1];
+}
+
+void contin_handle_destroy(int id)
+{
+	contin_handle* h = contin_handle_lookup(id);
+	
+	if (h && contin_handle_release(h))
+		handles[id - 1] = NULL;
+}
+
+/* every handle regardless of its references */
+void contin_handle_destroy_all(void)
+{
+	int k;
+	
+	for (k = 0; k < nhandles; k++)
+		if (handles[k])
+			contin_handle_free(handles[k]);
+	free(handles);
+	handles  = NULL;
+	nhandles = 0;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ solve for data (y, var) with regularizer alpha, s and g have the grid size,
+ contin_handle_bootstrap adds the replicates of contin_bootstrap_solve
+
+------------------------------------------------------------------------------
+*/
+
+static int handle_set_data(contin_handle* h, 
+						   gsl_vector* y, 
+						   gsl_vector* var, 
+						   double alpha, 
+						   const gsl_vector* s, 
+						   const gsl_vector* g)
+{
+	parameter* p = h->p;
+	
+	if (y->size != p->t->size || var->size != p->t->size 
+		|| s->size != p->tau->size || g->size != p->tau->size)
+		return OOL_EBADLEN;
+	
+	/* the weighted kernel and its factorizations are kept for equal var */
+	if (parameter_set_data(p, y, var))
+		h->nsetup++;
+	
+	if (alpha != p->alpha || h->nsolve == 0)
+		parameter_set_alpha(p, alpha);
+	
+	h->nsolve++;
+	return OOL_SUCCESS;
+}
+
+int contin_handle_solve(contin_handle* h, 
+						gsl_vector* y, 
+						gsl_vector* var, 
+						double alpha, 
+						contin_options* opts, 
+						gsl_vector* s, 
+						gsl_vector* g, 
+						double* b)
+{
+	int status = handle_set_data(h, y, var, alpha, s, g);
+	if (status != OOL_SUCCESS)
+		return status;
+	
+	return contin_solve(h->p, opts, s, g, b);
+}
+
+int contin_handle_bootstrap(contin_handle* h, 
+							gsl_vector* y, 
+							gsl_vector* var, 
+							double alpha, 
+							contin_options* opts, 
+							gsl_vector* s, 
+							gsl_vector* g, 
+							double* b, 
+							contin_bootstrap* bs)
+{
+	int status = handle_set_data(h, y, var, alpha, s, g);
+	if (status != OOL_SUCCESS)
+		return status;
+	
+	return contin_bootstrap_solve(h->p, opts, s, g, b, bs);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ add a count to the pooled statistics, the kernel has to be dense and 
+ the handle must not be shared
+
+------------------------------------------------------------------------------
+*/
+
+int contin_handle_add(contin_handle* h, const gsl_vector* y, const gsl_vector* var)
+{
+	if (!h->p->K)
+		return OOL_EBADLEN;
+	if (h->refs > 1)
+		return OOL_EINVAL;
+	
+	if (!h->acc)
+		h->acc = contin_accumulator_alloc(h->p);
+	
+	return contin_accumulator_add(h->acc, y, var);
+}
+
+/* solve the counts added so far, the pooled weights replace those of p */
+int contin_handle_pooled(contin_handle* h, 
+						 double alpha, 
+						 contin_options* opts, 
+						 gsl_vector* s, 
+						 gsl_vector* g, 
+						 double* b)
+{
+	if (!h->acc)
+		return OOL_EBADLEN;
+	
+	size_t ngram = h->acc->ngram;
+	int status = contin_accumulator_solve(h->acc, alpha, opts, s, g, b);
+	
+	h->nsetup += h->acc->ngram - ngram;
+	h->nsolve++;
+	return status;
+}
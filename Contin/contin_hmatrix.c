@@ -0,0 +1,489 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: hierarchical low-rank storage of the kernel matrix
+
+ exp(-t/tau) and tau/(t^2 + tau^2) are smooth in t and tau, large blocks
+ of K are therefore numerically of low rank. The matrix is split
+ recursively into four blocks. A block is stored as U^T*V with rank k
+ when adaptive cross approximation (ACA) with partial pivoting reaches
+ the tolerance with k*(rows + columns) < rows*columns/2, otherwise it is
+ split again, down to small dense leaves. ACA only evaluates the
+ k rows and columns it pivots on, the dense K is never needed. Products
+ with the blocks cost O((n + m)*k*log(n + m)) instead of O(n*m).
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include "contin.h"
+
+/* blocks with both sides below this are stored dense */
+#define HMATRIX_LEAF 32
+
+/*
+------------------------------------------------------------------------------
+
+ row i of K for the columns j0 ... j0 + m - 1 and column j for the rows
+ i0 ... i0 + n - 1, evaluated with the vectorized kernel rows
+
+------------------------------------------------------------------------------
+*/
+
+static void kernel_row(const gsl_vector* t, const gsl_vector* tau, int kernelType,
+					   size_t i, size_t j0, size_t m, double* row)
+{
+	gsl_vector_const_view ti  = gsl_vector_const_subvector(t, i, 1);
+	gsl_vector_const_view tau0 = gsl_vector_const_subvector(tau, j0, m);
+	gsl_matrix_view R = gsl_matrix_view_array(row, 1, m);
+	kernel_build(&R.matrix, &ti.vector, &tau0.vector, kernelType);
+}
+
+static void kernel_column(const gsl_vector* t, const gsl_vector* tau, int kernelType,
+						  size_t i0, size_t n, size_t j, double* col)
+{
+	gsl_vector_const_view t0   = gsl_vector_const_subvector(t, i0, n);
+	gsl_vector_const_view tauj = gsl_vector_const_subvector(tau, j, 1);
+	gsl_matrix_view C = gsl_matrix_view_array(col, n, 1);
+	kernel_build(&C.matrix, &t0.vector, &tauj.vector, kernelType);
+}
+
+static double dot(const double* a, const double* b, size_t n)
+{
+	double d = 0;
+	size_t i;
+	for (i = 0; i < n; i++)
+		d += a[i] * b[i];
+	return d;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ adaptive cross approximation of the block rows i0 ... i0 + n - 1, columns
+ j0 ... j0 + m - 1, the cross u_k*v_k^T of every step is stored in row k
+ of U (kmax x n) and V (kmax x m). Stops when |u_k|*|v_k| <= tol*|S_k|,
+ S_k the approximation so far, and returns the rank or -1 if kmax steps
+ did not suffice.
+
+ Both kernels decay with t, ACA starts on the row with the smallest t,
+ if that row vanishes the whole block does.
+
+------------------------------------------------------------------------------
+*/
+
+static int aca(const gsl_vector* t, const gsl_vector* tau, int kernelType,
+			   size_t i0, size_t n, size_t j0, size_t m,
+			   double tol, size_t kmax, double* U, double* V)
+{
+	char* used = calloc(n, 1);
+	size_t k = 0, i = 0, r, l, jp;
+	double norm2 = 0;
+	int rank = -1;
+
+	while (k < kmax)
+	{
+		double* u = U + k * n;
+		double* v = V + k * m;
+
+		/* residual row i */
+		kernel_row(t, tau, kernelType, i0 + i, j0, m, v);
+		for (r = 0; r < k; r++)
+			for (l = 0; l < m; l++)
+				v[l] -= U[r * n + i] * V[r * m + l];
+		used[i] = 1;
+
+		jp = 0;
+		for (l = 1; l < m; l++)
+			if (fabs(v[l]) > fabs(v[jp]))
+				jp = l;
+
+		if (v[jp] == 0)
+		{
+			/* reproduced exactly, try the next unused row */
+			for (i = 0; i < n && used[i]; i++)
+				;
+			if (k == 0 || i == n)
+			{
+				rank = k;
+				break;
+			}
+			continue;
+		}
+
+		double pivot = v[jp];
+		for (l = 0; l < m; l++)
+			v[l] /= pivot;
+
+		/* residual column jp */
+		kernel_column(t, tau, kernelType, i0, n, j0 + jp, u);
+		for (r = 0; r < k; r++)
+			for (l = 0; l < n; l++)
+				u[l] -= V[r * m + jp] * U[r * n + l];
+
+		/* |S_k|^2 updated with the new cross */
+		double nu2 = dot(u, u, n);
+		double nv2 = dot(v, v, m);
+		double cross = 0;
+		for (r = 0; r < k; r++)
+			cross += dot(U + r * n, u, n) * dot(V + r * m, v, m);
+		norm2 += nu2 * nv2 + 2 * cross;
+		k++;
+
+		if (sqrt(nu2 * nv2) <= tol * sqrt(norm2))
+		{
+			rank = k;
+			break;
+		}
+
+		/* next pivot row, largest entry of u among the unused rows */
+		size_t ip = n;
+		for (l = 0; l < n; l++)
+			if (!used[l] && (ip == n || fabs(u[l]) > fabs(u[ip])))
+				ip = l;
+		if (ip == n)
+		{
+			rank = k;
+			break;
+		}
+		i = ip;
+	}
+
+	free(used);
+	return rank;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ recursive block partition
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	const gsl_vector* t;
+	const gsl_vector* tau;
+	int kernelType;
+	double tol;
+	hmatrix* H;
+	size_t capacity;
+	double* U;		/* ACA scratch */
+	double* V;
+
+} hbuilder;
+
+static hblock* hmatrix_push(hbuilder* b, size_t i0, size_t n, size_t j0, size_t m)
+{
+	hmatrix* H = b->H;
+	if (H->nblock == b->capacity)
+	{
+		b->capacity = 2 * b->capacity + 16;
+		H->block = realloc(H->block, b->capacity * sizeof(hblock));
+	}
+
+	hblock* B = H->block + H->nblock++;
+	B->i0 = i0;
+	B->j0 = j0;
+	B->size1 = n;
+	B->size2 = m;
+	B->D = NULL;
+	B->U = NULL;
+	B->V = NULL;
+	return B;
+}
+
+static void hmatrix_split(hbuilder* b, size_t i0, size_t n, size_t j0, size_t m)
+{
+	size_t kmax = n * m / (2 * (n + m));
+	size_t k, l;
+	int rank = -1;
+
+	if (n > HMATRIX_LEAF || m > HMATRIX_LEAF)
+		rank = aca(b->t, b->tau, b->kernelType, i0, n, j0, m, b->tol, kmax, b->U, b->V);
+
+	if (rank >= 0)
+	{
+		hblock* B = hmatrix_push(b, i0, n, j0, m);
+		if (rank > 0)
+		{
+			B->U = gsl_matrix_alloc(rank, n);
+			B->V = gsl_matrix_alloc(rank, m);
+			for (k = 0; k < rank; k++)
+			{
+				for (l = 0; l < n; l++)
+					gsl_matrix_set(B->U, k, l, b->U[k * n + l]);
+				for (l = 0; l < m; l++)
+					gsl_matrix_set(B->V, k, l, b->V[k * m + l]);
+			}
+		}
+	}
+	else if (n > HMATRIX_LEAF || m > HMATRIX_LEAF)
+	{
+		size_t n0 = n > HMATRIX_LEAF ? n / 2 : n;
+		size_t m0 = m > HMATRIX_LEAF ? m / 2 : m;
+
+		hmatrix_split(b, i0, n0, j0, m0);
+		if (m0 < m)
+			hmatrix_split(b, i0, n0, j0 + m0, m - m0);
+		if (n0 < n)
+		{
+			hmatrix_split(b, i0 + n0, n - n0, j0, m0);
+			if (m0 < m)
+				hmatrix_split(b, i0 + n0, n - n0, j0 + m0, m - m0);
+		}
+	}
+	else
+	{
+		hblock* B = hmatrix_push(b, i0, n, j0, m);
+		gsl_vector_const_view t0   = gsl_vector_const_subvector(b->t, i0, n);
+		gsl_vector_const_view tau0 = gsl_vector_const_subvector(b->tau, j0, m);
+		B->D = gsl_matrix_alloc(n, m);
+		kernel_build(B->D, &t0.vector, &tau0.vector, b->kernelType);
+	}
+}
+
+/*
+------------------------------------------------------------------------------
+
+ hierarchical approximation of the n x m kernel for the lag grid t and
+ the tau grid, tol is the relative accuracy of each low-rank block
+
+------------------------------------------------------------------------------
+*/
+
+hmatrix* hmatrix_alloc_kernel(const gsl_vector* t, const gsl_vector* tau, int kernelType, double tol)
+{
+	size_t n = t->size;
+	size_t m = tau->size;
+
+	hmatrix* H = malloc(sizeof(hmatrix));
+	H->size1  = n;
+	H->size2  = m;
+	H->nblock = 0;
+	H->block  = NULL;
+
+	/* the root block has the largest rank bound */
+	size_t kmax = n * m / (2 * (n + m)) + 1;
+
+	hbuilder b;
+	b.t = t;
+	b.tau = tau;
+	b.kernelType = kernelType;
+	b.tol = tol;
+	b.H = H;
+	b.capacity = 0;
+	b.U = malloc(kmax * n * sizeof(double));
+	b.V = malloc(kmax * m * sizeof(double));
+
+	hmatrix_split(&b, 0, n, 0, m);
+
+	free(b.U);
+	free(b.V);
+
+	H->z = gsl_vector_alloc(GSL_MAX(hmatrix_rank(H), 1));
+	return H;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ empty hierarchical matrix with the blocks and ranks of H
+
+------------------------------------------------------------------------------
+*/
+
+hmatrix* hmatrix_alloc_like(const hmatrix* H)
+{
+	hmatrix* A = malloc(sizeof(hmatrix));
+	size_t k;
+
+	A->size1  = H->size1;
+	A->size2  = H->size2;
+	A->nblock = H->nblock;
+	A->block  = malloc(GSL_MAX(H->nblock, 1) * sizeof(hblock));
+
+	for (k = 0; k < H->nblock; k++)
+	{
+		const hblock* B = H->block + k;
+		hblock* C = A->block + k;
+		*C = *B;
+		if (B->D)
+			C->D = gsl_matrix_alloc(B->D->size1, B->D->size2);
+		if (B->U)
+		{
+			C->U = gsl_matrix_alloc(B->U->size1, B->U->size2);
+			C->V = gsl_matrix_alloc(B->V->size1, B->V->size2);
+		}
+	}
+
+	A->z = gsl_vector_alloc(H->z->size);
+	return A;
+}
+
+void hmatrix_free(hmatrix* H)
+{
+	size_t k;
+	for (k = 0; k < H->nblock; k++)
+	{
+		if ( H->block[k].D ) gsl_matrix_free( H->block[k].D );
+		if ( H->block[k].U ) gsl_matrix_free( H->block[k].U );
+		if ( H->block[k].V ) gsl_matrix_free( H->block[k].V );
+	}
+	if ( H->block ) free( H->block );
+	if ( H->z ) gsl_vector_free( H->z );
+	free( H );
+}
+
+/*
+------------------------------------------------------------------------------
+
+ A = diag(rw)*K*diag(cw), scales the rows of the U factors and the
+ columns of the V factors
+
+------------------------------------------------------------------------------
+*/
+
+void hmatrix_weight(hmatrix* A, const hmatrix* K, const gsl_vector* rw, const gsl_vector* cw)
+{
+	size_t k, r, i, j;
+
+	for (k = 0; k < K->nblock; k++)
+	{
+		const hblock* B = K->block + k;
+		hblock* C = A->block + k;
+
+		if (B->D)
+		{
+			for (i = 0; i < B->size1; i++)
+				for (j = 0; j < B->size2; j++)
+					gsl_matrix_set(C->D, i, j, gsl_vector_get(rw, B->i0 + i)
+								   * gsl_vector_get(cw, B->j0 + j) * gsl_matrix_get(B->D, i, j));
+		}
+		else if (B->U)
+		{
+			for (r = 0; r < B->U->size1; r++)
+			{
+				for (i = 0; i < B->size1; i++)
+					gsl_matrix_set(C->U, r, i, gsl_vector_get(rw, B->i0 + i) * gsl_matrix_get(B->U, r, i));
+				for (j = 0; j < B->size2; j++)
+					gsl_matrix_set(C->V, r, j, gsl_vector_get(cw, B->j0 + j) * gsl_matrix_get(B->V, r, j));
+			}
+		}
+	}
+}
+
+/*
+------------------------------------------------------------------------------
+
+ stored fraction of the n*m entries and the largest block rank
+
+------------------------------------------------------------------------------
+*/
+
+double hmatrix_fill(const hmatrix* H)
+{
+	double stored = 0;
+	size_t k;
+	for (k = 0; k < H->nblock; k++)
+	{
+		const hblock* B = H->block + k;
+		if (B->D)
+			stored += (double) B->size1 * B->size2;
+		else if (B->U)
+			stored += (double) B->U->size1 * (B->size1 + B->size2);
+	}
+	return stored / ((double) H->size1 * H->size2);
+}
+
+size_t hmatrix_rank(const hmatrix* H)
+{
+	size_t k, rank = 0;
+	for (k = 0; k < H->nblock; k++)
+		if (H->block[k].U)
+			rank = GSL_MAX(rank, H->block[k].U->size1);
+	return rank;
+}
+
+/* dense column j */
+void hmatrix_column(const hmatrix* H, size_t j, gsl_vector* col)
+{
+	size_t k, r;
+
+	gsl_vector_set_zero(col);
+	for (k = 0; k < H->nblock; k++)
+	{
+		const hblock* B = H->block + k;
+		if (j < B->j0 || j >= B->j0 + B->size2)
+			continue;
+
+		gsl_vector_view c = gsl_vector_subvector(col, B->i0, B->size1);
+		if (B->D)
+		{
+			gsl_vector_const_view d = gsl_matrix_const_column(B->D, j - B->j0);
+			gsl_vector_memcpy(&c.vector, &d.vector);
+		}
+		else if (B->U)
+		{
+			for (r = 0; r < B->U->size1; r++)
+			{
+				gsl_vector_const_view u = gsl_matrix_const_row(B->U, r);
+				gsl_blas_daxpy(gsl_matrix_get(B->V, r, j - B->j0), &u.vector, &c.vector);
+			}
+		}
+	}
+}
+
+/*
+------------------------------------------------------------------------------
+
+ y = alpha*op(H)*x + beta*y, the hierarchical counterpart of gsl_blas_dgemv,
+ a low-rank block is applied as U^T*(V*x) or V^T*(U*x)
+
+------------------------------------------------------------------------------
+*/
+
+int hmatrix_dgemv(CBLAS_TRANSPOSE_t trans,
+				  double alpha,
+				  const hmatrix* H,
+				  const gsl_vector* x,
+				  double beta,
+				  gsl_vector* y)
+{
+	size_t k;
+
+	if (beta == 0)
+		gsl_vector_set_zero(y);
+	else
+		gsl_vector_scale(y, beta);
+
+	for (k = 0; k < H->nblock; k++)
+	{
+		const hblock* B = H->block + k;
+
+		/* rows of the block act on y for NoTrans, on x for Trans */
+		size_t ix = trans == CblasNoTrans ? B->j0 : B->i0;
+		size_t nx = trans == CblasNoTrans ? B->size2 : B->size1;
+		size_t iy = trans == CblasNoTrans ? B->i0 : B->j0;
+		size_t ny = trans == CblasNoTrans ? B->size1 : B->size2;
+
+		gsl_vector_const_view xb = gsl_vector_const_subvector(x, ix, nx);
+		gsl_vector_view yb = gsl_vector_subvector(y, iy, ny);
+
+		if (B->D)
+			gsl_blas_dgemv(trans, alpha, B->D, &xb.vector, 1.0, &yb.vector);
+		else if (B->U)
+		{
+			const gsl_matrix* in  = trans == CblasNoTrans ? B->V : B->U;
+			const gsl_matrix* out = trans == CblasNoTrans ? B->U : B->V;
+			gsl_vector_view z = gsl_vector_subvector(H->z, 0, B->U->size1);
+
+			gsl_blas_dgemv(CblasNoTrans, 1.0, in, &xb.vector, 0.0, &z.vector);
+			gsl_blas_dgemv(CblasTrans, alpha, out, &z.vector, 1.0, &yb.vector);
+		}
+	}
+
+	return GSL_SUCCESS;
+}
@@ -0,0 +1,352 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: construction of the kernel matrix K(t, tau)
+
+ kernelType 0: K(i,j) = exp(-t(i)/tau(j))
+ kernelType 1: K(i,j) = tau(j)/(pi*(t(i)^2 + tau(j)^2))
+
+ The rows are built with AVX-512 or AVX2 when the processor supports it,
+ chosen once at run time, the scalar loop is the fallback. The vector exp
+ reduces x = n*ln2 + r, |r| <= ln2/2, evaluates the Taylor polynomial of
+ degree 13 in r and scales by 2^n, which keeps it within 2 ulp of the
+ correctly rounded exp for results in the normal range, smaller results
+ are flushed to zero.
+
+ Lag grids of correlators are piecewise equidistant (the multi-tau
+ scheme doubles the spacing every few channels), where consecutive rows
+ of the exponential kernel obey
+
+ K(i+1,j) = K(i,j)*exp(-dt/tau(j)), dt = t(i+1) - t(i)
+
+ so inside such a run the rows are generated by one multiplication per
+ element. The factor row exp(-dt/tau) is computed once per run, and every
+ KERNEL_RESTART rows the recurrence is restarted from a fresh exp row to
+ bound the accumulated rounding error. contin_test.c holds the rows to 
+ 16*eps*(1 + t/tau) of the scalar loop, they stay within 3, a restart 
+ every 64 rows already breaks the bound.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include "contin.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define KERNEL_X86
+	#include <immintrin.h>
+#endif
+
+/* rows generated by the recurrence before a fresh exp row */
+#define KERNEL_RESTART 8
+
+#define EXP_LN2_HI 6.93147180369123816490e-01
+#define EXP_LN2_LO 1.90821492927058770002e-10
+#define EXP_LOG2E  1.44269504088896338700e+00
+#define EXP_XMIN   -708.39
+#define EXP_XMAX    709.0
+
+static const double exp_coeff[14] =
+{
+	1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+	1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800,
+	1.0 / 479001600, 1.0 / 6227020800.0
+};
+
+/*
+------------------------------------------------------------------------------
+
+ scalar rows, the reference loop
+
+------------------------------------------------------------------------------
+*/
+
+static void exp_row_scalar(double ti, const double* tau, double* k, int m)
+{
+	int j;
+	for (j = 0; j < m; j++)
+		k[j] = exp(-ti / tau[j]);
+}
+
+static void lorentz_row_scalar(double ti, const double* tau, double* k, int m)
+{
+	int j;
+	for (j = 0; j < m; j++)
+		k[j] = M_1_PI * tau[j] / (ti * ti + tau[j] * tau[j]);
+}
+
+static void mul_row_scalar(const double* k0, const double* q, double* k, int m)
+{
+	int j;
+	for (j = 0; j < m; j++)
+		k[j] = k0[j] * q[j];
+}
+
+#ifdef KERNEL_X86
+
+/*
+------------------------------------------------------------------------------
+
+ AVX2 rows
+
+------------------------------------------------------------------------------
+*/
+
+__attribute__((target("avx2,fma")))
+static __m256d exp_avx2(__m256d x)
+{
+	__m256d zero = _mm256_cmp_pd(x, _mm256_set1_pd(EXP_XMIN), _CMP_LT_OQ);
+	x = _mm256_max_pd(_mm256_min_pd(x, _mm256_set1_pd(EXP_XMAX)), _mm256_set1_pd(EXP_XMIN));
+
+	__m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(EXP_LOG2E)),
+								_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(EXP_LN2_HI), x);
+	r = _mm256_fnmadd_pd(n, _mm256_set1_pd(EXP_LN2_LO), r);
+
+	__m256d p = _mm256_set1_pd(exp_coeff[13]);
+	int i;
+	for (i = 12; i >= 0; i--)
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(exp_coeff[i]));
+
+	/* 2^n assembled in the exponent field */
+	__m256i e = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n));
+	e = _mm256_slli_epi64(_mm256_add_epi64(e, _mm256_set1_epi64x(1023)), 52);
+	p = _mm256_mul_pd(p, _mm256_castsi256_pd(e));
+
+	return _mm256_andnot_pd(zero, p);
+}
+
+__attribute__((target("avx2,fma")))
+static void exp_row_avx2(double ti, const double* tau, double* k, int m)
+{
+	__m256d mt = _mm256_set1_pd(-ti);
+	int j;
+	for (j = 0; j + 4 <= m; j += 4)
+		_mm256_storeu_pd(k + j, exp_avx2(_mm256_div_pd(mt, _mm256_loadu_pd(tau + j))));
+
+	if (j < m)
+	{
+		double xt[4] = {0, 0, 0, 0}, kt[4];
+		int l;
+		for (l = 0; j + l < m; l++)
+			xt[l] = -ti / tau[j + l];
+		_mm256_storeu_pd(kt, exp_avx2(_mm256_loadu_pd(xt)));
+		for (l = 0; j + l < m; l++)
+			k[j + l] = kt[l];
+	}
+}
+
+__attribute__((target("avx2,fma")))
+static void lorentz_row_avx2(double ti, const double* tau, double* k, int m)
+{
+	__m256d t2 = _mm256_set1_pd(ti * ti);
+	__m256d c  = _mm256_set1_pd(M_1_PI);
+	int j;
+	for (j = 0; j + 4 <= m; j += 4)
+	{
+		__m256d tj = _mm256_loadu_pd(tau + j);
+		__m256d d  = _mm256_add_pd(t2, _mm256_mul_pd(tj, tj));
+		_mm256_storeu_pd(k + j, _mm256_div_pd(_mm256_mul_pd(c, tj), d));
+	}
+	lorentz_row_scalar(ti, tau + j, k + j, m - j);
+}
+
+__attribute__((target("avx2,fma")))
+static void mul_row_avx2(const double* k0, const double* q, double* k, int m)
+{
+	int j;
+	for (j = 0; j + 4 <= m; j += 4)
+		_mm256_storeu_pd(k + j, _mm256_mul_pd(_mm256_loadu_pd(k0 + j), _mm256_loadu_pd(q + j)));
+	mul_row_scalar(k0 + j, q + j, k + j, m - j);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ AVX-512 rows, masked tails
+
+------------------------------------------------------------------------------
+*/
+
+__attribute__((target("avx512f")))
+static __m512d exp_avx512(__m512d x)
+{
+	__mmask8 zero = _mm512_cmp_pd_mask(x, _mm512_set1_pd(EXP_XMIN), _CMP_LT_OQ);
+	x = _mm512_max_pd(_mm512_min_pd(x, _mm512_set1_pd(EXP_XMAX)), _mm512_set1_pd(EXP_XMIN));
+
+	__m512d n = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(EXP_LOG2E)),
+									 _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(EXP_LN2_HI), x);
+	r = _mm512_fnmadd_pd(n, _mm512_set1_pd(EXP_LN2_LO), r);
+
+	__m512d p = _mm512_set1_pd(exp_coeff[13]);
+	int i;
+	for (i = 12; i >= 0; i--)
+		p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(exp_coeff[i]));
+
+	return _mm512_maskz_scalef_pd(~zero, p, n);
+}
+
+__attribute__((target("avx512f")))
+static void exp_row_avx512(double ti, const double* tau, double* k, int m)
+{
+	__m512d mt = _mm512_set1_pd(-ti);
+	int j;
+	for (j = 0; j < m; j += 8)
+	{
+		__mmask8 mask = m - j >= 8 ? 0xFF : (__mmask8) ((1u << (m - j)) - 1);
+		__m512d tj = _mm512_mask_loadu_pd(_mm512_set1_pd(1.0), mask, tau + j);
+		_mm512_mask_storeu_pd(k + j, mask, exp_avx512(_mm512_div_pd(mt, tj)));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void lorentz_row_avx512(double ti, const double* tau, double* k, int m)
+{
+	__m512d t2 = _mm512_set1_pd(ti * ti);
+	__m512d c  = _mm512_set1_pd(M_1_PI);
+	int j;
+	for (j = 0; j < m; j += 8)
+	{
+		__mmask8 mask = m - j >= 8 ? 0xFF : (__mmask8) ((1u << (m - j)) - 1);
+		__m512d tj = _mm512_mask_loadu_pd(_mm512_set1_pd(1.0), mask, tau + j);
+		__m512d d  = _mm512_add_pd(t2, _mm512_mul_pd(tj, tj));
+		_mm512_mask_storeu_pd(k + j, mask, _mm512_div_pd(_mm512_mul_pd(c, tj), d));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void mul_row_avx512(const double* k0, const double* q, double* k, int m)
+{
+	int j;
+	for (j = 0; j < m; j += 8)
+	{
+		__mmask8 mask = m - j >= 8 ? 0xFF : (__mmask8) ((1u << (m - j)) - 1);
+		_mm512_mask_storeu_pd(k + j, mask, _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, k0 + j),
+														  _mm512_maskz_loadu_pd(mask, q + j)));
+	}
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+
+ instruction set, detected on first use unless set explicitly
+
+------------------------------------------------------------------------------
+*/
+
+static int kernel_isa = -1;
+
+int kernel_isa_supported(int isa)
+{
+#ifdef KERNEL_X86
+	if (isa == KERNEL_AVX512)
+		return __builtin_cpu_supports("avx512f");
+	if (isa == KERNEL_AVX2)
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	return isa == KERNEL_SCALAR;
+}
+
+int kernel_get_isa(void)
+{
+	if (kernel_isa < 0)
+	{
+		if (kernel_isa_supported(KERNEL_AVX512))
+			kernel_isa = KERNEL_AVX512;
+		else if (kernel_isa_supported(KERNEL_AVX2))
+			kernel_isa = KERNEL_AVX2;
+		else
+			kernel_isa = KERNEL_SCALAR;
+	}
+	return kernel_isa;
+}
+
+int kernel_set_isa(int isa)
+{
+	int previous = kernel_get_isa();
+	if (kernel_isa_supported(isa))
+		kernel_isa = isa;
+	return previous;
+}
+
+typedef void (*row_function)(double, const double*, double*, int);
+typedef void (*mul_function)(const double*, const double*, double*, int);
+
+/*
+------------------------------------------------------------------------------
+
+ fill K (n x m) for the lag grid t and the tau grid
+
+------------------------------------------------------------------------------
+*/
+
+void kernel_build(gsl_matrix* K, const gsl_vector* t, const gsl_vector* tau, int kernelType)
+{
+	int n = K->size1;
+	int m = K->size2;
+	int i, j;
+
+	row_function exp_row     = exp_row_scalar;
+	row_function lorentz_row = lorentz_row_scalar;
+	mul_function mul_row     = mul_row_scalar;
+	int isa = kernel_get_isa();
+
+#ifdef KERNEL_X86
+	if (isa == KERNEL_AVX512)
+	{
+		exp_row     = exp_row_avx512;
+		lorentz_row = lorentz_row_avx512;
+		mul_row     = mul_row_avx512;
+	}
+	else if (isa == KERNEL_AVX2)
+	{
+		exp_row     = exp_row_avx2;
+		lorentz_row = lorentz_row_avx2;
+		mul_row     = mul_row_avx2;
+	}
+#endif
+
+	/* contiguous copies, gsl vectors may be strided */
+	double* tt = malloc(m * sizeof(double));
+	double* q  = malloc(m * sizeof(double));
+	for (j = 0; j < m; j++)
+		tt[j] = gsl_vector_get(tau, j);
+
+	/* the scalar path stays the plain reference loop */
+	int recurrence = kernelType == 0 && isa != KERNEL_SCALAR;
+	int fresh = 0;
+	double qdt = GSL_NAN;
+
+	for (i = 0; i < n; i++)
+	{
+		double* k  = gsl_matrix_ptr(K, i, 0);
+		double ti  = gsl_vector_get(t, i);
+		double dt  = i > 0 ? ti - gsl_vector_get(t, i - 1) : GSL_NAN;
+		double dt0 = i > 1 ? gsl_vector_get(t, i - 1) - gsl_vector_get(t, i - 2) : GSL_NAN;
+
+		if (kernelType == 1)
+			lorentz_row(ti, tt, k, m);
+		else if (recurrence && i - fresh < KERNEL_RESTART && (dt == qdt || dt == dt0))
+		{
+			/* inside an equidistant run, K(i) = K(i - 1)*exp(-dt/tau) */
+			if (dt != qdt)
+			{
+				exp_row(dt, tt, q, m);
+				qdt = dt;
+			}
+			mul_row(gsl_matrix_ptr(K, i - 1, 0), q, k, m);
+		}
+		else
+		{
+			exp_row(ti, tt, k, m);
+			fresh = i;
+		}
+	}
+
+	free(tt);
+	free(q);
+}
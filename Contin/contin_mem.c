@@ -0,0 +1,455 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: maximum entropy engine for the CONTIN kernel
+
+ The smoothness term a^2*|D2*g|^2 of contin.c is replaced by the negative
+ Shannon-Jaynes entropy of g relative to a default model mu,
+
+ f(g, b) = |A*g + b*sqrt(w) - sqrt(w)*y|^2
+           + a^2*sum_j c(j)*(g(j)*ln(g(j)/mu(j)) - g(j) + mu(j))
+
+ The entropy is strictly convex on g > 0 and its gradient a^2*c*ln(g/mu)
+ diverges at g = 0, so the minimum is positive without any constraint
+ and b is free. The default model is flat at the level of the best flat
+ fit unless the caller gives one, the minimum then is the distribution
+ with the fewest structures the data ask for.
+
+ The data term only enters through the Gram matrix G of contin.c,
+
+ |r|^2 = x^T*G*x - 2*x^T*h + |sqrt(w)*y|^2, h = [A, sqrt(w)]^T*sqrt(w)*y
+
+ so after one adjoint product for h every iteration costs O(m^3) for the
+ factorization of the (m + 1) x (m + 1) Newton system, independent of
+ the number of lags and of how the kernel is stored. The hessian
+
+ 2*G + diag(a^2*c/g, 0)
+
+ is positive definite. In floating point g is kept above the floor
+ MEM_FLOOR*mu, far below any structure the data can resolve. Each
+ iteration solves the Newton system shifted by lambda times its diagonal
+ (Levenberg-Marquardt) for the free components, those whose own Newton
+ step stays above the floor, the others move to the floor. The step is
+ clipped at the floor, and if that spoils it, halved along the projection
+ arc, and failing that shortened as a whole until it meets the floor.
+ Each is accepted if the objective, computed as the exact change from
+ the step, falls by a fair part of the quadratic prediction. Shortening
+ alone crawled along the floor, a thousandth of the step per iteration
+ on the ALV data. lambda plays the part of the trust region radius, it
+ shrinks tenfold on good steps and grows on poor ones, close to the
+ minimum the iteration is plain projected Newton and converges
+ quadratically. A clipped step whose model rises does not count as
+ converged, only one whose predicted change is below the tolerance.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_linalg.h>
+#include "contin.h"
+
+/*
+------------------------------------------------------------------------------
+
+ Cholesky factor of the symmetric a in place by GSL, returns 0 if a is 
+ not positive definite so that the caller can shift it. That failure is 
+ expected, the GSL error handler is off meanwhile; the solves of 
+ contin_batch factorize concurrently, the first to start turns it off and 
+ the last to finish restores it
+
+------------------------------------------------------------------------------
+*/
+
+static pthread_mutex_t handler_lock = PTHREAD_MUTEX_INITIALIZER;
+static int handler_users = 0;
+static gsl_error_handler_t* handler_saved = NULL;
+
+static int cholesky(gsl_matrix* a)
+{
+	pthread_mutex_lock(&handler_lock);
+	if (handler_users++ == 0)
+		handler_saved = gsl_set_error_handler_off();
+	pthread_mutex_unlock(&handler_lock);
+
+	int status = gsl_linalg_cholesky_decomp1(a);
+
+	pthread_mutex_lock(&handler_lock);
+	if (--handler_users == 0)
+		gsl_set_error_handler(handler_saved);
+	pthread_mutex_unlock(&handler_lock);
+
+	return status == GSL_SUCCESS;
+}
+
+/* solves L*L^T*x = x with the factor of cholesky */
+static void cholesky_solve(const gsl_matrix* L, gsl_vector* x)
+{
+	gsl_linalg_cholesky_svx(L, x);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ objective and its gradient at x = (g, b), g > 0, Gx receives G*x
+
+------------------------------------------------------------------------------
+*/
+
+typedef struct
+{
+	const parameter* p;
+	const gsl_vector* mu;	/* default model */
+	gsl_vector* h;			/* [A, sqrt(w)]^T*sqrt(w)*y */
+	double yy;				/* |sqrt(w)*y|^2 */
+	double a2;				/* weight of the entropy */
+	gsl_vector* Gx;			/* G*x of the last objective, m + 1 */
+	gsl_vector* Gd;			/* scratch, m + 1 */
+	gsl_vector* floor;		/* lower bound of g, MEM_FLOOR*mu */
+	gsl_vector* step;		/* scratch, m + 1 */
+	gsl_vector* Hs;			/* scratch, m + 1 */
+
+} mem_problem;
+
+static double mem_objective(const mem_problem* mp, const gsl_vector* x, gsl_vector* grad)
+{
+	const parameter* p = mp->p;
+	size_t m = p->tau->size;
+	size_t j;
+	double xGx, hx, entropy = 0;
+
+	gsl_blas_dsymv(CblasUpper, 1.0, p->G, x, 0.0, mp->Gx);
+	gsl_blas_ddot(x, mp->Gx, &xGx);
+	gsl_blas_ddot(x, mp->h, &hx);
+
+	for (j = 0; j < m; j++)
+	{
+		double gj  = gsl_vector_get(x, j);
+		double muj = gsl_vector_get(mp->mu, j);
+		double cj  = gsl_vector_get(p->c, j);
+		entropy += cj * (gj * log(gj / muj) - gj + muj);
+	}
+
+	if (grad)
+	{
+		gsl_vector_memcpy(grad, mp->Gx);
+		gsl_vector_sub(grad, mp->h);
+		gsl_vector_scale(grad, 2.0);
+		for (j = 0; j < m; j++)
+			*gsl_vector_ptr(grad, j) += mp->a2 * gsl_vector_get(p->c, j)
+				* log(gsl_vector_get(x, j) / gsl_vector_get(mp->mu, j));
+	}
+
+	return xGx - 2 * hx + mp->yy + mp->a2 * entropy;
+}
+
+/* 
+ f(x + dx) - f(x) from the step itself, mp->Gx has to hold G*x, the 
+ difference of the two objectives would lose it to the cancellation of 
+ |sqrt(w)*y|^2 close to the minimum 
+*/
+static double mem_change(const mem_problem* mp, const gsl_vector* x, const gsl_vector* dx)
+{
+	const parameter* p = mp->p;
+	size_t m = p->tau->size;
+	size_t j;
+	double dGd, rd, entropy = 0;
+
+	gsl_blas_dsymv(CblasUpper, 1.0, p->G, dx, 0.0, mp->Gd);
+	gsl_blas_ddot(dx, mp->Gd, &dGd);
+	gsl_vector_memcpy(mp->Gd, mp->Gx);
+	gsl_vector_sub(mp->Gd, mp->h);
+	gsl_blas_ddot(dx, mp->Gd, &rd);
+
+	for (j = 0; j < m; j++)
+	{
+		double gj  = gsl_vector_get(x, j);
+		double dj  = gsl_vector_get(dx, j);
+		double muj = gsl_vector_get(mp->mu, j);
+		double cj  = gsl_vector_get(p->c, j);
+		entropy += cj * ((gj + dj) * log((gj + dj) / muj) - gj * log(gj / muj) - dj);
+	}
+
+	return 2 * rd + dGd + mp->a2 * entropy;
+}
+
+/* 
+ x + theta*dx clipped at the floor into xt, returns f(xt) - f(x), 
+ predicted receives the decrease the quadratic model with hessian H 
+ expects for the step taken 
+*/
+static double mem_step(const mem_problem* mp, const gsl_matrix* H, const gsl_vector* grad, 
+					   const gsl_vector* x, const gsl_vector* dx, double theta, gsl_vector* xt, 
+					   double* predicted)
+{
+	size_t m = mp->floor->size;
+	size_t j;
+	double gs, sHs;
+
+	gsl_vector_memcpy(xt, x);
+	gsl_blas_daxpy(theta, dx, xt);
+	for (j = 0; j < m; j++)
+		gsl_vector_set(xt, j, GSL_MAX(gsl_vector_get(xt, j), gsl_vector_get(mp->floor, j)));
+
+	gsl_vector_memcpy(mp->step, xt);
+	gsl_vector_sub(mp->step, x);
+	gsl_blas_ddot(grad, mp->step, &gs);
+	gsl_blas_dsymv(CblasUpper, 1.0, H, mp->step, 0.0, mp->Hs);
+	gsl_blas_ddot(mp->step, mp->Hs, &sHs);
+	*predicted = -gs - 0.5 * sHs;
+
+	return mem_change(mp, x, mp->step);
+}
+
+/* the entropy is not quadratic, a decrease the model missed counts as well */
+static double mem_ratio(double df, double predicted)
+{
+	return predicted > 0 ? -df / predicted : (df < 0 ? 1 : -1);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ Maximum entropy engine
+ same interface as contin(), opts->x0 starts from a previous solution,
+ its g clipped to MEM_FLOOR of the model, opts->model replaces the flat
+ default model, iterations returns the factorized Newton systems
+
+------------------------------------------------------------------------------
+*/
+
+int contin_mem(parameter* p,
+			   const contin_options* opts,
+			   gsl_vector* s,
+			   gsl_vector* g,
+			   double* b,
+			   size_t* iterations)
+{
+	size_t m  = p->tau->size;
+	size_t nn = m + 1;
+	size_t j;
+	int status = OOL_EMAXITER;
+
+	const contin_minimizer* par = &opts->minimizer;
+	double tol = par->tol > 0 ? par->tol : MEM_TOL;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	mem_problem mp;
+	mp.p  = p;
+	mp.a2 = p->alpha * p->alpha;
+	mp.h  = gsl_vector_alloc(nn);
+	mp.Gx = gsl_vector_alloc(nn);
+	mp.Gd = gsl_vector_alloc(nn);
+	mp.step = gsl_vector_alloc(nn);
+	mp.Hs = gsl_vector_alloc(nn);
+
+	gsl_vector_view hg = gsl_vector_subvector(mp.h, 0, m);
+	double hb;
+	parameter_matvec(p, CblasTrans, 1.0, p->swy, 0.0, &hg.vector);
+	gsl_blas_ddot(p->sw, p->swy, &hb);
+	gsl_vector_set(mp.h, m, hb);
+	gsl_blas_ddot(p->swy, p->swy, &mp.yy);
+
+	/* the flat model of the best flat fit, 1^T*h_g / 1^T*G_gg*1 */
+	gsl_vector* mu = gsl_vector_alloc(m);
+	if (opts->model)
+		gsl_vector_memcpy(mu, opts->model);
+	else
+	{
+		double num = 0, den = 0;
+		size_t i;
+		for (j = 0; j < m; j++)
+		{
+			num += gsl_vector_get(mp.h, j);
+			for (i = 0; i < m; i++)
+				den += gsl_matrix_get(p->G, i, j);
+		}
+		gsl_vector_set_all(mu, num > 0 && den > 0 ? num / den : 1.0);
+	}
+	mp.mu = mu;
+
+	gsl_vector* x    = gsl_vector_alloc(nn);
+	gsl_vector* xt   = gsl_vector_alloc(nn);
+	gsl_vector* grad = gsl_vector_alloc(nn);
+	gsl_vector* dx   = gsl_vector_alloc(nn);
+	gsl_vector* Hdx  = gsl_vector_alloc(nn);
+	gsl_vector* floor = gsl_vector_alloc(m);
+	int* fixed = malloc(m * sizeof(int));
+	gsl_matrix* H    = gsl_matrix_alloc(nn, nn);
+	gsl_matrix* L    = gsl_matrix_alloc(nn, nn);
+
+	if (opts->x0)
+		gsl_vector_memcpy(x, opts->x0);
+	else
+	{
+		gsl_vector_view xg = gsl_vector_subvector(x, 0, m);
+		gsl_vector_memcpy(&xg.vector, mu);
+		gsl_vector_set(x, m, 0);
+	}
+	gsl_vector_memcpy(floor, mu);
+	gsl_vector_scale(floor, MEM_FLOOR);
+	mp.floor = floor;
+	for (j = 0; j < m; j++)
+		gsl_vector_set(x, j, GSL_MAX(gsl_vector_get(x, j), gsl_vector_get(floor, j)));
+
+	double f = mem_objective(&mp, x, grad);
+	double lambda = MEM_LAMBDA;
+	size_t k = 0;
+
+	while (k < par->nmax)
+	{
+		if (par->deadline > 0)
+		{
+			struct timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			if ((now.tv_sec - start.tv_sec) + 1e-9 * (now.tv_nsec - start.tv_nsec) > par->deadline)
+			{
+				status = CONTIN_DEADLINE;
+				break;
+			}
+		}
+
+		/* 
+		 hessian at x, the components that their own Newton step would 
+		 push below the floor are fixed, their rows and columns of the 
+		 Newton system are those of the identity
+		*/
+		gsl_matrix_memcpy(H, p->G);
+		gsl_matrix_scale(H, 2.0);
+		for (j = 0; j < m; j++)
+			*gsl_matrix_ptr(H, j, j) += mp.a2 * gsl_vector_get(p->c, j) / gsl_vector_get(x, j);
+
+		/* Hdx holds the moves of the fixed components towards the floor, shortened like the step */
+		gsl_vector_set_zero(Hdx);
+		for (j = 0; j < m; j++)
+		{
+			fixed[j] = gsl_vector_get(grad, j) > 0 && gsl_vector_get(x, j) - gsl_vector_get(grad, j) 
+				/ gsl_matrix_get(H, j, j) <= gsl_vector_get(floor, j);
+			if (fixed[j])
+				gsl_vector_set(Hdx, j, (gsl_vector_get(floor, j) - gsl_vector_get(x, j)) / (1 + lambda));
+		}
+
+		/* the free components see the fixed ones moved */
+		gsl_matrix_memcpy(L, H);
+		gsl_vector_memcpy(dx, grad);
+		gsl_vector_scale(dx, -1.0);
+		gsl_blas_dsymv(CblasUpper, -1.0, H, Hdx, 1.0, dx);
+		for (j = 0; j < m; j++)
+			if (fixed[j])
+			{
+				gsl_vector_view row = gsl_matrix_row(L, j);
+				gsl_vector_view col = gsl_matrix_column(L, j);
+				gsl_vector_set_zero(&row.vector);
+				gsl_vector_set_zero(&col.vector);
+				gsl_matrix_set(L, j, j, 1.0);
+				gsl_vector_set(dx, j, (1 + lambda) * gsl_vector_get(Hdx, j));
+			}
+		for (j = 0; j < nn; j++)
+			*gsl_matrix_ptr(L, j, j) *= 1 + lambda;
+		k++;
+		if (!cholesky(L))
+		{
+			lambda = GSL_MAX(10 * lambda, MEM_LAMBDA);
+			continue;
+		}
+		cholesky_solve(L, dx);
+
+		/* the Newton step clipped at the floor */
+		double predicted, theta = 1;
+		double df = mem_step(&mp, H, grad, x, dx, 1.0, xt, &predicted);
+		double rho = mem_ratio(df, predicted);
+
+		/* 
+		 if clipping has spoilt it, the step is halved along the projection 
+		 arc, still clipped, until it decreases f again; unless the change 
+		 is rounding, which no shorter step can resolve either
+		*/
+		if (rho <= 1e-4 && (fabs(df) > tol * fabs(f) || predicted > tol * fabs(f)))
+		{
+			double t;
+			for (t = 0.5; t >= MEM_ARC_MIN && rho <= 1e-4; t /= 2)
+			{
+				df  = mem_step(&mp, H, grad, x, dx, t, xt, &predicted);
+				rho = mem_ratio(df, predicted);
+				theta = t;
+			}
+		}
+
+		/* 
+		 otherwise the whole step shortened until it meets the floor, 
+		 which keeps it a descent, components within a factor 2 of the 
+		 floor are still clipped, they would stop it
+		*/
+		if (rho <= 1e-4)
+		{
+			theta = 1;
+			for (j = 0; j < m; j++)
+				if (gsl_vector_get(x, j) > 2 * gsl_vector_get(floor, j) 
+					&& gsl_vector_get(x, j) + gsl_vector_get(dx, j) < gsl_vector_get(floor, j))
+					theta = GSL_MIN(theta, (gsl_vector_get(x, j) - gsl_vector_get(floor, j)) / -gsl_vector_get(dx, j));
+			df  = mem_step(&mp, H, grad, x, dx, theta, xt, &predicted);
+			rho = mem_ratio(df, predicted);
+		}
+
+		/* 
+		 the model cannot resolve a smaller change, x is the minimum; a 
+		 clipped step the model expects to rise is no such change 
+		*/
+		if (fabs(predicted) <= tol * fabs(f) && lambda < MEM_NEWTON && theta == 1)
+		{
+			if (df < 0)
+				gsl_vector_memcpy(x, xt);
+			status = OOL_SUCCESS;
+			break;
+		}
+
+		if (rho > 1e-4)
+		{
+			gsl_vector_memcpy(x, xt);
+			f = mem_objective(&mp, x, grad);
+			if (rho > 0.75)
+				lambda = lambda / 10 < MEM_NEWTON / 10 ? 0 : lambda / 10;
+			else if (rho < 0.25)
+				lambda = GSL_MAX(2 * lambda, MEM_LAMBDA);
+		}
+		else
+			lambda = GSL_MAX(4 * lambda, MEM_LAMBDA);
+
+		/* rounding stops every step before the shift could */
+		if (lambda > MEM_LAMBDA_MAX)
+		{
+			status = OOL_ENOPROG;
+			break;
+		}
+	}
+
+	gsl_vector_memcpy(s, p->tau);
+	for (j = 0; j < m; j++)
+		gsl_vector_set(g, j, gsl_vector_get(x, j));
+	*b = gsl_vector_get(x, m);
+	if (iterations)
+		*iterations = k;
+
+	gsl_vector_free(mp.h);
+	gsl_vector_free(mp.Gx);
+	gsl_vector_free(mp.Gd);
+	gsl_vector_free(mp.step);
+	gsl_vector_free(mp.Hs);
+	gsl_vector_free(mu);
+	gsl_vector_free(x);
+	gsl_vector_free(xt);
+	gsl_vector_free(grad);
+	gsl_vector_free(dx);
+	gsl_vector_free(Hdx);
+	gsl_vector_free(floor);
+	free(fixed);
+	gsl_matrix_free(H);
+	gsl_matrix_free(L);
+
+	return status;
+}
@@ -0,0 +1,181 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: coarse-to-fine CONTIN on logarithmic grids
+
+ The levels follow contin2.m, level i has m + MULTIRES_STEP*i points
+ between s0 and s1. The first level starts from the flat distribution,
+ every further one from the solution of the level below, interpolated
+ linearly in ln(s). Since g is the distribution per unit of ln(s) on
+ every level, the interpolant is a good start and the minimizer only
+ has to resolve what the finer grid adds. Once a level changes the
+ interpolated start by less than tol relative to its norm, the finer
+ levels would not change it either, it is interpolated to the finest
+ grid and the remaining levels are skipped.
+
+ |D2*g|^2 on a grid of spacing h in ln(s) approximates h^3 times the
+ integral of g''^2, so level l is regularized with
+ alpha*(h/h_l)^(3/2), h the spacing of the finest grid, and every level
+ solves the same continuous problem as the finest one. Grids 20 points
+ apart still differ by a few percent from the interpolation alone, so
+ the early stop needs tol of that order to fire; with SPG the coarse
+ levels, being less regularized, take the bulk of the iterations, see
+ multires in contin_bench.c.
+
+------------------------------------------------------------------------------
+*/
+
+#include <math.h>
+#include "contin.h"
+
+/*
+------------------------------------------------------------------------------
+
+ linear interpolation in ln(s) of (sc, gc) onto the grid sf, both grids
+ span the same interval
+
+------------------------------------------------------------------------------
+*/
+
+static void prolongate(const gsl_vector* sc, const gsl_vector* gc,
+					   const gsl_vector* sf, gsl_vector* gf)
+{
+	size_t mc = sc->size;
+	size_t j, k = 0;
+
+	/* a single coarse point is constant */
+	if (mc < 2)
+	{
+		gsl_vector_set_all(gf, gsl_vector_get(gc, 0));
+		return;
+	}
+
+	for (j = 0; j < sf->size; j++)
+	{
+		double u = log(gsl_vector_get(sf, j));
+		while (k + 2 < mc && log(gsl_vector_get(sc, k + 1)) < u)
+			k++;
+
+		double u0 = log(gsl_vector_get(sc, k));
+		double u1 = log(gsl_vector_get(sc, k + 1));
+		double h  = GSL_MIN(GSL_MAX((u - u0) / (u1 - u0), 0.0), 1.0);
+
+		gsl_vector_set(gf, j, (1 - h) * gsl_vector_get(gc, k) + h * gsl_vector_get(gc, k + 1));
+	}
+}
+
+/*
+------------------------------------------------------------------------------
+
+ s and g have m + MULTIRES_STEP*(levels - 1) entries and m >= 2,
+ otherwise OOL_EINVAL is returned before any solve, opts->iterations
+ returns the iterations of all levels and used how many were solved,
+ the status is the one of the last level solved
+
+------------------------------------------------------------------------------
+*/
+
+int contin_multires(gsl_vector* t,
+					gsl_vector* y,
+					gsl_vector* var,
+					double alpha,
+					double s0,
+					double s1,
+					int m,
+					int levels,
+					int kernelType,
+					double tol,
+					contin_options* opts,
+					gsl_vector* s,
+					gsl_vector* g,
+					double* b,
+					int* used)
+{
+	const gsl_vector* x0 = opts->x0;
+	gsl_vector* sc = NULL;
+	gsl_vector* gc = NULL;
+	size_t total = 0;
+	int level, status = OOL_SUCCESS;
+
+	if (levels < 1)
+		levels = 1;
+	int mf = m + MULTIRES_STEP * (levels - 1);
+	if (m < 2 || s->size != (size_t) mf || g->size != (size_t) mf)
+	{
+		*used = 0;
+		return OOL_EINVAL;
+	}
+
+	for (level = 0; level < levels; level++)
+	{
+		int ml = m + MULTIRES_STEP * level;
+		double al = alpha * pow((double) (ml - 1) / (mf - 1), 1.5);
+		gsl_vector* tau = gsl_vector_alloc(ml);
+		tau_grid(s0, s1, GRID_LOG, tau);
+		parameter* p = parameter_alloc_kernel(t, al, tau, GRID_LOG, kernelType, opts->ktol, opts->htol);
+		parameter_set_data(p, y, var);
+		parameter_single(p, opts->single);
+		gsl_vector_free(tau);
+
+		gsl_vector* sl = gsl_vector_alloc(ml);
+		gsl_vector* gl = gsl_vector_alloc(ml);
+		gsl_vector* xl = NULL;
+
+		/* the start is the level below on the new grid */
+		if (gc)
+		{
+			xl = gsl_vector_alloc(ml + 1);
+			gsl_vector_view xg = gsl_vector_subvector(xl, 0, ml);
+			prolongate(sc, gc, p->tau, &xg.vector);
+			gsl_vector_set(xl, ml, *b);
+			opts->x0 = xl;
+		}
+
+		status = contin_solve(p, opts, sl, gl, b);
+		total += opts->iterations;
+
+		double change = GSL_POSINF;
+		if (xl)
+		{
+			double d = 0, n = 0;
+			int j;
+			for (j = 0; j < ml; j++)
+			{
+				double gj = gsl_vector_get(gl, j);
+				double dj = gj - gsl_vector_get(xl, j);
+				d += dj * dj;
+				n += gj * gj;
+			}
+			change = n > 0 ? sqrt(d / n) : 0;
+			gsl_vector_free(xl);
+		}
+
+		parameter_free(p);
+		if (gc)
+		{
+			gsl_vector_free(sc);
+			gsl_vector_free(gc);
+		}
+		sc = sl;
+		gc = gl;
+
+		if (change < tol)
+			break;
+	}
+
+	*used = GSL_MIN(level + 1, levels);
+	opts->x0 = x0;
+	opts->iterations = total;
+
+	/* the finest grid, a level that stopped early is interpolated onto it */
+	tau_grid(s0, s1, GRID_LOG, s);
+	if (sc->size == s->size)
+		gsl_vector_memcpy(g, gc);
+	else
+		prolongate(sc, gc, s, g);
+
+	gsl_vector_free(sc);
+	gsl_vector_free(gc);
+
+	return status;
+}
@@ -0,0 +1,419 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: direct solver engine for the CONTIN problem. 
+ 
+ The objective of contin.c is a non-negative Tikhonov least-squares problem
+ 
+ min |E*x - f|^2, x >= 0
+ 
+ E = [A, sqrt(w); alpha*D2, 0], f = [sqrt(w)*y; 0], x = (g, b)
+ 
+ which is solved exactly by the active set method of Lawson and Hanson 
+ (Solving Least Squares Problems, 1974, chapter 23). The QR factorization of 
+ the columns in the positive set is updated by one Householder 
+ transformation when a column enters and by Givens rotations when a column 
+ leaves, so the number of factorization updates is bounded instead of 
+ depending on the convergence of an iterative minimizer.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "contin.h"
+
+/*
+------------------------------------------------------------------------------
+
+ construct a Householder transformation that zeroes u(p+1..mm-1), 
+ u(p) is replaced by the new pivot and the pivot of the Householder 
+ vector is returned
+
+------------------------------------------------------------------------------
+*/
+
+static double householder(int p, int mm, double* u)
+{
+	int i;
+	double cl = fabs(u[p]);
+	
+	for (i = p + 1; i < mm; i++)
+		cl = GSL_MAX(cl, fabs(u[i]));
+	if (cl <= 0)
+		return 0;
+	
+	double sm = 0;
+	for (i = p; i < mm; i++)
+		sm += (u[i] / cl) * (u[i] / cl);
+	
+	cl *= sqrt(sm);
+	if (u[p] > 0)
+		cl = -cl;
+	
+	double up = u[p] - cl;
+	u[p] = cl;
+	return up;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ apply the Householder transformation (up, u(p+1..mm-1)) to c
+
+------------------------------------------------------------------------------
+*/
+
+static void householder_apply(int p, int mm, const double* u, double up, double* c)
+{
+	int i;
+	double b = up * u[p];
+	
+	if (b >= 0)
+		return;
+	
+	double sm = c[p] * up;
+	for (i = p + 1; i < mm; i++)
+		sm += c[i] * u[i];
+	
+	if (sm != 0)
+	{
+		sm /= b;
+		c[p] += sm * up;
+		for (i = p + 1; i < mm; i++)
+			c[i] += sm * u[i];
+	}
+}
+
+/*
+------------------------------------------------------------------------------
+
+ Givens rotation (cc, ss) with [cc ss; -ss cc]*[a; b] = [sig; 0]
+
+------------------------------------------------------------------------------
+*/
+
+static void givens(double a, double b, double* cc, double* ss, double* sig)
+{
+	double xr, yr;
+	
+	if (fabs(a) > fabs(b))
+	{
+		xr   = b / a;
+		yr   = sqrt(1 + xr * xr);
+		*cc  = (a < 0 ? -1 : 1) / yr;
+		*ss  = *cc * xr;
+		*sig = fabs(a) * yr;
+	}
+	else if (b != 0)
+	{
+		xr   = a / b;
+		yr   = sqrt(1 + xr * xr);
+		*ss  = (b < 0 ? -1 : 1) / yr;
+		*cc  = *ss * xr;
+		*sig = fabs(b) * yr;
+	}
+	else
+	{
+		*sig = 0;
+		*cc  = 0;
+		*ss  = 1;
+	}
+}
+
+static void rotate(double cc, double ss, double* x, double* y)
+{
+	double xr = cc * *x + ss * *y;
+	*y = -ss * *x + cc * *y;
+	*x = xr;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ back substitution R*z = (Q^T*f)(0..nsetp-1) over the positive set
+
+------------------------------------------------------------------------------
+*/
+
+static void triangular_solve(int mm, int nsetp, const double* a, const int* index, double* z)
+{
+	int l, ii, ip, jj = 0;
+	
+	for (l = 0; l < nsetp; l++)
+	{
+		ip = nsetp - 1 - l;
+		if (l != 0)
+			for (ii = 0; ii <= ip; ii++)
+				z[ii] -= a[jj * mm + ii] * z[ip + 1];
+		jj = index[ip];
+		z[ip] /= a[jj * mm + ip];
+	}
+}
+
+/*
+------------------------------------------------------------------------------
+
+ Lawson-Hanson NNLS on the column-major mm x nn matrix a and right hand 
+ side f, both are overwritten by Q^T*a and Q^T*f. w, z and index are 
+ scratch of length nn, nn and mm, nn respectively
+
+------------------------------------------------------------------------------
+*/
+
+static int nnls(int mm, int nn, double* a, double* f, double* x, 
+				double* w, double* z, int* index, size_t* nupdates)
+{
+	const double factor = 0.01;
+	int itmax = 3 * nn;
+	int iter = 0;
+	int i, ii, ip, iz, izmax, j, jj, jz, l;
+	int iz1 = 0, iz2 = nn - 1;
+	int nsetp = 0, npp1 = 0;
+	double up, unorm, ztest, asave, wmax, alpha, t, cc, ss, sig;
+	double* aj;
+	
+	for (i = 0; i < nn; i++)
+	{
+		x[i] = 0;
+		index[i] = i;
+	}
+	*nupdates = 0;
+	
+	/* 
+	 main loop, one column enters the positive set per pass
+	*/
+	while (iz1 <= iz2 && nsetp < mm)
+	{
+		/* dual vector E^T*(f - E*x) on the zero set */
+		for (iz = iz1; iz <= iz2; iz++)
+		{
+			j = index[iz];
+			w[j] = 0;
+			for (l = npp1; l < mm; l++)
+				w[j] += a[j * mm + l] * f[l];
+		}
+		
+		/* 
+		 pick the column with the largest dual, reject it if it is 
+		 numerically dependent on the positive set or would enter 
+		 with a non-positive coefficient 
+		*/
+		for (;;)
+		{
+			wmax  = 0;
+			izmax = -1;
+			for (iz = iz1; iz <= iz2; iz++)
+			{
+				j = index[iz];
+				if (w[j] > wmax)
+				{
+					wmax  = w[j];
+					izmax = iz;
+				}
+			}
+			
+			/* Kuhn-Tucker conditions are satisfied */
+			if (izmax < 0)
+				return OOL_SUCCESS;
+			
+			iz = izmax;
+			j  = index[iz];
+			aj = a + j * mm;
+			
+			asave = aj[npp1];
+			up = householder(npp1, mm, aj);
+			
+			unorm = 0;
+			for (l = 0; l < nsetp; l++)
+				unorm += aj[l] * aj[l];
+			unorm = sqrt(unorm);
+			
+			if (unorm + fabs(aj[npp1]) * factor - unorm > 0)
+			{
+				memcpy(z, f, mm * sizeof(double));
+				householder_apply(npp1, mm, aj, up, z);
+				ztest = z[npp1] / aj[npp1];
+				if (ztest > 0)
+					break;
+			}
+			
+			aj[npp1] = asave;
+			w[j] = 0;
+		}
+		
+		/* 
+		 column j enters the positive set, update the factorization 
+		*/
+		memcpy(f, z, mm * sizeof(double));
+		
+		index[iz]  = index[iz1];
+		index[iz1] = j;
+		iz1++;
+		nsetp = npp1 + 1;
+		npp1++;
+		
+		for (jz = iz1; jz <= iz2; jz++)
+			householder_apply(nsetp - 1, mm, aj, up, a + index[jz] * mm);
+		for (l = npp1; l < mm; l++)
+			aj[l] = 0;
+		w[j] = 0;
+		(*nupdates)++;
+		
+		memcpy(z, f, nsetp * sizeof(double));
+		triangular_solve(mm, nsetp, a, index, z);
+		
+		/* 
+		 secondary loop, step back towards the feasible region until 
+		 the least-squares solution on the positive set is positive
+		*/
+		for (;;)
+		{
+			if (++iter > itmax)
+				return OOL_EMAXITER;
+			
+			alpha = 2;
+			jj = -1;
+			for (ip = 0; ip < nsetp; ip++)
+			{
+				l = index[ip];
+				if (z[ip] <= 0)
+				{
+					t = -x[l] / (z[ip] - x[l]);
+					if (alpha > t)
+					{
+						alpha = t;
+						jj = ip;
+					}
+				}
+			}
+			
+			if (jj < 0)
+				break;
+			
+			for (ip = 0; ip < nsetp; ip++)
+			{
+				l = index[ip];
+				x[l] += alpha * (z[ip] - x[l]);
+			}
+			
+			/* 
+			 move every coefficient that dropped to zero back to the 
+			 zero set and restore the triangular form with rotations 
+			*/
+			i = index[jj];
+			for (;;)
+			{
+				x[i] = 0;
+				for (j = jj + 1; j < nsetp; j++)
+				{
+					ii = index[j];
+					index[j - 1] = ii;
+					givens(a[ii * mm + j - 1], a[ii * mm + j], &cc, &ss, &sig);
+					a[ii * mm + j - 1] = sig;
+					a[ii * mm + j]     = 0;
+					for (l = 0; l < nn; l++)
+						if (l != ii)
+							rotate(cc, ss, &a[l * mm + j - 1], &a[l * mm + j]);
+					rotate(cc, ss, &f[j - 1], &f[j]);
+				}
+				
+				npp1 = nsetp - 1;
+				nsetp--;
+				iz1--;
+				index[iz1] = i;
+				(*nupdates)++;
+				
+				for (jj = 0; jj < nsetp; jj++)
+					if (x[index[jj]] <= 0)
+						break;
+				if (jj == nsetp)
+					break;
+				i = index[jj];
+			}
+			
+			memcpy(z, f, nsetp * sizeof(double));
+			triangular_solve(mm, nsetp, a, index, z);
+		}
+		
+		for (ip = 0; ip < nsetp; ip++)
+			x[index[ip]] = z[ip];
+	}
+	
+	return OOL_SUCCESS;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ Contin Algorithm, direct NNLS engine 
+ same interface as contin(), nupdates returns the number of QR updates
+
+------------------------------------------------------------------------------
+*/
+
+int contin_nnls(parameter* p, 
+				gsl_vector* s, 
+				gsl_vector* g, 
+				double* b, 
+				size_t* nupdates)
+{
+	int n  = p->t->size;
+	int m  = p->tau->size;
+	int mm = n + m;
+	int nn = m + 1;
+	int i, j;
+	
+	double* a     = malloc(mm * nn * sizeof(double));
+	double* f     = calloc(mm, sizeof(double));
+	double* x     = malloc(nn * sizeof(double));
+	double* w     = malloc(nn * sizeof(double));
+	double* z     = malloc(mm * sizeof(double));
+	int*    index = malloc(nn * sizeof(int));
+	
+	/* 
+	 stack E = [A, sqrt(w); alpha*D2, 0] column by column, D2 is 
+	 symmetric so its columns are diff2 of the unit vectors
+	*/
+	gsl_vector* e   = gsl_vector_calloc(m);
+	gsl_vector* d2e = gsl_vector_alloc(m);
+	
+	for (j = 0; j < m; j++)
+	{
+		gsl_vector_view aj = gsl_vector_view_array(a + j * mm, n);
+		parameter_column(p, j, &aj.vector);
+		
+		gsl_vector_set(e, j, 1.0);
+		diff2(e, d2e);
+		gsl_vector_set(e, j, 0.0);
+		for (i = 0; i < m; i++)
+			a[j * mm + n + i] = p->alpha * gsl_vector_get(d2e, i);
+	}
+	for (i = 0; i < n; i++)
+	{
+		a[m * mm + i] = gsl_vector_get(p->sw, i);
+		f[i] = gsl_vector_get(p->swy, i);
+	}
+	for (i = n; i < mm; i++)
+		a[m * mm + i] = 0;
+	
+	int status = nnls(mm, nn, a, f, x, w, z, index, nupdates);
+	
+	gsl_vector_memcpy(s, p->tau);
+	for (j = 0; j < m; j++)
+		gsl_vector_set(g, j, x[j]);
+	*b = x[m];
+	
+	gsl_vector_free(e);
+	gsl_vector_free(d2e);
+	free(a);
+	free(f);
+	free(x);
+	free(w);
+	free(z);
+	free(index);
+	
+	return status;
+}
@@ -0,0 +1,192 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: CONTIN in the leading singular vectors of the kernel
+
+ The singular values of the weighted kernel [A, sqrt(w)] decay so fast
+ that only a few dozen directions of the data space carry information.
+ With the SVD [A, sqrt(w)] = U*S*V^T cut after the k singular values
+ above rtol*s(1), the residual splits into
+
+ |A*g + b*sqrt(w) - sqrt(w)*y|^2 = |U^T*(A*g + b*sqrt(w) - sqrt(w)*y)|^2 + e
+
+ where e only changes by the dropped directions, at most s(k+1)*|(g, b)|.
+ The first term is a CONTIN problem with k instead of n rows, kernel
+ U^T*A = S*V^T, background column U^T*sqrt(w) and data U^T*sqrt(w)*y, so
+ the unchanged minimizers run on it at O(k*m) per iteration. The SVD
+ depends on the weights only and is kept in p->rd, new data only costs
+ the projection U^T*sqrt(w)*y.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <gsl/gsl_linalg.h>
+#include "contin.h"
+
+void reduced_free(reduced* rd)
+{
+	if ( rd->U ) gsl_matrix_free( rd->U );
+	if ( rd->s ) gsl_vector_free( rd->s );
+	if ( rd->q ) parameter_free( rd->q );
+	free( rd );
+}
+
+/*
+------------------------------------------------------------------------------
+
+ parameter struct of the projected problem, R = U^T*[A, sqrt(w)] is
+ k x (m + 1), the rows play the role of the data points
+
+------------------------------------------------------------------------------
+*/
+
+parameter* parameter_alloc_projected(const parameter* p, const gsl_matrix* R)
+{
+	parameter* q = malloc(sizeof(parameter));
+	int k = R->size1;
+	int m = p->tau->size;
+	int i;
+
+	q -> K   = NULL;
+	q -> w   = gsl_vector_alloc( k );
+	q -> c   = gsl_vector_alloc( m );
+	q -> y   = gsl_vector_calloc( k );
+	q -> tau = gsl_vector_alloc( m );
+	q -> t   = gsl_vector_alloc( k );
+	q -> A   = gsl_matrix_alloc( k, m );
+	q -> sw  = gsl_vector_alloc( k );
+	q -> swy = gsl_vector_calloc( k );
+	q -> G   = gsl_matrix_alloc( m + 1, m + 1 );
+	q -> H   = gsl_matrix_alloc( m + 1, m + 1 );
+	q -> ws  = workspace_alloc( k, m );
+	q -> sf  = NULL;
+	q -> rd  = NULL;
+	q -> Ks  = NULL;
+	q -> As  = NULL;
+	q -> Kh  = NULL;
+	q -> Ah  = NULL;
+	q -> Af  = NULL;
+
+	q -> alpha = p->alpha;
+
+	/* the data points are the singular directions */
+	for (i = 0; i < k; i++)
+		gsl_vector_set(q->t, i, i);
+	gsl_vector_set_all(q->w, 1.0);
+	gsl_vector_memcpy(q->tau, p->tau);
+	gsl_vector_memcpy(q->c, p->c);
+
+	gsl_matrix_const_view RA = gsl_matrix_const_submatrix(R, 0, 0, k, m);
+	gsl_vector_const_view Rb = gsl_matrix_const_column(R, m);
+	gsl_matrix_memcpy(q->A, &RA.matrix);
+	gsl_vector_memcpy(q->sw, &Rb.vector);
+
+	parameter_gram(q);
+	parameter_hessian(q);
+
+	return q;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ SVD of [A, sqrt(w)] and the projected problem in its leading k left
+ singular vectors, k counts the singular values above tol*s(1)
+
+------------------------------------------------------------------------------
+*/
+
+static reduced* reduced_alloc(parameter* p, double tol)
+{
+	int n = p->t->size;
+	int m = p->tau->size;
+	int ns = GSL_MIN(n, m + 1);
+	int i, j, k;
+
+	reduced* rd = malloc(sizeof(reduced));
+
+	gsl_matrix* B = gsl_matrix_alloc(n, m + 1);
+	for (j = 0; j < m; j++)
+	{
+		gsl_vector_view col = gsl_matrix_column(B, j);
+		parameter_column(p, j, &col.vector);
+	}
+	gsl_vector_view bcol = gsl_matrix_column(B, m);
+	gsl_vector_memcpy(&bcol.vector, p->sw);
+
+	rd->s = gsl_vector_alloc(ns);
+	gsl_vector* work = gsl_vector_alloc(ns);
+	gsl_matrix* left;		/* n x ns left singular vectors */
+	gsl_matrix* right;		/* (m + 1) x ns right singular vectors */
+
+	if (n >= m + 1)
+	{
+		/* B = U*S*V^T, U overwrites B */
+		right = gsl_matrix_alloc(m + 1, m + 1);
+		gsl_linalg_SV_decomp(B, right, rd->s, work);
+		left = B;
+	}
+	else
+	{
+		/* B^T = U*S*V^T, the left singular vectors of B are V */
+		right = gsl_matrix_alloc(m + 1, n);
+		left  = gsl_matrix_alloc(n, n);
+		gsl_matrix_transpose_memcpy(right, B);
+		gsl_linalg_SV_decomp(right, left, rd->s, work);
+		gsl_matrix_free(B);
+	}
+
+	double s1 = gsl_vector_get(rd->s, 0);
+	for (k = 1; k < ns && gsl_vector_get(rd->s, k) > tol * s1; k++)
+		;
+
+	rd->tol = tol;
+	rd->U   = gsl_matrix_alloc(n, k);
+	gsl_matrix_const_view Uk = gsl_matrix_const_submatrix(left, 0, 0, n, k);
+	gsl_matrix_memcpy(rd->U, &Uk.matrix);
+
+	/* U^T*[A, sqrt(w)] = S*V^T in the first k rows */
+	gsl_matrix* R = gsl_matrix_alloc(k, m + 1);
+	for (i = 0; i < k; i++)
+		for (j = 0; j < m + 1; j++)
+			gsl_matrix_set(R, i, j, gsl_vector_get(rd->s, i) * gsl_matrix_get(right, j, i));
+
+	rd->q = parameter_alloc_projected(p, R);
+
+	gsl_matrix_free(R);
+	gsl_matrix_free(left);
+	gsl_matrix_free(right);
+	gsl_vector_free(work);
+
+	return rd;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the reduced problem for the data and alpha currently loaded in p, the
+ basis is built on first use and whenever tol changes
+
+------------------------------------------------------------------------------
+*/
+
+parameter* parameter_reduce(parameter* p, double tol)
+{
+	if (p->rd && p->rd->tol != tol)
+	{
+		reduced_free(p->rd);
+		p->rd = NULL;
+	}
+	if (!p->rd)
+		p->rd = reduced_alloc(p, tol);
+
+	parameter* q = p->rd->q;
+	gsl_blas_dgemv(CblasTrans, 1.0, p->rd->U, p->swy, 0.0, q->swy);
+	gsl_vector_memcpy(q->y, q->swy);
+
+	if (q->alpha != p->alpha)
+		parameter_set_alpha(q, p->alpha);
+
+	return q;
+}
@@ -0,0 +1,287 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: skyline storage of the kernel matrix
+
+ For the multi-exponential kernel exp(-t/tau) is numerically zero once
+ t >> tau, so on lag grids spanning many decades most of K is below any
+ sensible tolerance. Each column j only keeps the contiguous range of rows
+ first(j) <= i < last(j) outside of which |K(i,j)| <= tol*max|K(:,j)|,
+ stored one column after the other. The matrix-vector products run over
+ the stored entries only, their cost and the memory scale with the fill
+ of the band instead of n*m.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include "contin.h"
+
+/* columns built at a time by skyline_alloc_kernel */
+#define SKYLINE_BLOCK 32
+
+static skyline* skyline_alloc_empty(size_t n, size_t m)
+{
+	skyline* S = malloc(sizeof(skyline));
+
+	S->size1  = n;
+	S->size2  = m;
+	S->first  = malloc(m * sizeof(size_t));
+	S->last   = malloc(m * sizeof(size_t));
+	S->offset = malloc((m + 1) * sizeof(size_t));
+	S->data   = NULL;
+	S->offset[0] = 0;
+
+	return S;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ append the columns of K as columns j0, j0 + 1, ... of S, entries below 
+ tol relative to the largest entry of their column are dropped from the 
+ ends of the column
+
+------------------------------------------------------------------------------
+*/
+
+static void skyline_append(skyline* S, const gsl_matrix* K, size_t j0, double tol)
+{
+	size_t n = K->size1;
+	size_t m = K->size2;
+	size_t i, j;
+
+	for (j = 0; j < m; j++)
+	{
+		double kmax = 0;
+		for (i = 0; i < n; i++)
+			kmax = GSL_MAX(kmax, fabs(gsl_matrix_get(K, i, j)));
+
+		size_t first = n, last = 0;
+		for (i = 0; i < n; i++)
+			if (fabs(gsl_matrix_get(K, i, j)) > tol * kmax)
+			{
+				first = GSL_MIN(first, i);
+				last  = i + 1;
+			}
+		if (first > last)
+			first = last = 0;
+
+		S->first[j0 + j] = first;
+		S->last[j0 + j]  = last;
+		S->offset[j0 + j + 1] = S->offset[j0 + j] + last - first;
+	}
+
+	S->data = realloc(S->data, GSL_MAX(S->offset[j0 + m], 1) * sizeof(double));
+	for (j = 0; j < m; j++)
+		for (i = S->first[j0 + j]; i < S->last[j0 + j]; i++)
+			S->data[S->offset[j0 + j] + i - S->first[j0 + j]] = gsl_matrix_get(K, i, j);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ skyline of the dense matrix K
+
+------------------------------------------------------------------------------
+*/
+
+skyline* skyline_alloc_from(const gsl_matrix* K, double tol)
+{
+	skyline* S = skyline_alloc_empty(K->size1, K->size2);
+	skyline_append(S, K, 0, tol);
+	return S;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ skyline of the kernel for the lag grid t and the tau grid, built from 
+ SKYLINE_BLOCK columns at a time so that the dense n x m kernel never 
+ exists. The entries are those of kernel_build, the recurrence runs 
+ along the rows and does not depend on the other columns
+
+------------------------------------------------------------------------------
+*/
+
+skyline* skyline_alloc_kernel(const gsl_vector* t, const gsl_vector* tau, int kernelType, double tol)
+{
+	size_t n = t->size;
+	size_t m = tau->size;
+	size_t j0;
+
+	skyline* S = skyline_alloc_empty(n, m);
+	gsl_matrix* K = gsl_matrix_alloc(n, GSL_MIN(m, SKYLINE_BLOCK));
+
+	for (j0 = 0; j0 < m; j0 += SKYLINE_BLOCK)
+	{
+		size_t mb = GSL_MIN(m - j0, SKYLINE_BLOCK);
+		gsl_matrix_view Kb = gsl_matrix_submatrix(K, 0, 0, n, mb);
+		gsl_vector_const_view taub = gsl_vector_const_subvector(tau, j0, mb);
+		kernel_build(&Kb.matrix, t, &taub.vector, kernelType);
+		skyline_append(S, &Kb.matrix, j0, tol);
+	}
+
+	gsl_matrix_free(K);
+	return S;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ empty skyline with the structure of S
+
+------------------------------------------------------------------------------
+*/
+
+skyline* skyline_alloc_like(const skyline* S)
+{
+	skyline* T = malloc(sizeof(skyline));
+	size_t m = S->size2;
+	size_t j;
+
+	T->size1  = S->size1;
+	T->size2  = m;
+	T->first  = malloc(m * sizeof(size_t));
+	T->last   = malloc(m * sizeof(size_t));
+	T->offset = malloc((m + 1) * sizeof(size_t));
+	T->data   = malloc(GSL_MAX(S->offset[m], 1) * sizeof(double));
+
+	for (j = 0; j < m; j++)
+	{
+		T->first[j]  = S->first[j];
+		T->last[j]   = S->last[j];
+		T->offset[j] = S->offset[j];
+	}
+	T->offset[m] = S->offset[m];
+
+	return T;
+}
+
+void skyline_free(skyline* S)
+{
+	if ( S->first  ) free( S->first  );
+	if ( S->last   ) free( S->last   );
+	if ( S->offset ) free( S->offset );
+	if ( S->data   ) free( S->data   );
+	free( S );
+}
+
+/*
+------------------------------------------------------------------------------
+
+ fraction of the n*m entries that are stored
+
+------------------------------------------------------------------------------
+*/
+
+double skyline_fill(const skyline* S)
+{
+	return (double) S->offset[S->size2] / ((double) S->size1 * S->size2);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ stored part of column j as a vector view, rows first(j) ... last(j) - 1
+
+------------------------------------------------------------------------------
+*/
+
+static gsl_vector_const_view skyline_const_column(const skyline* S, size_t j)
+{
+	return gsl_vector_const_view_array(S->data + S->offset[j], S->last[j] - S->first[j]);
+}
+
+/* dense column j */
+void skyline_column(const skyline* S, size_t j, gsl_vector* col)
+{
+	size_t i;
+	gsl_vector_set_zero(col);
+	for (i = S->first[j]; i < S->last[j]; i++)
+		gsl_vector_set(col, i, S->data[S->offset[j] + i - S->first[j]]);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ y = alpha*op(S)*x + beta*y, the skyline counterpart of gsl_blas_dgemv,
+ the input y is ignored for beta = 0
+
+------------------------------------------------------------------------------
+*/
+
+int skyline_dgemv(CBLAS_TRANSPOSE_t trans,
+				  double alpha,
+				  const skyline* S,
+				  const gsl_vector* x,
+				  double beta,
+				  gsl_vector* y)
+{
+	size_t j;
+	double d;
+
+	if (trans == CblasNoTrans)
+	{
+		/* like BLAS, y is not read for beta = 0, it may hold NaN */
+		if (beta == 0)
+			gsl_vector_set_zero(y);
+		else
+			gsl_vector_scale(y, beta);
+		for (j = 0; j < S->size2; j++)
+		{
+			if (S->last[j] == S->first[j])
+				continue;
+			gsl_vector_const_view col = skyline_const_column(S, j);
+			gsl_vector_view yj = gsl_vector_subvector(y, S->first[j], S->last[j] - S->first[j]);
+			gsl_blas_daxpy(alpha * gsl_vector_get(x, j), &col.vector, &yj.vector);
+		}
+	}
+	else
+	{
+		for (j = 0; j < S->size2; j++)
+		{
+			d = 0;
+			if (S->last[j] > S->first[j])
+			{
+				gsl_vector_const_view col = skyline_const_column(S, j);
+				gsl_vector_const_view xj = gsl_vector_const_subvector(x, S->first[j], S->last[j] - S->first[j]);
+				gsl_blas_ddot(&col.vector, &xj.vector, &d);
+			}
+			gsl_vector_set(y, j, (beta == 0 ? 0 : beta * gsl_vector_get(y, j)) + alpha * d);
+		}
+	}
+
+	return GSL_SUCCESS;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ upper triangle of C = S^T*S, columns only meet where their ranges overlap
+
+------------------------------------------------------------------------------
+*/
+
+void skyline_dsyrk(const skyline* S, gsl_matrix* C)
+{
+	size_t j, k;
+	double d;
+
+	for (j = 0; j < S->size2; j++)
+		for (k = j; k < S->size2; k++)
+		{
+			size_t i0 = GSL_MAX(S->first[j], S->first[k]);
+			size_t i1 = GSL_MIN(S->last[j],  S->last[k]);
+
+			d = 0;
+			if (i1 > i0)
+			{
+				gsl_vector_const_view cj = gsl_vector_const_view_array(S->data + S->offset[j] + i0 - S->first[j], i1 - i0);
+				gsl_vector_const_view ck = gsl_vector_const_view_array(S->data + S->offset[k] + i0 - S->first[k], i1 - i0);
+				gsl_blas_ddot(&cj.vector, &ck.vector, &d);
+			}
+			gsl_matrix_set(C, j, k, d);
+		}
+}
@@ -0,0 +1,1251 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: checks of the CONTIN engines, exits with the number of
+ failed checks
+
+ Every check prints one line with the measured value against its bound.
+ The data come from contin_fixture.c. Not part of the MEX, build it with
+ the library sources, leaving out the demo main of contin.c:
+
+   g++ -O2 -c contin_fixed.cpp
+   gcc -std=gnu99 -O2 -DCONTIN_NO_MAIN -o contin_test contin_test.c \
+       contin_fixture.c contin.c contin_nnls.c contin_alpha.c contin_batch.c \
+       contin_handle.c contin_kernel.c contin_skyline.c contin_hmatrix.c \
+       contin_reduced.c contin_multires.c contin_threads.c contin_bootstrap.c \
+       contin_accumulate.c contin_mem.c contin_global.c contin_fixed.o \
+       -lool -lgsl -lgslcblas -lm -lpthread -lstdc++
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_sort.h>
+#include <gsl/gsl_statistics.h>
+#include "contin_fixture.h"
+
+/*
+------------------------------------------------------------------------------
+
+ heap allocations are counted by interposing malloc on glibc, the library
+ and GSL resolve it to these definitions
+
+------------------------------------------------------------------------------
+*/
+
+#ifdef __GLIBC__
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+static int counting = 0;
+static size_t nmalloc = 0;
+
+void* malloc(size_t size)
+{
+	nmalloc += counting;
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size)
+{
+	nmalloc += counting;
+	return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+	nmalloc += counting;
+	return __libc_realloc(ptr, size);
+}
+#endif
+
+static int nfail = 0;
+static int ncheck = 0;
+
+static void check(const char* name, int ok)
+{
+	ncheck++;
+	nfail += !ok;
+	printf("%-4s %s\n", ok ? "ok" : "FAIL", name);
+}
+
+static void check_below(const char* name, double value, double bound)
+{
+	ncheck++;
+	nfail += !(value <= bound);
+	printf("%-4s %s: %.3g <= %.3g\n", value <= bound ? "ok" : "FAIL", name, value, bound);
+}
+
+/* the bimodal correlogram most checks run on, modes at 0.2 and 4 */
+static fixture* bimodal(int n)
+{
+	fixture* fx = fixture_alloc(n, 1e-3, 50, 1e-4);
+	fixture_exponentials(fx, 0.5, 0.2, 0.5, 4, 1e-3, 0);
+	return fx;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the gradient against central differences of the objective and the
+ hessian-vector product against the difference of gradients
+
+------------------------------------------------------------------------------
+*/
+
+static void test_derivatives(void)
+{
+	int m = 10;
+	size_t i;
+	fixture* fx = bimodal(200);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 0.01, 0.1, 4.0, m, 0, GRID_LINEAR);
+
+	gsl_vector* X  = gsl_vector_alloc(m + 1);
+	gsl_vector* G  = gsl_vector_alloc(m + 1);
+	gsl_vector* Gh = gsl_vector_alloc(m + 1);
+	gsl_vector* V  = gsl_vector_alloc(m + 1);
+	gsl_vector* HV = gsl_vector_alloc(m + 1);
+	double h = 1e-4, eg = 0, eh = 0;
+
+	gsl_vector_set_all(X, 1.0);
+	fun_df(X, p, G);
+	for (i = 0; i < m + 1; i++)
+	{
+		double xi = gsl_vector_get(X, i);
+		gsl_vector_set(X, i, xi + h);
+		double fp = fun(X, p);
+		gsl_vector_set(X, i, xi - h);
+		double fm = fun(X, p);
+		gsl_vector_set(X, i, xi);
+		eg = GSL_MAX(eg, fabs((fp - fm) / (2 * h) - gsl_vector_get(G, i)) / gsl_blas_dnrm2(G));
+	}
+	check_below("gradient against central differences", eg, 1e-6);
+
+	/* the objective is quadratic, the difference of gradients is exact up to rounding */
+	for (i = 0; i < m + 1; i++)
+		gsl_vector_set(V, i, 1.0 / (i + 1));
+	fun_Hv(X, p, V, HV);
+	gsl_blas_daxpy(h, V, X);
+	fun_df(X, p, Gh);
+	for (i = 0; i < m + 1; i++)
+		eh = GSL_MAX(eh, fabs((gsl_vector_get(Gh, i) - gsl_vector_get(G, i)) / h - gsl_vector_get(HV, i))
+					 / gsl_blas_dnrm2(HV));
+	check_below("hessian-vector product against gradients", eh, 1e-6);
+
+	gsl_vector_free(X);
+	gsl_vector_free(G);
+	gsl_vector_free(Gh);
+	gsl_vector_free(V);
+	gsl_vector_free(HV);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the vectorized kernel rows against the scalar reference loop, on the
+ multi-tau grid the exponential rows run the recurrence over
+ KERNEL_RESTART rows between fresh exp rows
+
+------------------------------------------------------------------------------
+*/
+
+static void test_kernel(void)
+{
+	const char* isa_name[] = {"scalar", "avx2", "avx512"};
+	int n = 1000, m = 200;
+	int isa0 = kernel_get_isa();
+	int isa, multitau, kernelType;
+	size_t i, j;
+	char name[96];
+
+	gsl_vector* t   = gsl_vector_alloc(n);
+	gsl_vector* tau = gsl_vector_alloc(m);
+	gsl_matrix* K   = gsl_matrix_alloc(n, m);
+	gsl_matrix* Kref = gsl_matrix_alloc(n, m);
+	tau_grid(1e-3, 1e2, GRID_LOG, tau);
+
+	for (multitau = 0; multitau < 2; multitau++)
+	{
+		fixture_lags(t, multitau);
+		for (kernelType = 0; kernelType < 2; kernelType++)
+		{
+			kernel_set_isa(KERNEL_SCALAR);
+			kernel_build(Kref, t, tau, kernelType);
+
+			for (isa = KERNEL_AVX2; isa <= KERNEL_AVX512; isa++)
+			{
+				if (!kernel_isa_supported(isa))
+					continue;
+				kernel_set_isa(isa);
+				kernel_build(K, t, tau, kernelType);
+
+				/* relative error in units of the rounding of the argument t/tau */
+				double e = 0;
+				for (i = 0; i < n; i++)
+					for (j = 0; j < m; j++)
+					{
+						double r = gsl_matrix_get(Kref, i, j);
+						double x = gsl_vector_get(t, i) / gsl_vector_get(tau, j);
+						if (r >= GSL_DBL_MIN)
+							e = GSL_MAX(e, fabs(gsl_matrix_get(K, i, j) / r - 1) / (1 + x));
+					}
+				sprintf(name, "%s kernel %d on the %s grid against the scalar loop",
+						isa_name[isa], kernelType, multitau ? "multi-tau" : "equidistant");
+				check_below(name, e / GSL_DBL_EPSILON, 16);
+			}
+		}
+	}
+
+	kernel_set_isa(isa0);
+	gsl_vector_free(t);
+	gsl_vector_free(tau);
+	gsl_matrix_free(K);
+	gsl_matrix_free(Kref);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the engines against the exact minimum of NNLS, and a warm start from a
+ neighbouring alpha against a cold one
+
+------------------------------------------------------------------------------
+*/
+
+static void test_engines(void)
+{
+	int m = 40;
+	fixture* fx = bimodal(200);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, 0, GRID_LOG);
+	gsl_vector* s  = gsl_vector_alloc(m);
+	gsl_vector* gn = gsl_vector_alloc(m);
+	gsl_vector* g  = gsl_vector_alloc(m);
+	gsl_vector* x  = gsl_vector_alloc(m + 1);
+	double bn, b;
+	contin_options opts;
+
+	contin_options_default(&opts);
+	opts.solver = SOLVER_NNLS;
+	contin_solve(p, &opts, s, gn, &bn);
+	double fn = fixture_objective(p, gn, bn);
+
+	contin_options_default(&opts);
+	opts.minimizer.nmax = 20000;
+	check("spg converges", contin_solve(p, &opts, s, g, &b) == OOL_SUCCESS);
+	check_below("spg objective above nnls", fixture_objective(p, g, b) / fn - 1, 1e-4);
+
+	contin_options_default(&opts);
+	opts.solver = SOLVER_PGRAD;
+	opts.minimizer.nmax = 20000;
+	contin_solve(p, &opts, s, g, &b);
+	check_below("pgrad objective above nnls", fixture_objective(p, g, b) / fn - 1, 1e-2);
+	
+	/* gencan from libool.a corrupts its index set, it must not run at all */
+	contin_options_default(&opts);
+	opts.solver = SOLVER_GENCAN;
+	gsl_vector_memcpy(g, gn);
+	b = bn;
+	check("gencan rejected", contin_solve(p, &opts, s, g, &b) == OOL_EINVAL);
+	check("gencan leaves the solution", fixture_objective(p, g, b) == fn);
+
+	/* from the spg solution of alpha = 1 for alpha = 1.05 */
+	size_t cold, warm;
+	gsl_vector_view xg = gsl_vector_subvector(x, 0, m);
+	contin_options_default(&opts);
+	contin_solve(p, &opts, s, g, &b);
+	gsl_vector_memcpy(&xg.vector, g);
+	gsl_vector_set(x, m, b);
+	parameter_set_alpha(p, 1.05);
+	contin(p, NULL, s, g, &b, &cold);
+	contin_options_default(&opts);
+	opts.x0 = x;
+	contin(p, &opts, s, g, &b, &warm);
+	check_below("warm start iterations against cold", (double) warm, 0.5 * cold);
+
+	gsl_vector_free(s);
+	gsl_vector_free(gn);
+	gsl_vector_free(g);
+	gsl_vector_free(x);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the minimizer iterations run on the workspace, a solve allocates as often
+ for 5 iterations as for 500
+
+------------------------------------------------------------------------------
+*/
+
+#ifdef __GLIBC__
+static size_t solve_allocations(parameter* p, int solver, size_t nmax)
+{
+	int m = p->tau->size;
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g = gsl_vector_alloc(m);
+	double b;
+	contin_options opts;
+
+	contin_options_default(&opts);
+	opts.solver = solver;
+	opts.minimizer.nmax = nmax;
+	nmalloc = 0;
+	counting = 1;
+	contin_solve(p, &opts, s, g, &b);
+	counting = 0;
+
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	return nmalloc;
+}
+
+static void test_allocations(void)
+{
+	fixture* fx = bimodal(200);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, 40, 0, GRID_LOG);
+	size_t few, many;
+
+	few  = solve_allocations(p, SOLVER_SPG, 5);
+	many = solve_allocations(p, SOLVER_SPG, 500);
+	check("spg setup allocations are counted", few > 0);
+	check("spg allocations independent of iterations", many == few);
+
+	few  = solve_allocations(p, SOLVER_PGRAD, 5);
+	many = solve_allocations(p, SOLVER_PGRAD, 500);
+	check("pgrad allocations independent of iterations", many == few);
+
+	parameter_free(p);
+	fixture_free(fx);
+}
+#else
+static void test_allocations(void)
+{
+}
+#endif
+
+/*
+------------------------------------------------------------------------------
+
+ the residual of the regularization path against the unconstrained
+ minimizer H*x = 2*[A, sqrt(w)]^T*sqrt(w)*y at the GCV alpha
+
+------------------------------------------------------------------------------
+*/
+
+static void test_regularization_path(void)
+{
+	int m = 20;
+	fixture* fx = bimodal(200);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, 0, GRID_LOG);
+	regularization_path* path = regularization_path_alloc(ALPHA_GRID_SIZE);
+
+	contin_regularization_path(p, path);
+	parameter_set_alpha(p, gsl_vector_get(path->alpha, path->igcv));
+
+	gsl_matrix* L  = gsl_matrix_alloc(m + 1, m + 1);
+	gsl_vector* xu = gsl_vector_alloc(m + 1);
+	gsl_vector* ru = gsl_vector_alloc(p->t->size);
+	gsl_vector_view xg = gsl_vector_subvector(xu, 0, m);
+	double rho;
+
+	gsl_matrix_memcpy(L, p->H);
+	gsl_linalg_cholesky_decomp(L);
+	parameter_matvec(p, CblasTrans, 2.0, p->swy, 0.0, &xg.vector);
+	gsl_blas_ddot(p->sw, p->swy, &rho);
+	gsl_vector_set(xu, m, 2 * rho);
+	gsl_linalg_cholesky_svx(L, xu);
+	residual(xu, p, ru);
+	gsl_blas_ddot(ru, ru, &rho);
+	check_below("path residual against the normal equations",
+				fabs(gsl_vector_get(path->rho, path->igcv) / rho - 1), 1e-6);
+
+	gsl_matrix_free(L);
+	gsl_vector_free(xu);
+	gsl_vector_free(ru);
+	regularization_path_free(path);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the selectors on noisy data with the variance of the noise have an 
+ interior optimum, an underestimated variance leaves the discrepancy 
+ principle at the end of the grid
+
+------------------------------------------------------------------------------
+*/
+
+static void test_alpha_selection(void)
+{
+	int m = 40;
+	fixture* fx = fixture_alloc(200, 1e-3, 50, 1e-4);
+	fixture_exponentials(fx, 0.5, 0.2, 0.5, 4, 1e-2, 0);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, 0, GRID_LOG);
+	regularization_path* path = regularization_path_alloc(ALPHA_GRID_SIZE);
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g = gsl_vector_alloc(m);
+	double b;
+	contin_options opts;
+
+	contin_regularization_path(p, path);
+	check("gcv optimum inside the grid", !regularization_path_boundary(path, ALPHA_GCV));
+	check("l-curve corner inside the grid", !regularization_path_boundary(path, ALPHA_LCURVE));
+	check("discrepancy inside the grid", !regularization_path_boundary(path, ALPHA_DISCREPANCY));
+	check("selectors ordered", path->ilcurve < path->igcv && path->igcv < path->idiscrepancy);
+
+	contin_options_default(&opts);
+	opts.solver = SOLVER_NNLS;
+	opts.criterion = ALPHA_DISCREPANCY;
+	contin_solve(p, &opts, s, g, &b);
+	check("interior alpha not flagged", !opts.boundary);
+
+	/* residuals 100 times the assumed variance, no alpha meets it */
+	gsl_vector_set_all(fx->var, 1e-6);
+	parameter_set_data(p, fx->y, fx->var);
+	contin_solve(p, &opts, s, g, &b);
+	check("underestimated variance flagged", opts.boundary);
+
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	regularization_path_free(path);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ a batch on a thread pool and a resident handle have to reproduce the
+ one-shot solves bit for bit, the handle building the kernel once
+
+------------------------------------------------------------------------------
+*/
+
+static void test_batch_and_handle(void)
+{
+	enum { NBATCH = 8 };
+	int m = 20, i;
+	fixture* fx = bimodal(200);
+	contin_problem serial[NBATCH], batch[NBATCH];
+
+	for (i = 0; i < NBATCH; i++)
+	{
+		contin_problem pr;
+		pr.t = fx->t;
+		pr.y = fx->y;
+		pr.var = fx->var;
+		pr.s0 = 1e-3;
+		pr.s1 = 50;
+		pr.m = m;
+		pr.gridType = GRID_LOG;
+		pr.tau = NULL;
+		pr.alpha = 0.1 * (i + 1);
+		pr.kernelType = 0;
+		contin_options_default(&pr.opts);
+
+		serial[i] = batch[i] = pr;
+		serial[i].s = gsl_vector_alloc(m);
+		serial[i].g = gsl_vector_alloc(m);
+		batch[i].s  = gsl_vector_alloc(m);
+		batch[i].g  = gsl_vector_alloc(m);
+		contin_problem_solve(&serial[i]);
+	}
+	contin_batch(batch, NBATCH, 4);
+
+	int identical = 1;
+	for (i = 0; i < NBATCH; i++)
+		identical &= !memcmp(serial[i].g->data, batch[i].g->data, m * sizeof(double))
+			&& !memcmp(&serial[i].b, &batch[i].b, sizeof(double));
+	check("batch on 4 threads identical to serial", identical);
+
+	gsl_vector* tau = gsl_vector_alloc(m);
+	gsl_vector* s   = gsl_vector_alloc(m);
+	gsl_vector* g   = gsl_vector_alloc(m);
+	double b;
+	tau_grid(1e-3, 50, GRID_LOG, tau);
+	contin_handle* h = contin_handle_alloc(fx->t, tau, GRID_LOG, 0, 0.0, 0.0);
+
+	identical = 1;
+	for (i = 0; i < NBATCH; i++)
+	{
+		contin_options opts;
+		contin_options_default(&opts);
+		contin_handle_solve(h, fx->y, fx->var, 0.1 * (i + 1), &opts, s, g, &b);
+		identical &= !memcmp(serial[i].g->data, g->data, m * sizeof(double))
+			&& !memcmp(&serial[i].b, &b, sizeof(double));
+	}
+	check("handle identical to one-shot solves", identical);
+	check("handle builds the weighted kernel once", h->nsetup == 1 && h->nsolve == NBATCH);
+	
+	/* warm start and bootstrap through the handle, from the last solution */
+	size_t cold, warm;
+	contin_options opts;
+	gsl_vector* x0 = gsl_vector_alloc(m + 1);
+	gsl_vector_view xg = gsl_vector_subvector(x0, 0, m);
+	gsl_vector_memcpy(&xg.vector, g);
+	gsl_vector_set(x0, m, b);
+	contin_options_default(&opts);
+	contin_handle_solve(h, fx->y, fx->var, 0.84, &opts, s, g, &b);
+	cold = opts.iterations;
+	contin_options_default(&opts);
+	opts.x0 = x0;
+	contin_handle_solve(h, fx->y, fx->var, 0.84, &opts, s, g, &b);
+	warm = opts.iterations;
+	check_below("handle warm start iterations against cold", (double) warm, 0.5 * cold);
+	
+	double levels[] = {0.025, 0.5, 0.975};
+	gsl_vector_view lv = gsl_vector_view_array(levels, 3);
+	contin_bootstrap* bh = contin_bootstrap_alloc(4, m, &lv.vector, 1);
+	contin_bootstrap* bp = contin_bootstrap_alloc(4, m, &lv.vector, 1);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 0.84, 1e-3, 50, m, 0, GRID_LOG);
+	contin_options_default(&opts);
+	contin_handle_bootstrap(h, fx->y, fx->var, 0.84, &opts, s, g, &b, bh);
+	contin_options_default(&opts);
+	contin_bootstrap_solve(p, &opts, s, g, &b, bp);
+	check("handle bootstrap identical to one-shot", 
+		  !memcmp(bh->g->data, bp->g->data, 4 * m * sizeof(double)));
+	contin_bootstrap_free(bh);
+	contin_bootstrap_free(bp);
+	parameter_free(p);
+	gsl_vector_free(x0);
+
+	for (i = 0; i < NBATCH; i++)
+	{
+		gsl_vector_free(serial[i].s);
+		gsl_vector_free(serial[i].g);
+		gsl_vector_free(batch[i].s);
+		gsl_vector_free(batch[i].g);
+	}
+	contin_handle_free(h);
+	gsl_vector_free(tau);
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the compressed kernels against the dense one, objective and gradient on
+ lag and tau grids spanning eight decades
+
+------------------------------------------------------------------------------
+*/
+
+static double gradient_distance(parameter* pa, parameter* pb, const gsl_vector* x)
+{
+	gsl_vector* ga = gsl_vector_alloc(x->size);
+	gsl_vector* gb = gsl_vector_alloc(x->size);
+	fun_df(x, pa, ga);
+	fun_df(x, pb, gb);
+	double d = fixture_distance(gb, ga);
+	gsl_vector_free(ga);
+	gsl_vector_free(gb);
+	return d;
+}
+
+static void test_compressed(void)
+{
+	int m = 200;
+	size_t i;
+	fixture* fx = fixture_alloc(1000, 1e-6, 1e2, 1);
+	fixture_exponentials(fx, 1, 1e-3, 2, 1, 0, 0);
+	gsl_vector* tau = gsl_vector_alloc(m);
+	gsl_vector* x   = gsl_vector_alloc(m + 1);
+	tau_grid(1e-6, 1e2, GRID_LOG, tau);
+	for (i = 0; i < m + 1; i++)
+		gsl_vector_set(x, i, 1.0 + sin(i));
+
+	parameter* pd = parameter_alloc_grid(fx->t, fx->y, fx->var, 0.01, tau, GRID_LOG, 0);
+	parameter* ps = parameter_alloc_grid(fx->t, fx->y, fx->var, 0.01, tau, GRID_LOG, 0);
+	parameter* ph = parameter_alloc_grid(fx->t, fx->y, fx->var, 0.01, tau, GRID_LOG, 0);
+	parameter_compress(ps, 1e-12);
+	parameter_hmatrix(ph, 1e-10, 0);
+	double fd = fun(x, pd);
+
+	check("skyline drops entries", ps->Ks && skyline_fill(ps->Ks) < 1);
+	check_below("skyline objective", fabs(fun(x, ps) / fd - 1), 1e-10);
+	check_below("skyline gradient", gradient_distance(pd, ps, x), 1e-10);
+	check("hmatrix compresses", ph->Kh && hmatrix_fill(ph->Kh) < 0.5);
+	check_below("hmatrix objective", fabs(fun(x, ph) / fd - 1), 1e-8);
+	check_below("hmatrix gradient", gradient_distance(pd, ph, x), 1e-8);
+
+	/* built directly from t and tau, the dense kernel never exists */
+	parameter* pks = parameter_alloc_kernel(fx->t, 0.01, tau, GRID_LOG, 0, 1e-12, 0);
+	parameter* pkh = parameter_alloc_kernel(fx->t, 0.01, tau, GRID_LOG, 0, 0, 1e-10);
+	parameter_set_data(pks, fx->y, fx->var);
+	parameter_set_data(pkh, fx->y, fx->var);
+	size_t gsize = (m + 1) * (m + 1) * sizeof(double);
+	check("direct skyline without dense kernel", pks->Ks && !pks->K && !pks->A);
+	check("direct skyline identical to compressed", 
+		  !memcmp(pks->Ks->offset, ps->Ks->offset, (m + 1) * sizeof(size_t))
+		  && !memcmp(pks->Ks->first, ps->Ks->first, m * sizeof(size_t))
+		  && !memcmp(pks->Ks->data, ps->Ks->data, ps->Ks->offset[m] * sizeof(double))
+		  && !memcmp(pks->G->data, ps->G->data, gsize));
+	check("direct hmatrix without dense kernel", pkh->Kh && !pkh->K && !pkh->A);
+	check("direct hmatrix Gram identical to compressed", !memcmp(pkh->G->data, ph->G->data, gsize));
+	parameter_free(pks);
+	parameter_free(pkh);
+
+	/* beta = 0 must not read y, parameter_gram passes uninitialized columns */
+	gsl_vector_view xg = gsl_vector_subvector(x, 0, m);
+	gsl_vector* yn = gsl_vector_alloc(1000);
+	gsl_vector* yd = gsl_vector_alloc(1000);
+	gsl_vector* gn = gsl_vector_alloc(m);
+	gsl_vector* gd = gsl_vector_alloc(m);
+	gsl_blas_dgemv(CblasNoTrans, 1.0, pd->A, &xg.vector, 0.0, yd);
+	gsl_blas_dgemv(CblasTrans, 1.0, pd->A, yd, 0.0, gd);
+	gsl_vector_set_all(yn, GSL_NAN);
+	gsl_vector_set_all(gn, GSL_NAN);
+	skyline_dgemv(CblasNoTrans, 1.0, ps->As, &xg.vector, 0.0, yn);
+	skyline_dgemv(CblasTrans, 1.0, ps->As, yd, 0.0, gn);
+	check_below("skyline product over NaN with beta = 0", fixture_distance(yn, yd), 1e-10);
+	check_below("skyline transposed product over NaN with beta = 0", fixture_distance(gn, gd), 1e-10);
+
+	gsl_vector_free(yn);
+	gsl_vector_free(yd);
+	gsl_vector_free(gn);
+	gsl_vector_free(gd);
+	gsl_vector_free(tau);
+	gsl_vector_free(x);
+	parameter_free(pd);
+	parameter_free(ps);
+	parameter_free(ph);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the reduced solve in the leading singular vectors and the float kernel
+ against the exact minimum of NNLS, the Jacobi preconditioned SPG against
+ the plain one
+
+------------------------------------------------------------------------------
+*/
+
+static void test_variants(void)
+{
+	int m = 40, kernelType;
+	fixture* fx = bimodal(2000);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, 0, GRID_LOG);
+	gsl_vector* s  = gsl_vector_alloc(m);
+	gsl_vector* g0 = gsl_vector_alloc(m);
+	gsl_vector* g  = gsl_vector_alloc(m);
+	double b0, b;
+	contin_options opts;
+
+	contin_options_default(&opts);
+	opts.solver = SOLVER_NNLS;
+	contin_solve(p, &opts, s, g0, &b0);
+	double f0 = fixture_objective(p, g0, b0);
+
+	contin_options_default(&opts);
+	opts.rtol = 1e-10;
+	contin_solve(p, &opts, s, g, &b);
+	check("reduced solve drops singular vectors", opts.rank > 0 && opts.rank < m + 1);
+	check_below("reduced objective above nnls", fixture_objective(p, g, b) / f0 - 1, 1e-2);
+
+	parameter* ps = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, 0, GRID_LOG);
+	parameter_single(ps, 1);
+	contin_options_default(&opts);
+	contin_solve(ps, &opts, s, g, &b);
+	check_below("single kernel objective above nnls", fixture_objective(p, g, b) / f0 - 1, 1e-2);
+	parameter_free(ps);
+
+	/* the synthetic cases of test_contin.m */
+	for (kernelType = 0; kernelType < 2; kernelType++)
+	{
+		fixture* ft = fixture_test_case(kernelType);
+		int mt = kernelType == 0 ? 390 : 100;
+		parameter* pt = parameter_alloc(ft->t, ft->y, ft->var, 0.1, kernelType == 0 ? 1 : 0.1,
+										kernelType == 0 ? 20 : 5, mt, kernelType, GRID_LINEAR);
+		gsl_vector* st = gsl_vector_alloc(mt);
+		gsl_vector* gt = gsl_vector_alloc(mt);
+		double bt, ft0;
+
+		contin(pt, NULL, st, gt, &bt, NULL);
+		ft0 = fixture_objective(pt, gt, bt);
+		contin_options_default(&opts);
+		opts.precondition = 1;
+		contin(pt, &opts, st, gt, &bt, NULL);
+		check_below(kernelType == 0 ? "preconditioned objective, exp" : "preconditioned objective, lorentz",
+					fixture_objective(pt, gt, bt) / ft0 - 1, 1e-4);
+
+		gsl_vector_free(st);
+		gsl_vector_free(gt);
+		parameter_free(pt);
+		fixture_free(ft);
+	}
+
+	gsl_vector_free(s);
+	gsl_vector_free(g0);
+	gsl_vector_free(g);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ budgets on the slow Lorentz case of test_contin.m, the objective falls
+ with every larger budget and the budget outcomes ask for a re-solve
+
+------------------------------------------------------------------------------
+*/
+
+static void test_budgets(void)
+{
+	int m = 100, k;
+	fixture* fx = fixture_test_case(1);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 0.1, 0.1, 5, m, 1, GRID_LINEAR);
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g = gsl_vector_alloc(m);
+	gsl_vector* x = gsl_vector_alloc(m + 1);
+	double b, fprev = GSL_POSINF;
+	size_t budget[] = {50, 200, 800, 0};
+	int monotone = 1, status;
+	contin_options opts;
+
+	for (k = 0; k < 4; k++)
+	{
+		contin_options_default(&opts);
+		if (budget[k])
+			opts.minimizer.nmax = budget[k];
+		status = contin_solve(p, &opts, s, g, &b);
+		double f = fixture_objective(p, g, b);
+		monotone &= f <= fprev;
+		fprev = f;
+		if (k == 0)
+			check("budget of 50 asks for a re-solve", status == OOL_EMAXITER && contin_resolve(status));
+	}
+	check("objective falls with the budget", monotone);
+	check("unbounded solve converges", status == OOL_SUCCESS && !contin_resolve(status));
+
+	contin_options_default(&opts);
+	opts.minimizer.deadline = 1e-4;
+	status = contin_solve(p, &opts, s, g, &b);
+	check("deadline stops the solve", status == CONTIN_DEADLINE && contin_resolve(status));
+
+	/* the stall stop returns the best iterate, which is not the last */
+	contin_options_default(&opts);
+	opts.minimizer.stall = 5;
+	status = contin_solve(p, &opts, s, g, &b);
+	check("stall stops the solve", status == OOL_ENOPROG || status == OOL_SUCCESS);
+
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	gsl_vector_free(x);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ coarse-to-fine levels of contin2.m against a cold solve on the finest grid
+
+------------------------------------------------------------------------------
+*/
+
+static void test_multires(void)
+{
+	int m = 40, cycles = 5, levels;
+	int mf = m + MULTIRES_STEP * (cycles - 1);
+	fixture* fx = bimodal(200);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, mf, 0, GRID_LOG);
+	gsl_vector* s  = gsl_vector_alloc(mf);
+	gsl_vector* gd = gsl_vector_alloc(mf);
+	gsl_vector* gm = gsl_vector_alloc(mf);
+	double bd, bm;
+	contin_options opts;
+
+	contin_options_default(&opts);
+	contin_solve(p, &opts, s, gd, &bd);
+	contin_options_default(&opts);
+	contin_multires(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, cycles, 0, MULTIRES_TOL,
+					&opts, s, gm, &bm, &levels);
+
+	check("multires uses at least one level", levels >= 1 && levels <= cycles);
+	check_below("multires objective", fabs(fixture_objective(p, gm, bm) / fixture_objective(p, gd, bd) - 1), 1e-3);
+
+	/* a single coarse point has nothing to interpolate between */
+	gsl_vector_view s1 = gsl_vector_subvector(s, 0, 1 + MULTIRES_STEP);
+	gsl_vector_view g1 = gsl_vector_subvector(gm, 0, 1 + MULTIRES_STEP);
+	check("multires rejects a single coarse point",
+		  contin_multires(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, 1, 2, 0, MULTIRES_TOL,
+						  &opts, &s1.vector, &g1.vector, &bm, &levels) == OOL_EINVAL);
+
+	gsl_vector_free(s);
+	gsl_vector_free(gd);
+	gsl_vector_free(gm);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ bootstrap replicates do not depend on the number of threads and the
+ bands hold the base solution
+
+------------------------------------------------------------------------------
+*/
+
+static void test_bootstrap(void)
+{
+	int m = 40, R = 10, k, j;
+	fixture* fx = fixture_alloc(200, 1e-4, 100, 1e-6);
+	fixture_exponentials(fx, 0.5, 0.02, 0.5, 3, 1e-3, 0);
+	double levels[] = {0.025, 0.5, 0.975};
+	gsl_vector_view lv = gsl_vector_view_array(levels, 3);
+	contin_bootstrap* bs[2];
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g = gsl_vector_alloc(m);
+	double b;
+
+	for (k = 0; k < 2; k++)
+	{
+		contin_options opts;
+		contin_set_threads(k + 1);
+		parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, 0, GRID_LOG);
+		bs[k] = contin_bootstrap_alloc(R, m, &lv.vector, 1);
+		contin_options_default(&opts);
+		contin_bootstrap_solve(p, &opts, s, g, &b, bs[k]);
+		parameter_free(p);
+	}
+	contin_set_threads(1);
+
+	int inside = 0;
+	for (j = 0; j < m; j++)
+		inside += gsl_vector_get(g, j) >= gsl_matrix_get(bs[0]->band, 0, j)
+			&& gsl_vector_get(g, j) <= gsl_matrix_get(bs[0]->band, 2, j);
+
+	check("bootstrap identical on 2 threads", !memcmp(bs[0]->g->data, bs[1]->g->data, R * m * sizeof(double)));
+	check("bootstrap replicates converge", bs[0]->failed == 0);
+	check_below("base solution outside the bands", (double) (m - inside) / m, 0.2);
+	check("bootstrap finds both peaks", bs[0]->peak && bs[0]->peak->size == 2);
+
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	contin_bootstrap_free(bs[0]);
+	contin_bootstrap_free(bs[1]);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the replicates carry noise of the variance var: the bands of R 
+ replicates match the quantiles of R independent solves of y plus 
+ gaussian noise of standard deviation sqrt(var), noise of sd var or 
+ sqrt(sqrt(var)) would widen or narrow them by orders of magnitude
+
+------------------------------------------------------------------------------
+*/
+
+static double band_width(const gsl_matrix* band)
+{
+	double w = 0;
+	size_t j;
+	for (j = 0; j < band->size2; j++)
+		w += gsl_matrix_get(band, 2, j) - gsl_matrix_get(band, 0, j);
+	return w;
+}
+
+static void test_bootstrap_noise(void)
+{
+	int m = 40, R = 200, r;
+	size_t i;
+	double sd = 1e-3;
+	fixture* fx = fixture_alloc(200, 1e-4, 100, sd * sd);
+	fixture_exponentials(fx, 0.5, 0.02, 0.5, 3, 0, 0);
+	double levels[] = {0.025, 0.5, 0.975};
+	gsl_vector_view lv = gsl_vector_view_array(levels, 3);
+	gsl_matrix* G = gsl_matrix_alloc(R, m);
+	gsl_matrix* band = gsl_matrix_alloc(3, m);
+	gsl_vector* y = gsl_vector_alloc(fx->t->size);
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g = gsl_vector_alloc(m);
+	gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
+	double b;
+	contin_options opts;
+
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, 0, GRID_LOG);
+	contin_bootstrap* bs = contin_bootstrap_alloc(R, m, &lv.vector, 1);
+	contin_options_default(&opts);
+	opts.solver = SOLVER_NNLS;
+	contin_bootstrap_solve(p, &opts, s, g, &b, bs);
+
+	gsl_rng_set(rng, 12345);
+	for (r = 0; r < R; r++)
+	{
+		gsl_vector_view gr = gsl_matrix_row(G, r);
+		for (i = 0; i < y->size; i++)
+			gsl_vector_set(y, i, gsl_vector_get(fx->y, i) + gsl_ran_gaussian(rng, sd));
+		parameter_set_data(p, y, fx->var);
+		contin_options_default(&opts);
+		opts.solver = SOLVER_NNLS;
+		contin_solve(p, &opts, s, &gr.vector, &b);
+	}
+	for (i = 0; i < (size_t) m; i++)
+	{
+		gsl_vector_view col = gsl_matrix_column(G, i);
+		double x[200];
+		for (r = 0; r < R; r++)
+			x[r] = gsl_vector_get(&col.vector, r);
+		gsl_sort(x, 1, R);
+		for (r = 0; r < 3; r++)
+			gsl_matrix_set(band, r, i, gsl_stats_quantile_from_sorted_data(x, 1, R, levels[r]));
+	}
+
+	double ratio = band_width(bs->band) / band_width(band);
+	check("bootstrap band width nonzero", band_width(band) > 0);
+	check_below("bootstrap band width against independent noise", fabs(log(ratio)), log(1.25));
+
+	gsl_rng_free(rng);
+	gsl_vector_free(y);
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	gsl_matrix_free(G);
+	gsl_matrix_free(band);
+	contin_bootstrap_free(bs);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ counts pooled from their sufficient statistics against one solve of all
+ counts stacked, which has the same objective up to a constant
+
+------------------------------------------------------------------------------
+*/
+
+static void test_pooled(void)
+{
+	int n = 200, m = 40, nc = 4, k;
+	size_t i;
+	fixture* fx = fixture_alloc(n, 1e-4, 100, 1e-6);
+	gsl_vector* ta = gsl_vector_alloc(nc * n);
+	gsl_vector* ya = gsl_vector_alloc(nc * n);
+	gsl_vector* va = gsl_vector_alloc(nc * n);
+	gsl_vector* tau = gsl_vector_alloc(m);
+	gsl_vector* s  = gsl_vector_alloc(m);
+	gsl_vector* gp = gsl_vector_alloc(m);
+	gsl_vector* gd = gsl_vector_alloc(m);
+	double bp, bd;
+	contin_options opts;
+
+	tau_grid(1e-3, 50, GRID_LOG, tau);
+	contin_handle* h = contin_handle_alloc(fx->t, tau, GRID_LOG, 0, 0, 0);
+
+	for (k = 0; k < nc; k++)
+	{
+		/* every count has its own noise and, from the third on, its own variance */
+		fixture_exponentials(fx, 0.5, 0.02, 0.5, 3, 1e-3, 7 * k);
+		for (i = 0; i < n; i++)
+			gsl_vector_set(fx->var, i, k < 2 ? 1e-6 : 1e-6 * (1 + 0.1 * k + 1e-3 * i));
+		contin_handle_add(h, fx->y, fx->var);
+
+		gsl_vector_view tk = gsl_vector_subvector(ta, k * n, n);
+		gsl_vector_view yk = gsl_vector_subvector(ya, k * n, n);
+		gsl_vector_view vk = gsl_vector_subvector(va, k * n, n);
+		gsl_vector_memcpy(&tk.vector, fx->t);
+		gsl_vector_memcpy(&yk.vector, fx->y);
+		gsl_vector_memcpy(&vk.vector, fx->var);
+	}
+	contin_options_default(&opts);
+	contin_handle_pooled(h, 1.0, &opts, s, gp, &bp);
+
+	parameter* pd = parameter_alloc_grid(ta, ya, va, 1.0, tau, GRID_LOG, 0);
+	contin_options_default(&opts);
+	contin_solve(pd, &opts, s, gd, &bd);
+	check_below("pooled objective against stacked",
+				fabs(fixture_objective(pd, gp, bp) / fixture_objective(pd, gd, bd) - 1), 1e-4);
+
+	gsl_vector_free(ta);
+	gsl_vector_free(ya);
+	gsl_vector_free(va);
+	gsl_vector_free(tau);
+	gsl_vector_free(s);
+	gsl_vector_free(gp);
+	gsl_vector_free(gd);
+	parameter_free(pd);
+	contin_handle_free(h);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the handle table of contin('create', ...): a create shares a handle 
+ without counts and takes a reference, counts of a destroyed handle do 
+ not reach the next create on the same grids
+
+------------------------------------------------------------------------------
+*/
+
+static void test_handle_table(void)
+{
+	int m = 40;
+	fixture* fx = bimodal(200);
+	gsl_vector* tau = gsl_vector_alloc(m);
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g = gsl_vector_alloc(m);
+	double b;
+	contin_options opts;
+
+	tau_grid(1e-3, 50, GRID_LOG, tau);
+	contin_options_default(&opts);
+	opts.solver = SOLVER_NNLS;
+
+	/* create, add, destroy, create, pooled */
+	int a = contin_handle_create(fx->t, tau, GRID_LOG, 0, 0, 0);
+	contin_handle_add(contin_handle_lookup(a), fx->y, fx->var);
+	contin_handle_destroy(a);
+	check("destroyed handle is gone", contin_handle_lookup(a) == NULL);
+	int c = contin_handle_create(fx->t, tau, GRID_LOG, 0, 0, 0);
+	check("new create pools no stale counts",
+		  contin_handle_pooled(contin_handle_lookup(c), 1.0, &opts, s, g, &b) == OOL_EBADLEN);
+
+	/* a second create shares the handle until both destroy it */
+	int d = contin_handle_create(fx->t, tau, GRID_LOG, 0, 0, 0);
+	contin_handle* h = contin_handle_lookup(c);
+	check("identical create shares the handle", d == c && h->refs == 2);
+	check("shared handle refuses counts", contin_handle_add(h, fx->y, fx->var) == OOL_EINVAL);
+	contin_handle_destroy(d);
+	check("handle survives the first destroy", contin_handle_lookup(c) == h && h->refs == 1);
+	check("survivor still solves", contin_handle_solve(h, fx->y, fx->var, 1.0, &opts, s, g, &b) == OOL_SUCCESS);
+
+	/* a handle with counts is not handed to another create */
+	contin_handle_add(h, fx->y, fx->var);
+	int e = contin_handle_create(fx->t, tau, GRID_LOG, 0, 0, 0);
+	check("handle with counts is not shared", e != c && contin_handle_lookup(e)->acc == NULL);
+	contin_handle_destroy(c);
+	contin_handle_destroy(e);
+	check("all handles released", !contin_handle_lookup(c) && !contin_handle_lookup(e));
+
+	contin_handle_destroy_all();
+	gsl_vector_free(tau);
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ maximum entropy is strictly convex, the cold and warm start reach the
+ same solution
+
+------------------------------------------------------------------------------
+*/
+
+static void test_mem(void)
+{
+	int m = 40;
+	fixture* fx = fixture_alloc(400, 1e-4, 100, 1e-6);
+	fixture_exponentials(fx, 0.5, 0.02, 0.5, 3, 1e-3, 0);
+	parameter* p = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, m, 0, GRID_LOG);
+	gsl_vector* s  = gsl_vector_alloc(m);
+	gsl_vector* gn = gsl_vector_alloc(m);
+	gsl_vector* gc = gsl_vector_alloc(m);
+	gsl_vector* gw = gsl_vector_alloc(m);
+	gsl_vector* x  = gsl_vector_alloc(m + 1);
+	double bn, bc, bw;
+	contin_options opts;
+
+	contin_options_default(&opts);
+	opts.solver = SOLVER_NNLS;
+	contin_solve(p, &opts, s, gn, &bn);
+
+	contin_options_default(&opts);
+	opts.solver = SOLVER_MEM;
+	check("MEM converges from a cold start", contin_solve(p, &opts, s, gc, &bc) == OOL_SUCCESS);
+	check("MEM keeps g positive", gsl_vector_min(gc) > 0);
+
+	/* from the NNLS solution, its zeros lifted into the interior */
+	gsl_vector_view xg = gsl_vector_subvector(x, 0, m);
+	gsl_vector_memcpy(&xg.vector, gn);
+	gsl_vector_add_constant(&xg.vector, 1e-3);
+	gsl_vector_set(x, m, bn);
+	contin_options_default(&opts);
+	opts.solver = SOLVER_MEM;
+	opts.x0 = x;
+	check("MEM converges from a warm start", contin_solve(p, &opts, s, gw, &bw) == OOL_SUCCESS);
+	check_below("MEM cold against warm", fixture_distance(gw, gc), 1e-4);
+
+	gsl_vector_free(s);
+	gsl_vector_free(gn);
+	gsl_vector_free(gc);
+	gsl_vector_free(gw);
+	gsl_vector_free(x);
+	parameter_free(p);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ one D distribution for several angles recovers their amplitudes,
+ baselines and the two modes
+
+------------------------------------------------------------------------------
+*/
+
+static void test_global(void)
+{
+	int m = 60, N = 4, j;
+	fixture* fx = fixture_alloc(200, 1e-4, 100, 1e-6);
+	gsl_vector* D = gsl_vector_alloc(m);
+	gsl_vector* s = gsl_vector_alloc(m);
+	gsl_vector* g = gsl_vector_alloc(m);
+	contin_global* gl;
+	contin_options opts;
+	double amean = 0, da = 0, db = 0;
+
+	tau_grid(1e-2, 1e3, GRID_LOG, D);
+	gl = contin_global_alloc(D, GRID_LOG);
+	for (j = 0; j < N; j++)
+		amean += (1 + 0.3 * sin(j)) / N;
+	for (j = 0; j < N; j++)
+	{
+		double q2 = 0.5 * pow(16, (double) j / (N - 1));
+		double a = 1 + 0.3 * sin(j);
+		fixture_exponentials(fx, 0.5 * a, 1 / q2, 0.5 * a, 1 / (30 * q2), 1e-3, 3 * j);
+		gsl_vector_add_constant(fx->y, 0.01 * j / N);
+		contin_global_add(gl, fx->t, fx->y, fx->var, q2);
+	}
+
+	/* the root is as ill-conditioned as the data are good, NNLS is exact on it */
+	contin_options_default(&opts);
+	opts.solver = SOLVER_NNLS;
+	check("global solve converges", contin_global_solve(gl, 1.0, &opts, s, g) == OOL_SUCCESS);
+	for (j = 0; j < N; j++)
+	{
+		da = GSL_MAX(da, fabs(gsl_vector_get(gl->a, j) - (1 + 0.3 * sin(j)) / amean));
+		db = GSL_MAX(db, fabs(gsl_vector_get(gl->b, j) - 0.01 * j / N));
+	}
+	check_below("global amplitudes", da, 1e-2);
+	check_below("global baselines", db, 1e-3);
+
+	gsl_vector_free(D);
+	gsl_vector_free(s);
+	gsl_vector_free(g);
+	contin_global_free(gl);
+	fixture_free(fx);
+}
+
+/*
+------------------------------------------------------------------------------
+
+ the specialized products against BLAS, and a threaded setup against
+ the serial one bit for bit
+
+------------------------------------------------------------------------------
+*/
+
+static void test_products(void)
+{
+	int k, n, m;
+	size_t i, j;
+
+	for (k = 0; fixed_size(k, &n, &m); k++)
+	{
+		gsl_matrix* A = gsl_matrix_alloc(n, m);
+		gsl_vector* x = gsl_vector_alloc(m);
+		gsl_vector* r = gsl_vector_alloc(n);
+		gsl_vector* y[2];
+		gsl_vector* z[2];
+		int enabled;
+
+		for (i = 0; i < n; i++)
+		{
+			gsl_vector_set(r, i, sin(1.0 + i));
+			for (j = 0; j < m; j++)
+				gsl_matrix_set(A, i, j, exp(-(i + 1.0) / (j + 1.0)));
+		}
+		for (j = 0; j < m; j++)
+			gsl_vector_set(x, j, cos(1.0 + j));
+
+		for (enabled = 0; enabled < 2; enabled++)
+		{
+			int previous = fixed_set_enabled(enabled);
+			y[enabled] = gsl_vector_alloc(n);
+			z[enabled] = gsl_vector_alloc(m);
+			if (!fixed_dgemv(CblasNoTrans, 1.0, A, x, 0.0, y[enabled]))
+				gsl_blas_dgemv(CblasNoTrans, 1.0, A, x, 0.0, y[enabled]);
+			if (!fixed_dgemv(CblasTrans, 1.0, A, r, 0.0, z[enabled]))
+				gsl_blas_dgemv(CblasTrans, 1.0, A, r, 0.0, z[enabled]);
+			fixed_set_enabled(previous);
+		}
+		check_below("fixed A*x against BLAS", fixture_distance(y[1], y[0]), 1e-14);
+		check_below("fixed A^T*r against BLAS", fixture_distance(z[1], z[0]), 1e-14);
+
+		for (enabled = 0; enabled < 2; enabled++)
+		{
+			gsl_vector_free(y[enabled]);
+			gsl_vector_free(z[enabled]);
+		}
+		gsl_matrix_free(A);
+		gsl_vector_free(x);
+		gsl_vector_free(r);
+	}
+
+	/* n*m above PARALLEL_MIN, the setup and products are split */
+	fixture* fx = bimodal(8000);
+	parameter* p[2];
+	for (k = 0; k < 2; k++)
+	{
+		contin_set_threads(2 * k + 1);
+		p[k] = parameter_alloc(fx->t, fx->y, fx->var, 1.0, 1e-3, 50, 40, 0, GRID_LOG);
+		parameter_gram(p[k]);
+	}
+	contin_set_threads(1);
+	check("threaded kernel identical to serial",
+		  !memcmp(p[0]->K->data, p[1]->K->data, p[0]->K->size1 * p[0]->K->size2 * sizeof(double)));
+	check("threaded Gram matrix identical to serial",
+		  !memcmp(p[0]->G->data, p[1]->G->data, p[0]->G->size1 * p[0]->G->size2 * sizeof(double)));
+	parameter_free(p[0]);
+	parameter_free(p[1]);
+	fixture_free(fx);
+}
+
+int main(void)
+{
+	test_derivatives();
+	test_kernel();
+	test_engines();
+	test_allocations();
+	test_regularization_path();
+	test_alpha_selection();
+	test_batch_and_handle();
+	test_compressed();
+	test_variants();
+	test_budgets();
+	test_multires();
+	test_bootstrap();
+	test_bootstrap_noise();
+	test_pooled();
+	test_handle_table();
+	test_mem();
+	test_global();
+	test_products();
+
+	printf("%d of %d checks failed\n", nfail, ncheck);
+	return nfail;
+}
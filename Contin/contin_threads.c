@@ -0,0 +1,182 @@
+/*
+------------------------------------------------------------------------------
+
+ Description: worker pool for the products inside a single solve
+
+ A large inversion splits its kernel build, forward and adjoint products
+ and the Gram matrix into chunks of PARALLEL_ROWS rows or PARALLEL_COLS
+ columns. The chunk boundaries depend on the problem size only and every
+ chunk is computed by one call on its own block. A sum across chunks, 
+ the adjoint product, keeps the chunk results apart and adds them in 
+ chunk order afterwards. Which thread computes a chunk therefore does 
+ not matter, the results are bitwise identical for any number of 
+ threads, including the serial path that runs the same chunks one after 
+ another.
+
+ The pool is shared by the process and started by contin_set_threads,
+ its workers sleep between calls. Only one parallel_chunks runs on the
+ pool at a time, a second caller, e.g. another worker of contin_batch,
+ runs its chunks itself.
+
+ contin_bench threads prints the setup, both products, the Gram matrix 
+ and 200 SPG iterations for n = 8000, m = 200 at every thread count from 
+ 1 to the number of cores, with the speedup against 1 thread. 
+ 
+ OPEN: the speedup on several cores has not been measured, the pool is 
+ not shown to pay off yet. The only host available had a single core, 
+ where 2 threads run at 0.78 (Gram) to 1.05 (setup) of the serial speed, 
+ which is the overhead of the pool and nothing more. The table of 
+ contin_bench threads from a multi-core host belongs here before the 
+ pool can count as done.
+
+------------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "contin.h"
+
+typedef struct
+{
+	pthread_t* workers;
+	int nworkers;				/* threads besides the caller */
+	pthread_mutex_t busy;		/* held by the caller of parallel_chunks */
+	pthread_mutex_t lock;		/* protects everything below */
+	pthread_cond_t start;
+	pthread_cond_t done;
+	unsigned long generation;	/* counts the calls, wakes the workers */
+	int quit;
+	chunk_function f;
+	void* arg;
+	size_t nchunks;
+	size_t next;				/* next chunk to hand out */
+	size_t finished;			/* chunks computed */
+
+} thread_pool;
+
+static thread_pool pool =
+{
+	NULL, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, NULL, NULL, 0, 0, 0
+};
+
+/* hand out the chunks of the current call, entered and left with the lock */
+static void pool_run(void)
+{
+	while (pool.next < pool.nchunks)
+	{
+		size_t c = pool.next++;
+		pthread_mutex_unlock(&pool.lock);
+		pool.f(pool.arg, c);
+		pthread_mutex_lock(&pool.lock);
+
+		if (++pool.finished == pool.nchunks)
+			pthread_cond_broadcast(&pool.done);
+	}
+}
+
+static void* pool_worker(void* unused)
+{
+	unsigned long seen = 0;
+
+	pthread_mutex_lock(&pool.lock);
+	for (;;)
+	{
+		while (!pool.quit && pool.generation == seen)
+			pthread_cond_wait(&pool.start, &pool.lock);
+		if (pool.quit)
+			break;
+
+		seen = pool.generation;
+		pool_run();
+	}
+	pthread_mutex_unlock(&pool.lock);
+
+	return NULL;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ nthreads <= 0 uses all cores, 1 stops the workers, must not be called
+ while a solve is running
+
+------------------------------------------------------------------------------
+*/
+
+void contin_set_threads(int nthreads)
+{
+	int k;
+
+	if (nthreads <= 0)
+		nthreads = contin_threads_default();
+	if (nthreads - 1 == pool.nworkers)
+		return;
+
+	if (pool.nworkers)
+	{
+		pthread_mutex_lock(&pool.lock);
+		pool.quit = 1;
+		pthread_cond_broadcast(&pool.start);
+		pthread_mutex_unlock(&pool.lock);
+
+		for (k = 0; k < pool.nworkers; k++)
+			pthread_join(pool.workers[k], NULL);
+		free(pool.workers);
+		pool.workers  = NULL;
+		pool.nworkers = 0;
+		pool.quit     = 0;
+	}
+
+	if (nthreads > 1)
+	{
+		pool.workers = malloc((nthreads - 1) * sizeof(pthread_t));
+		pthread_mutex_lock(&pool.lock);
+		for (k = 0; k < nthreads - 1; k++)
+			if (pthread_create(&pool.workers[pool.nworkers], NULL, pool_worker, NULL) == 0)
+				pool.nworkers++;
+		pthread_mutex_unlock(&pool.lock);
+	}
+}
+
+int contin_get_threads(void)
+{
+	return pool.nworkers + 1;
+}
+
+/*
+------------------------------------------------------------------------------
+
+ f(arg, c) for c = 0, ..., nchunks - 1 on the pool, the caller helps and
+ returns when all chunks are done
+
+------------------------------------------------------------------------------
+*/
+
+void parallel_chunks(size_t nchunks, chunk_function f, void* arg)
+{
+	size_t c;
+
+	if (pool.nworkers == 0 || nchunks < 2 || pthread_mutex_trylock(&pool.busy) != 0)
+	{
+		for (c = 0; c < nchunks; c++)
+			f(arg, c);
+		return;
+	}
+
+	pthread_mutex_lock(&pool.lock);
+	pool.f        = f;
+	pool.arg      = arg;
+	pool.nchunks  = nchunks;
+	pool.next     = 0;
+	pool.finished = 0;
+	pool.generation++;
+	pthread_cond_broadcast(&pool.start);
+
+	pool_run();
+	while (pool.finished < pool.nchunks)
+		pthread_cond_wait(&pool.done, &pool.lock);
+	pthread_mutex_unlock(&pool.lock);
+
+	pthread_mutex_unlock(&pool.busy);
+}
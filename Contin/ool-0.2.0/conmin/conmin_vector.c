@@ -27,12 +27,35 @@
 #include <string.h>
 #include <math.h>
 #include <gsl/gsl_math.h>
+#include <gsl/gsl_sys.h>
+#include <gsl/gsl_machine.h>
 #include <conmin_vector.h>
 
-/* A = max( B, min( C, D ) )
+/* The primitives run on every projection and convergence test of SPG
+ * and PGRAD. Each has a scalar reference version and, on x86 with gcc,
+ * an AVX2 version of four doubles per instruction. The variant is
+ * chosen once from the processor, conmin_vector_set_isa overrides it.
+ * max and min keep the operand order of GSL_MAX and GSL_MIN, so the
+ * projections agree bit for bit with the scalar loops, the reductions
+ * dist and dist_inf only in the order of their sums.
  *----------------------------------------------------------------------------*/
-void conmin_vector_maxofmin( const size_t nn, 
-			     double *A, double *B,
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONMIN_VECTOR_X86
+#include <immintrin.h>
+#define CONMIN_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+/* below this size the reductions are faster as scalar loops */
+#define CONMIN_VECTOR_SHORT 16
+
+static int conmin_vector_isa = -1;
+
+/*----------------------------------------------------------------------------*/
+/* Scalar reference versions                                                  */
+/*----------------------------------------------------------------------------*/
+
+static void maxofmin_scalar( const size_t nn, double *A, double *B,
 			     double *C, double *D )
 {
   size_t ii;
@@ -41,10 +64,7 @@ void conmin_vector_maxofmin( const size_t nn,
     A[ii] = GSL_MAX( B[ii], GSL_MIN( C[ii], D[ii] ) );
 }
 
-/* A = min( B, max( C, D ) )
- *----------------------------------------------------------------------------*/
-void conmin_vector_minofmax( const size_t nn, 
-			     double *A, double *B,
+static void minofmax_scalar( const size_t nn, double *A, double *B,
 			     double *C, double *D )
 {
   size_t ii;
@@ -53,18 +73,7 @@ void conmin_vector_minofmax( const size_t nn,
     A[ii] = GSL_MIN( B[ii], GSL_MAX( C[ii], D[ii] ) );
 }
 
-/* Destine = Source
- *----------------------------------------------------------------------------*/
-void conmin_vector_memcpy( const size_t nn, double *D, double *S )
-{
-  const size_t size = nn * sizeof( double );
-
-  memcpy( (void*)D, (void*)S, size );
-}
-
-/* X = v
- *----------------------------------------------------------------------------*/
-void conmin_vector_set_all( const size_t nn, double *X, double vv )
+static void set_all_scalar( const size_t nn, double *X, double vv )
 {
   size_t ii;
 
@@ -72,21 +81,7 @@ void conmin_vector_set_all( const size_t nn, double *X, double vv )
      X[ii] = vv;
 }
 
-/* X = 0
- *----------------------------------------------------------------------------*/
-void conmin_vector_set_zero( const size_t nn, double *X )
-{
-  size_t ii;
-
-  /* This was formely done with memset, but that was wrong since the
-   * double zero must not be represent as zero bytes on any machine */
-  for( ii = 0; ii < nn; ii++ )
-     X[ii] = 0.0;
-}
-
-/* dist = | X - Y |_2
- *----------------------------------------------------------------------------*/
-double conmin_vector_dist( const size_t nn, double *X, double *Y )
+static double dist_scalar( const size_t nn, double *X, double *Y )
 {
    double scale = 0.0;
    double ssq = 1.0;
@@ -115,9 +110,7 @@ double conmin_vector_dist( const size_t nn, double *X, double *Y )
    return scale * sqrt(ssq);
 }
 
-/* dist = | X - Y |_inf
- *----------------------------------------------------------------------------*/
-double conmin_vector_dist_inf( const size_t nn, double *X, double *Y )
+static double dist_inf_scalar( const size_t nn, double *X, double *Y )
 {
   size_t ii;
   double dist = 0;
@@ -128,4 +121,328 @@ double conmin_vector_dist_inf( const size_t nn, double *X, double *Y )
   return dist;
 }
 
+static void axpy_project_scalar( const size_t nn, double *A, double *X,
+				 double alpha, double *D,
+				 double *L, double *U )
+{
+  size_t ii;
+
+  for( ii = 0; ii < nn; ii++ )
+    A[ii] = GSL_MAX( L[ii], GSL_MIN( U[ii], X[ii] + alpha * D[ii] ) );
+}
+
+static double projgrad_inf_scalar( const size_t nn, double *X, double *G,
+				   double *L, double *U )
+{
+  size_t ii;
+  double size = 0;
+
+  for( ii = 0; ii < nn; ii++ )
+    {
+      double pp = GSL_MAX( L[ii], GSL_MIN( U[ii], X[ii] - G[ii] ) );
+      size = GSL_MAX( size, fabs( pp - X[ii] ) );
+    }
+
+  return size;
+}
+
+#ifdef CONMIN_VECTOR_X86
+
+/*----------------------------------------------------------------------------*/
+/* AVX2 versions, unaligned loads, the tail by the scalar loops               */
+/*----------------------------------------------------------------------------*/
+
+/* max_pd(a, b) is a > b ? a : b and min_pd(a, b) is a < b ? a : b, the
+ * same as GSL_MAX(a, b) and GSL_MIN(a, b) also for NaN */
+
+CONMIN_AVX2
+static void maxofmin_avx2( const size_t nn, double *A, double *B,
+			   double *C, double *D )
+{
+  size_t ii;
+
+  for( ii = 0; ii + 4 <= nn; ii += 4 )
+    {
+      __m256d cd = _mm256_min_pd( _mm256_loadu_pd( C + ii ),
+				  _mm256_loadu_pd( D + ii ) );
+      _mm256_storeu_pd( A + ii, _mm256_max_pd( _mm256_loadu_pd( B + ii ), cd ) );
+    }
+  maxofmin_scalar( nn - ii, A + ii, B + ii, C + ii, D + ii );
+}
+
+CONMIN_AVX2
+static void minofmax_avx2( const size_t nn, double *A, double *B,
+			   double *C, double *D )
+{
+  size_t ii;
+
+  for( ii = 0; ii + 4 <= nn; ii += 4 )
+    {
+      __m256d cd = _mm256_max_pd( _mm256_loadu_pd( C + ii ),
+				  _mm256_loadu_pd( D + ii ) );
+      _mm256_storeu_pd( A + ii, _mm256_min_pd( _mm256_loadu_pd( B + ii ), cd ) );
+    }
+  minofmax_scalar( nn - ii, A + ii, B + ii, C + ii, D + ii );
+}
+
+CONMIN_AVX2
+static void set_all_avx2( const size_t nn, double *X, double vv )
+{
+  __m256d v = _mm256_set1_pd( vv );
+  size_t ii;
+
+  for( ii = 0; ii + 4 <= nn; ii += 4 )
+    _mm256_storeu_pd( X + ii, v );
+  set_all_scalar( nn - ii, X + ii, vv );
+}
+
+/* |X - Y| with the sign bit cleared */
+CONMIN_AVX2
+static __inline__ __m256d abs_diff_avx2( double *X, double *Y, size_t ii )
+{
+  const __m256d sign = _mm256_set1_pd( -0.0 );
+
+  return _mm256_andnot_pd( sign, _mm256_sub_pd( _mm256_loadu_pd( X + ii ),
+						 _mm256_loadu_pd( Y + ii ) ) );
+}
+
+/* largest of the four lanes */
+CONMIN_AVX2
+static __inline__ double hmax_avx2( __m256d v )
+{
+  __m128d m = _mm_max_pd( _mm256_castpd256_pd128( v ), _mm256_extractf128_pd( v, 1 ) );
+  return GSL_MAX( _mm_cvtsd_f64( m ), _mm_cvtsd_f64( _mm_unpackhi_pd( m, m ) ) );
+}
+
+CONMIN_AVX2
+static double dist_inf_avx2( const size_t nn, double *X, double *Y )
+{
+  __m256d d0 = _mm256_setzero_pd( );
+  __m256d d1 = _mm256_setzero_pd( );
+  size_t ii;
+
+  if( nn < CONMIN_VECTOR_SHORT )
+    return dist_inf_scalar( nn, X, Y );
+
+  for( ii = 0; ii + 8 <= nn; ii += 8 )
+    {
+      d0 = _mm256_max_pd( d0, abs_diff_avx2( X, Y, ii ) );
+      d1 = _mm256_max_pd( d1, abs_diff_avx2( X, Y, ii + 4 ) );
+    }
+  if( ii + 4 <= nn )
+    {
+      d0 = _mm256_max_pd( d0, abs_diff_avx2( X, Y, ii ) );
+      ii += 4;
+    }
+
+  return GSL_MAX( hmax_avx2( _mm256_max_pd( d0, d1 ) ),
+		  dist_inf_scalar( nn - ii, X + ii, Y + ii ) );
+}
+
+/* Two passes instead of the rescaling of every element: the largest
+ * |X - Y| first, then the sum of squares scaled by its inverse, which
+ * is as safe from overflow and underflow and has no division in the
+ * loop */
+CONMIN_AVX2
+static double dist_avx2( const size_t nn, double *X, double *Y )
+{
+  double scale, ssq;
+  __m256d s0, s1, inv;
+  size_t ii;
+
+  if( nn < CONMIN_VECTOR_SHORT )
+    return dist_scalar( nn, X, Y );
+
+  /* 1/scale overflows for subnormal scales, those go the slow way */
+  scale = dist_inf_avx2( nn, X, Y );
+  if( scale == 0 || !gsl_finite( scale ) )
+    return scale;
+  if( scale < GSL_DBL_MIN )
+    return dist_scalar( nn, X, Y );
+
+  inv = _mm256_set1_pd( 1.0 / scale );
+  s0  = _mm256_setzero_pd( );
+  s1  = _mm256_setzero_pd( );
+  for( ii = 0; ii + 8 <= nn; ii += 8 )
+    {
+      __m256d x0 = _mm256_mul_pd( _mm256_sub_pd( _mm256_loadu_pd( X + ii ),
+						 _mm256_loadu_pd( Y + ii ) ), inv );
+      __m256d x1 = _mm256_mul_pd( _mm256_sub_pd( _mm256_loadu_pd( X + ii + 4 ),
+						 _mm256_loadu_pd( Y + ii + 4 ) ), inv );
+      s0 = _mm256_fmadd_pd( x0, x0, s0 );
+      s1 = _mm256_fmadd_pd( x1, x1, s1 );
+    }
+  s0 = _mm256_add_pd( s0, s1 );
+  {
+    __m128d s = _mm_add_pd( _mm256_castpd256_pd128( s0 ), _mm256_extractf128_pd( s0, 1 ) );
+    ssq = _mm_cvtsd_f64( s ) + _mm_cvtsd_f64( _mm_unpackhi_pd( s, s ) );
+  }
+  for( ; ii < nn; ii++ )
+    {
+      double x = ( X[ii] - Y[ii] ) / scale;
+      ssq += x * x;
+    }
+
+  return scale * sqrt( ssq );
+}
+
+CONMIN_AVX2
+static void axpy_project_avx2( const size_t nn, double *A, double *X,
+			       double alpha, double *D,
+			       double *L, double *U )
+{
+  __m256d a = _mm256_set1_pd( alpha );
+  size_t ii;
+
+  /* mul and add rounded separately like the scalar loop, no fma */
+  for( ii = 0; ii + 4 <= nn; ii += 4 )
+    {
+      __m256d xx = _mm256_add_pd( _mm256_loadu_pd( X + ii ),
+				  _mm256_mul_pd( a, _mm256_loadu_pd( D + ii ) ) );
+      xx = _mm256_min_pd( _mm256_loadu_pd( U + ii ), xx );
+      _mm256_storeu_pd( A + ii, _mm256_max_pd( _mm256_loadu_pd( L + ii ), xx ) );
+    }
+  axpy_project_scalar( nn - ii, A + ii, X + ii, alpha, D + ii, L + ii, U + ii );
+}
+
+CONMIN_AVX2
+static double projgrad_inf_avx2( const size_t nn, double *X, double *G,
+				 double *L, double *U )
+{
+  const __m256d sign = _mm256_set1_pd( -0.0 );
+  __m256d size = _mm256_setzero_pd( );
+  size_t ii;
+
+  for( ii = 0; ii + 4 <= nn; ii += 4 )
+    {
+      __m256d xx = _mm256_loadu_pd( X + ii );
+      __m256d pp = _mm256_sub_pd( xx, _mm256_loadu_pd( G + ii ) );
+      pp = _mm256_min_pd( _mm256_loadu_pd( U + ii ), pp );
+      pp = _mm256_max_pd( _mm256_loadu_pd( L + ii ), pp );
+      size = _mm256_max_pd( size, _mm256_andnot_pd( sign, _mm256_sub_pd( pp, xx ) ) );
+    }
+
+  return GSL_MAX( hmax_avx2( size ),
+		  projgrad_inf_scalar( nn - ii, X + ii, G + ii, L + ii, U + ii ) );
+}
+
+#endif /* CONMIN_VECTOR_X86 */
+
+/*----------------------------------------------------------------------------*/
+/* Dispatch                                                                   */
+/*----------------------------------------------------------------------------*/
+
+int conmin_vector_isa_supported( int isa )
+{
+#ifdef CONMIN_VECTOR_X86
+  if( isa == CONMIN_VECTOR_AVX2 )
+    return __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" );
+#endif
+  return isa == CONMIN_VECTOR_SCALAR;
+}
+
+static int vector_isa( void )
+{
+  if( conmin_vector_isa < 0 )
+    conmin_vector_isa = conmin_vector_isa_supported( CONMIN_VECTOR_AVX2 ) ?
+      CONMIN_VECTOR_AVX2 : CONMIN_VECTOR_SCALAR;
+  return conmin_vector_isa;
+}
+
+/* Select the variant, returns the previous one; an unsupported isa
+ * leaves the selection unchanged
+ *----------------------------------------------------------------------------*/
+int conmin_vector_set_isa( int isa )
+{
+  int previous = vector_isa( );
+
+  if( conmin_vector_isa_supported( isa ) )
+    conmin_vector_isa = isa;
+  return previous;
+}
+
+#ifdef CONMIN_VECTOR_X86
+#define CONMIN_DISPATCH( name, args )				\
+  ( vector_isa( ) == CONMIN_VECTOR_AVX2 ? name##_avx2 args	\
+					 : name##_scalar args )
+#else
+#define CONMIN_DISPATCH( name, args ) ( name##_scalar args )
+#endif
+
+/* A = max( B, min( C, D ) )
+ *----------------------------------------------------------------------------*/
+void conmin_vector_maxofmin( const size_t nn, 
+			     double *A, double *B,
+			     double *C, double *D )
+{
+  CONMIN_DISPATCH( maxofmin, ( nn, A, B, C, D ) );
+}
+
+/* A = min( B, max( C, D ) )
+ *----------------------------------------------------------------------------*/
+void conmin_vector_minofmax( const size_t nn, 
+			     double *A, double *B,
+			     double *C, double *D )
+{
+  CONMIN_DISPATCH( minofmax, ( nn, A, B, C, D ) );
+}
+
+/* Destine = Source, the C library copy is vectorized already
+ *----------------------------------------------------------------------------*/
+void conmin_vector_memcpy( const size_t nn, double *D, double *S )
+{
+  const size_t size = nn * sizeof( double );
+
+  memcpy( (void*)D, (void*)S, size );
+}
+
+/* X = v
+ *----------------------------------------------------------------------------*/
+void conmin_vector_set_all( const size_t nn, double *X, double vv )
+{
+  CONMIN_DISPATCH( set_all, ( nn, X, vv ) );
+}
+
+/* X = 0
+ *----------------------------------------------------------------------------*/
+void conmin_vector_set_zero( const size_t nn, double *X )
+{
+  /* This was formely done with memset, but that was wrong since the
+   * double zero must not be represent as zero bytes on any machine */
+  conmin_vector_set_all( nn, X, 0.0 );
+}
+
+/* dist = | X - Y |_2
+ *----------------------------------------------------------------------------*/
+double conmin_vector_dist( const size_t nn, double *X, double *Y )
+{
+  return CONMIN_DISPATCH( dist, ( nn, X, Y ) );
+}
+
+/* dist = | X - Y |_inf
+ *----------------------------------------------------------------------------*/
+double conmin_vector_dist_inf( const size_t nn, double *X, double *Y )
+{
+  return CONMIN_DISPATCH( dist_inf, ( nn, X, Y ) );
+}
+
+/* A = max( L, min( U, X + alpha*D ) ), the projected step in one pass,
+ * unused until spg.c and pgrad.c are rebuilt on it, see TODO
+ *----------------------------------------------------------------------------*/
+void conmin_vector_axpy_project( const size_t nn, double *A, double *X,
+				 double alpha, double *D,
+				 double *L, double *U )
+{
+  CONMIN_DISPATCH( axpy_project, ( nn, A, X, alpha, D, L, U ) );
+}
+
+/* size = | max( L, min( U, X - G ) ) - X |_inf, the projected gradient,
+ * unused like conmin_vector_axpy_project
+ *----------------------------------------------------------------------------*/
+double conmin_vector_projgrad_inf( const size_t nn, double *X, double *G,
+				   double *L, double *U )
+{
+  return CONMIN_DISPATCH( projgrad_inf, ( nn, X, G, L, U ) );
+}
+
 /*----------------------------------------------------------------------------*/
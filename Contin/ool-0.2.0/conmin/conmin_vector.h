@@ -68,6 +68,25 @@ double conmin_vector_dist( const size_t nn, double *X, double *Y );
 /* dist = | X - Y |_inf */
 double conmin_vector_dist_inf( const size_t nn, double *X, double *Y );
 
+/* Building blocks for the projected-gradient loops of spg.c and
+   pgrad.c. Those sources are not in this tree and nothing calls the
+   two functions below yet, see TODO. */
+
+/* A = max( L, min( U, X + alpha*D ) ), axpy and box projection fused */
+void conmin_vector_axpy_project( const size_t nn, double *A, double *X,
+				 double alpha, double *D,
+				 double *L, double *U );
+
+/* | max( L, min( U, X - G ) ) - X |_inf, sup norm of the projected gradient */
+double conmin_vector_projgrad_inf( const size_t nn, double *X, double *G,
+				   double *L, double *U );
+
+/* Variants of the primitives, chosen from the processor on first use */
+enum { CONMIN_VECTOR_SCALAR = 0, CONMIN_VECTOR_AVX2 = 1 };
+
+int conmin_vector_isa_supported( int isa );
+int conmin_vector_set_isa( int isa );
+
 /*----------------------------------------------------------------------------*/
 __END_DECLS
 
@@ -0,0 +1,128 @@
+/*----------------------------------------------------------------------------*
+ * Open Optimization Library - Constrained Minimization
+ *
+ * conmin/conmin_vector_bench.c
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * Times the conmin_vector primitives with the scalar loops against the
+ * variant chosen for the processor and checks that they agree. Not
+ * part of the library, build it by hand:
+ *
+ *   gcc -O2 -I. conmin_vector_bench.c conmin_vector.c -lgsl -lgslcblas -lm
+ *----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <gsl/gsl_math.h>
+#include <conmin_vector.h>
+
+#define BENCH_WORK 20000000	/* elements per timing */
+
+static double bench_seconds( void )
+{
+  return (double) clock( ) / CLOCKS_PER_SEC;
+}
+
+static double bench_uniform( void )
+{
+  return 2.0 * rand( ) / RAND_MAX - 1.0;
+}
+
+/* Calls the primitive op on vectors of size nn until BENCH_WORK
+ * elements are processed, returns nanoseconds per element; the result
+ * is left in A, the reductions in *res
+ *----------------------------------------------------------------------------*/
+static double bench_op( int op, size_t nn, double *A, double *X, double *D,
+			double *L, double *U, double *res )
+{
+  size_t reps = BENCH_WORK / nn + 1;
+  double sum = 0, t0, t1;
+  size_t rr;
+
+  t0 = bench_seconds( );
+  for( rr = 0; rr < reps; rr++ )
+    switch( op )
+      {
+      case 0: conmin_vector_maxofmin( nn, A, L, U, X );                 break;
+      case 1: conmin_vector_minofmax( nn, A, U, L, X );                 break;
+      case 2: conmin_vector_set_all( nn, A, 0.5 );                      break;
+      case 3: sum += conmin_vector_dist( nn, X, D );                    break;
+      case 4: sum += conmin_vector_dist_inf( nn, X, D );                break;
+      case 5: conmin_vector_axpy_project( nn, A, X, 0.25, D, L, U );    break;
+      case 6: sum += conmin_vector_projgrad_inf( nn, X, D, L, U );      break;
+      }
+  t1 = bench_seconds( );
+
+  *res = sum / reps;
+  return 1e9 * ( t1 - t0 ) / ( (double) reps * nn );
+}
+
+int main( void )
+{
+  static const char *name[] = { "maxofmin", "minofmax", "set_all", "dist",
+				"dist_inf", "axpy_project", "projgrad_inf" };
+  static const size_t sizes[] = { 7, 100, 1000, 100000 };
+  const size_t nmax = 100000;
+  double *X, *D, *L, *U, *A0, *A1;
+  size_t ii, kk;
+  int op;
+
+  X  = malloc( nmax * sizeof( double ) );
+  D  = malloc( nmax * sizeof( double ) );
+  L  = malloc( nmax * sizeof( double ) );
+  U  = malloc( nmax * sizeof( double ) );
+  A0 = malloc( nmax * sizeof( double ) );
+  A1 = malloc( nmax * sizeof( double ) );
+
+  srand( 1 );
+  for( ii = 0; ii < nmax; ii++ )
+    {
+      X[ii] = bench_uniform( );
+      D[ii] = bench_uniform( );
+      L[ii] = -0.5 + 0.1 * bench_uniform( );
+      U[ii] =  0.5 + 0.1 * bench_uniform( );
+    }
+
+  if( !conmin_vector_isa_supported( CONMIN_VECTOR_AVX2 ) )
+    printf( "AVX2 not available, both columns are the scalar loops\n" );
+
+  printf( "%-14s %8s %10s %10s %8s %10s\n",
+	  "primitive", "n", "scalar ns", "simd ns", "speedup", "max diff" );
+  for( op = 0; op < 7; op++ )
+    for( kk = 0; kk < sizeof( sizes ) / sizeof( sizes[0] ); kk++ )
+      {
+	size_t nn = sizes[kk];
+	double t0, t1, r0, r1, diff;
+
+	conmin_vector_set_isa( CONMIN_VECTOR_SCALAR );
+	t0 = bench_op( op, nn, A0, X, D, L, U, &r0 );
+	conmin_vector_set_isa( CONMIN_VECTOR_AVX2 );
+	t1 = bench_op( op, nn, A1, X, D, L, U, &r1 );
+
+	diff = fabs( r1 - r0 ) / GSL_MAX( fabs( r0 ), 1.0 );
+	if( op != 3 && op != 4 && op != 6 )
+	  for( ii = 0; ii < nn; ii++ )
+	    diff = GSL_MAX( diff, fabs( A1[ii] - A0[ii] ) );
+
+	printf( "%-14s %8lu %10.3f %10.3f %8.2f %10.2e\n", name[op],
+		(unsigned long) nn, t0, t1, t0 / t1, diff );
+      }
+
+  free( X ); free( D ); free( L ); free( U ); free( A0 ); free( A1 );
+  return 0;
+}